@@ -0,0 +1,60 @@
+//
+//  ASCII_Fonts_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "title/ASCII_Fonts.h"
+#include <cassert>
+
+namespace ascii_fonts
+{
+  
+  void test_compiled_font_layout()
+  {
+    using namespace t8x;
+    
+    FontData font_data;
+    font_data.font_chars['A'] = { { { "/\\", 0, 0, "I", "T", 0 }, { "--", 1, 0, "SH", "T2", 1 } }, 3 };
+    font_data.font_chars['B'] = { { { "|3", 0, 0, "DI", "T", 0 } }, 2 };
+    font_data.font_chars_by_prev_char[{ 'A', 'B' }] = { { { "]3", 0, 0, "DSV", "T", 0 } }, 4 };
+    font_data.kernings[{ 'A', 'B' }] = -1;
+    font_data.orderings[{ 'A', 'B' }] = { 0, 5 };
+    font_data.treat_lower_case_as_upper_case = true;
+    
+    auto compiled_fonts = compile_font_data({ { Font::Avatar, font_data } });
+    const auto& font = compiled_fonts.at(Font::Avatar);
+    assert(font.find_char(-1, 'A')->width == 3);
+    assert(font.find_char('A', 'B')->width == 4);
+    assert(font.find_char('B', 'B')->width == 2);
+    assert(font.find_char('A', 'C') == nullptr);
+    assert(font.get_kerning('A', 'B') == -1);
+    assert(font.get_kerning('B', 'A') == CompiledFont::c_no_kerning);
+    
+    TextLayoutCache cache;
+    // "aB" -> 'A' (width 3, kerning -1 + 2 custom), then contextual 'B' after 'A' (width 4).
+    const auto* layout = cache.get(compiled_fonts, Font::Avatar, "aB", { 2 });
+    assert(layout != nullptr);
+    assert(layout->width == 3 + 1 + 4);
+    assert(layout->pieces.size() == 3);
+    // Drawing order is by descending priority: ']3' has prio 5, '--' 1 and '/\' 0.
+    assert(layout->pieces[0].part == "]3");
+    assert(layout->pieces[0].c == 4);
+    assert(layout->pieces[0].fg == FontColorType::DSV);
+    assert(layout->pieces[1].part == "--");
+    assert(layout->pieces[1].bg == FontColorType::T2);
+    assert(layout->pieces[2].part == "/\\");
+    
+    assert(cache.get(compiled_fonts, Font::Avatar, "aB", { 2 }) == layout);
+    assert(cache.size() == 1);
+    assert(cache.get(compiled_fonts, Font::Larry3D, "aB") == nullptr);
+    assert(calc_text_width(cache, compiled_fonts, "BB", Font::Avatar) == 4);
+  }
+  
+  void unit_tests()
+  {
+    test_compiled_font_layout();
+  }
+}
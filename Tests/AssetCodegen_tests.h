@@ -0,0 +1,82 @@
+//
+//  AssetCodegen_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "sys/AssetCodegen.h"
+#include <cassert>
+#include <sstream>
+#include <string>
+
+namespace asset_codegen
+{
+  
+  void test_make_font_data()
+  {
+    using namespace t8x;
+    
+    static constexpr EmbeddedFontPiece pieces[] =
+    {
+      { "/\\", 0, 1, "I", "T", 0 },
+      { "\\/", 1, 0, "SH", "T", 1 },
+      { "|", 0, 0, "I", "T", 0 },
+    };
+    static constexpr EmbeddedFontChar chars[] =
+    {
+      { -1, 'A', 4, 0, 2 },
+      { 'A', 'A', 3, 2, 1 },
+    };
+    static constexpr EmbeddedFontKerning kernings[] = { { 'A', 'A', -1 } };
+    static constexpr EmbeddedFont embedded_font { chars, pieces, kernings, {}, true };
+    
+    auto font_data = make_font_data(embedded_font);
+    assert(font_data.font_chars.size() == 1);
+    const auto& fc = font_data.font_chars['A'];
+    assert(fc.width == 4);
+    assert(fc.font_pieces.size() == 2);
+    assert(fc.font_pieces[1].part == "\\/");
+    assert(fc.font_pieces[1].fg == "SH");
+    assert(fc.font_pieces[1].prio == 1);
+    assert((font_data.font_chars_by_prev_char[{ 'A', 'A' }].width == 3));
+    assert((font_data.kernings[{ 'A', 'A' }] == -1));
+    assert(font_data.orderings.empty());
+    assert(font_data.treat_lower_case_as_upper_case);
+  }
+  
+  void test_codegen_output()
+  {
+    using namespace t8;
+    
+    t8x::AssetCodegen codegen;
+    Texture tex { 1, 2 };
+    tex.set_textel_glyph(0, 1, Glyph { U'█', '#' });
+    tex.set_textel_fg_color(0, 1, Color16::Red);
+    assert(codegen.add_texture("block", tex));
+    assert(!codegen.add_texture("block", tex));
+    assert(!codegen.add_texture("2block", tex));
+    
+    t8x::FontData font_data;
+    font_data.font_chars['"'] = { { { "\"\x01", 0, 0, "I", "T", 0 } }, 2 };
+    codegen.add_font_data({ { t8x::Font::Avatar, font_data } });
+    
+    std::ostringstream oss;
+    codegen.write(oss, "test_assets");
+    const auto code = oss.str();
+    assert(code.find("namespace test_assets") != std::string::npos);
+    assert(code.find("inline constexpr uint32_t block_glyphs_preferred[] =\n  {\n    32, 9608, \n  };") != std::string::npos);
+    assert(code.find("inline const t8::TextureView block") != std::string::npos);
+    assert(code.find("{ -1, 34, 2, 0, 1 }") != std::string::npos);
+    assert(code.find("{ \"\\\"\\001\", 0, 0, \"I\", \"T\", 0 }") != std::string::npos);
+    assert(code.find("font_avatar_kernings") == std::string::npos);
+    assert(code.find("font_data[t8x::Font::Avatar] = t8x::make_font_data(font_avatar);") != std::string::npos);
+  }
+  
+  void unit_tests()
+  {
+    test_make_font_data();
+    test_codegen_output();
+  }
+}
@@ -0,0 +1,125 @@
+//
+//  AssetLoader_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "sys/AssetLoader.h"
+#include <cassert>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asset_loader
+{
+  
+  // Occupies the (single) worker until release() so that the following jobs stay queued.
+  struct WorkerGate
+  {
+    std::promise<void> started;
+    std::promise<void> released;
+    
+    void block(t8x::AsyncAssetLoader& loader)
+    {
+      auto released_future = released.get_future().share();
+      loader.submit<int>([this, released_future]() -> std::optional<int>
+      {
+        started.set_value();
+        released_future.wait();
+        return 0;
+      }, 1000);
+      started.get_future().wait();
+    }
+    
+    void release() { released.set_value(); }
+  };
+  
+  void unit_tests()
+  {
+    using namespace t8x;
+    
+    // Higher priority first, submission order within the same priority.
+    {
+      AsyncAssetLoader loader(1);
+      assert(loader.num_workers() == 1);
+      WorkerGate gate;
+      gate.block(loader);
+      
+      std::vector<std::string> order;
+      auto f_submit = [&](const std::string& name, int priority)
+      {
+        return loader.submit<std::string>([&order, name]() -> std::optional<std::string>
+        {
+          order.emplace_back(name);
+          return name;
+        }, priority);
+      };
+      f_submit("a0", 0);
+      f_submit("b5", 5);
+      f_submit("c0", 0);
+      f_submit("d5", 5);
+      auto fut_e = f_submit("e1", 1);
+      assert(!AsyncAssetLoader::is_ready(fut_e));
+      gate.release();
+      loader.wait_all();
+      assert((order == std::vector<std::string> { "b5", "d5", "e1", "a0", "c0" }));
+      assert(AsyncAssetLoader::is_ready(fut_e) && fut_e.get() == "e1");
+    }
+    
+    // Failed loads and counters.
+    {
+      AsyncAssetLoader loader(2);
+      assert(loader.is_done() && loader.get_progress() == 1.f);
+      auto fut_ok = loader.submit<int>([]() -> std::optional<int> { return 42; });
+      auto fut_fail = loader.submit<int>([]() -> std::optional<int> { return std::nullopt; });
+      auto fut_throw = loader.submit<int>([]() -> std::optional<int> { throw std::runtime_error("Expected test exception."); });
+      auto fut_throw_int = loader.submit<int>([]() -> std::optional<int> { throw 42; });
+      auto fut_tex = loader.load_texture("termin8or_no_such_texture.tx");
+      loader.wait_all();
+      assert(fut_ok.get() == 42);
+      assert(!fut_fail.get().has_value());
+      assert(!fut_throw.get().has_value());
+      assert(!fut_throw_int.get().has_value());
+      assert(!fut_tex.get().has_value());
+      assert(loader.num_submitted() == 5);
+      assert(loader.num_finished() == 5);
+      assert(loader.num_failed() == 4);
+      assert(loader.num_pending() == 0 && loader.is_done());
+      assert(loader.get_progress() == 1.f);
+    }
+    
+    // Destroying the loader drops the queued jobs, whose futures then throw broken_promise.
+    {
+      auto loader = std::make_unique<AsyncAssetLoader>(1);
+      WorkerGate gate;
+      gate.block(*loader);
+      bool ran = false;
+      auto fut_queued = loader->submit<int>([&ran]() -> std::optional<int> { ran = true; return 1; });
+      assert(loader->num_pending() == 2);
+      
+      std::thread destroyer([&loader] { loader.reset(); });
+      // Becomes ready as soon as the destructor has dropped the job.
+      fut_queued.wait();
+      gate.release();
+      destroyer.join();
+      
+      assert(!ran);
+      bool broken_promise = false;
+      try
+      {
+        fut_queued.get();
+      }
+      catch (const std::future_error& e)
+      {
+        broken_promise = e.code() == std::future_errc::broken_promise;
+      }
+      assert(broken_promise);
+    }
+  }
+
+}
@@ -0,0 +1,145 @@
+//
+//  CollisionHandler_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "physics/dynamics/CollisionHandler.h"
+#include <cassert>
+#include <cmath>
+#include <string>
+
+namespace collision_handler
+{
+  
+  using namespace t8x;
+  
+  constexpr int NR = 10;
+  constexpr int NC = 40;
+  
+  BitmapSprite* create_block(SpriteHandler& sprh, const std::string& name, const RC& size, const RC& pos)
+  {
+    auto* sprite = sprh.create_bitmap_sprite(name);
+    sprite->init(size.r, size.c);
+    sprite->create_frame(0);
+    sprite->fill_sprite_materials(0, 1);
+    sprite->pos = pos;
+    return sprite;
+  }
+  
+  void step(DynamicsSystem& dyn_sys, CollisionHandler& coll_handler, float dt)
+  {
+    dyn_sys.update(dt, dt, 1);
+    coll_handler.rebuild_BVH(NR, NC, &dyn_sys);
+    coll_handler.update();
+  }
+  
+  void test_swept_AABB_interval()
+  {
+    const AABB<float> aabb_A { 0.f, 0.f, 1.f, 1.f };
+    const AABB<float> aabb_B { 0.f, 5.f, 1.f, 1.f };
+    float t_enter = 0.f, t_exit = 1.f;
+    
+    // Enters when A:s right edge reaches column 5 and exits when its left edge passes column 6.
+    assert(CollisionHandler::calc_swept_AABB_interval(aabb_A, aabb_B, { 0.f, 10.f }, t_enter, t_exit));
+    assert(std::abs(t_enter - 0.4f) < 1e-5f);
+    assert(std::abs(t_exit - 0.6f) < 1e-5f);
+    
+    // Too short a step, moving away and passing beside B.
+    assert(!CollisionHandler::calc_swept_AABB_interval(aabb_A, aabb_B, { 0.f, 2.f }, t_enter, t_exit));
+    assert(!CollisionHandler::calc_swept_AABB_interval(aabb_A, aabb_B, { 0.f, -10.f }, t_enter, t_exit));
+    assert(!CollisionHandler::calc_swept_AABB_interval(aabb_A, aabb_B, { 3.f, 10.f }, t_enter, t_exit));
+    
+    // Already overlapping and not moving.
+    assert(CollisionHandler::calc_swept_AABB_interval(aabb_B, aabb_B, { 0.f, 0.f }, t_enter, t_exit));
+    assert(t_enter == 0.f && t_exit == 1.f);
+  }
+  
+  void test_rewind_to_toi()
+  {
+    SpriteHandler sprh;
+    auto* sprite = create_block(sprh, "body", { 1, 1 }, { 2, 5 });
+    RigidBody rb(sprite, 1.f, std::nullopt, { 0.f, 40.f });
+    rb.update(0.1f, 0.1f, 1);
+    const auto prev_cm = rb.get_prev_cm();
+    const auto curr_cm = rb.get_curr_cm();
+    assert(std::abs(curr_cm.c - prev_cm.c - 4.f) < 1e-4f);
+    
+    rb.rewind_to_toi(1.f);
+    assert(rb.get_curr_cm().c == curr_cm.c);
+    
+    rb.rewind_to_toi(0.5f);
+    assert(std::abs(rb.get_curr_cm().c - (prev_cm.c + 2.f)) < 1e-4f);
+    assert(rb.get_curr_cm().r == prev_cm.r);
+    assert(sprite->pos.c == 7);
+    assert(std::abs(rb.get_curr_AABB().c_min() - 7.f) < 1e-4f);
+  }
+  
+  void test_tunneling()
+  {
+    // A 3x3 body moving 20 columns per step passes a one-column wall unless it is a bullet.
+    const float dt = 0.1f;
+    for (bool bullet : { false, true })
+    {
+      SpriteHandler sprh;
+      DynamicsSystem dyn_sys;
+      CollisionHandler coll_handler;
+      auto* sprite = create_block(sprh, "bullet", { 3, 3 }, { 1, 5 });
+      auto* wall_sprite = create_block(sprh, "wall", { 5, 1 }, { 0, 20 });
+      auto* rb = dyn_sys.add_rigid_body(sprite, 1.f, std::nullopt, { 0.f, 200.f });
+      auto* rb_wall = dyn_sys.add_rigid_body(wall_sprite, 0.f);
+      rb->set_bullet(bullet);
+      
+      step(dyn_sys, coll_handler, dt);
+      assert(wall_sprite->pos == RC(0, 20));
+      assert(rb_wall->get_curr_cm().c == rb_wall->get_prev_cm().c);
+      if (bullet)
+      {
+        const auto& toi_data = coll_handler.get_toi_data();
+        assert(toi_data.size() == 1);
+        assert(toi_data[0].rb_bullet == rb && toi_data[0].rb_other == rb_wall);
+        assert(toi_data[0].toi > 0.f && toi_data[0].toi < 1.f);
+        assert(sprite->pos.c + 3 <= 21);
+        assert(rb->get_curr_lin_vel().c < 0.f);
+      }
+      else
+      {
+        assert(coll_handler.get_toi_data().empty());
+        assert(sprite->pos.c == 25);
+        assert(rb->get_curr_lin_vel().c == 200.f);
+      }
+    }
+  }
+  
+  void test_moving_other()
+  {
+    // Two bodies moving towards each other : Both are rewound to the TOI, not only the bullet.
+    const float dt = 0.1f;
+    SpriteHandler sprh;
+    DynamicsSystem dyn_sys;
+    CollisionHandler coll_handler;
+    auto* sprite_A = create_block(sprh, "bullet", { 3, 3 }, { 1, 5 });
+    auto* sprite_B = create_block(sprh, "other", { 3, 3 }, { 1, 30 });
+    auto* rb_A = dyn_sys.add_rigid_body(sprite_A, 1.f, std::nullopt, { 0.f, 200.f });
+    auto* rb_B = dyn_sys.add_rigid_body(sprite_B, 1.f, std::nullopt, { 0.f, -200.f });
+    rb_A->set_bullet(true);
+    
+    step(dyn_sys, coll_handler, dt);
+    assert(coll_handler.get_toi_data().size() == 1);
+    assert(sprite_A->pos.c < sprite_B->pos.c);
+    assert(sprite_B->pos.c > 10);
+    assert(rb_A->get_curr_lin_vel().c < 0.f);
+    assert(rb_B->get_curr_lin_vel().c > 0.f);
+  }
+  
+  void unit_tests()
+  {
+    test_swept_AABB_interval();
+    test_rewind_to_toi();
+    test_tunneling();
+    test_moving_other();
+  }
+
+}
@@ -96,5 +96,17 @@ namespace color
         assert(l_idx == i + 1);
       }
     }
+    
+    {
+      for (int col_idx = 0; col_idx <= c_max_color_idx; ++col_idx)
+      {
+        const auto& rgba = color2rgba.at(Color(col_idx));
+        assert(to_nearest_color_lut(rgba) == to_nearest_color(rgba));
+      }
+      assert(to_nearest_color_lut({ 0.9, 0.1, 0.1 }, PaletteSubset::Color16) == Color16::Red);
+      auto col_idx = to_nearest_color_lut({ 0.5, 0.5, 0.5 }, PaletteSubset::RGB6Gray24, ColorMetric::Perceptual).get_index();
+      assert(16 <= col_idx && col_idx <= 255);
+      assert(to_nearest_color16(RGB6(5, 0, 0)) == Color16::Red);
+    }
   }
 }
@@ -0,0 +1,76 @@
+//
+//  Compositor_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "screen/Compositor.h"
+#include <cassert>
+
+namespace compositor
+{
+  
+  void unit_tests()
+  {
+    using namespace t8;
+    
+    Compositor<10, 20> comp;
+    auto* map = comp.add_viewport<10, 20>({ 0, 0 }, 0);
+    auto* hud = comp.add_viewport<1, 20>({ 0, 0 }, 1, true);
+    auto* log = comp.add_viewport<3, 10>({ 7, 15 }, 2, true); // Partly off screen.
+    assert(comp.num_viewports() == 3);
+    
+    hud->draw().write_buffer("HP 10", 0, 0, Color16::White, Color16::Blue);
+    log->draw().write_buffer("Hello", 1, 0, Color16::Yellow);
+    
+    ScreenHandler<10, 20> sh;
+    sh.clear();
+    comp.begin_frame();
+    map->draw().write_buffer("#####", 0, 0, Color16::Green);
+    map->draw().write_buffer("#####", 8, 14, Color16::Green, Color16::DarkGray);
+    comp.draw(sh);
+    assert(comp.get_num_recomposed_cells() == 10*20);
+    
+    // The opaque HUD hides the map, the log text is drawn on top of the map background.
+    auto cell = comp.get_composed_cell(0, 1);
+    assert(cell.ch == 'P' && cell.fg == Color16::White && cell.bg == Color16::Blue);
+    cell = comp.get_composed_cell(8, 16);
+    assert(cell.ch == 'e' && cell.fg == Color16::Yellow && cell.bg == Color16::DarkGray);
+    cell = comp.get_composed_cell(8, 14);
+    assert(cell.ch == '#' && cell.fg == Color16::Green);
+    cell = comp.get_composed_cell(5, 5);
+    assert(cell.ch == ' ' && cell.bg == Color16::Transparent);
+    assert(sh.get_screen_buffer()[20*8 + 16].ch == 'e');
+    
+    // Only the non-retained map is recomposed.
+    comp.begin_frame();
+    comp.compose();
+    assert(comp.get_num_recomposed_cells() == 10*20);
+    
+    // Static frame with only retained viewports : Nothing to recompose.
+    comp.remove_viewport(map);
+    comp.compose();
+    comp.compose();
+    assert(comp.get_num_recomposed_cells() == 0);
+    assert(comp.get_composed_cell(8, 14).ch == ' ');
+    
+    hud->draw().clear();
+    hud->draw().write_buffer("HP  9", 0, 0, Color16::White, Color16::Blue);
+    comp.compose();
+    assert(comp.get_num_recomposed_cells() == 20);
+    assert(comp.get_composed_cell(0, 4).ch == '9');
+    
+    comp.set_visible(hud, false);
+    comp.compose();
+    assert(comp.get_num_recomposed_cells() == 20);
+    assert(comp.get_composed_cell(0, 4).ch == ' ');
+    
+    comp.set_position(log, { 0, 0 });
+    comp.compose();
+    assert(comp.get_num_recomposed_cells() == 3*5 + 3*10);
+    assert(comp.get_composed_cell(1, 0).ch == 'H');
+  }
+
+}
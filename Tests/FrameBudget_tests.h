@@ -0,0 +1,72 @@
+//
+//  FrameBudget_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "sys/FrameBudget.h"
+#include <cassert>
+#include <string>
+
+namespace frame_budget
+{
+  
+  void unit_tests()
+  {
+    using namespace t8x;
+    
+    FrameBudgetParams params;
+    params.budget_ms = 10.f;
+    params.degrade_after_frames = 3;
+    params.restore_after_frames = 5;
+    params.cooldown_frames = 2;
+    params.smoothing = 1.f;
+    FrameBudgetGovernor governor(params);
+    
+    int anim_level = 0;
+    int particle_level = 0;
+    int num_callbacks = 0;
+    // Added out of priority order on purpose.
+    const int anim_idx = governor.add_knob("anim_rate", 2, [&](int level) { anim_level = level; }, 30);
+    const int particle_idx = governor.add_knob("particles", 3, [&](int level) { particle_level = level; }, 0);
+    assert(governor.add_knob("bad", 1, [](int) {}) == -1);
+    assert(governor.num_knobs() == 2);
+    governor.set_adjustment_callback([&](const BudgetAdjustment&) { num_callbacks++; });
+    
+    int frame = 0;
+    auto f_run = [&](float frame_ms, int num_frames)
+    {
+      int num_adjustments = 0;
+      for (int i = 0; i < num_frames; ++i)
+        num_adjustments += governor.report_frame_time_ms(frame_ms, frame++) ? 1 : 0;
+      return num_adjustments;
+    };
+    
+    // Within budget, but not enough headroom to restore anything : Nothing happens.
+    assert(f_run(9.f, 100) == 0);
+    
+    // Over budget : Particles are degraded fully before the animation rate.
+    assert(f_run(20.f, 3) == 1);
+    assert(particle_level == 1 && anim_level == 0);
+    assert(governor.get_history().back().knob_name == "particles");
+    f_run(20.f, 100);
+    assert(particle_level == 2 && anim_level == 1);
+    assert(governor.num_degrades() == 3);
+    
+    // Headroom : Restored in the opposite order.
+    assert(f_run(2.f, 5) == 1);
+    assert(particle_level == 2 && anim_level == 0);
+    f_run(2.f, 100);
+    assert(particle_level == 0 && anim_level == 0);
+    assert(governor.num_restores() == 3 && num_callbacks == 6);
+    assert(governor.get_level(anim_idx) == 0 && governor.get_level(particle_idx) == 0);
+    
+    f_run(20.f, 3);
+    assert(particle_level == 1);
+    governor.reset(frame);
+    assert(particle_level == 0 && governor.get_history().back().level == 0);
+  }
+
+}
@@ -0,0 +1,49 @@
+//
+//  FrameScheduler_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "sys/FrameScheduler.h"
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+namespace frame_scheduler
+{
+  
+  void unit_tests()
+  {
+    using namespace t8x;
+    using Clock = FrameScheduler::Clock;
+    
+    {
+      FrameScheduler scheduler;
+      int num_frames = 0;
+      const auto t0 = Clock::now();
+      scheduler.run_loop(200.f, [&num_frames]() { return ++num_frames < 30; });
+      const auto elapsed = Clock::now() - t0;
+      // 29 waits of 5 ms against absolute deadlines. Only the lower bound holds on a loaded
+      //   machine, where frames may also overrun or resync.
+      assert(elapsed >= std::chrono::milliseconds(145));
+      auto stats = scheduler.get_jitter_stats();
+      assert(stats.p50_us >= 0.f && stats.p50_us <= stats.p99_us && stats.p99_us <= stats.max_us);
+    }
+    
+    {
+      // A frame that overruns by many periods restarts the schedule.
+      FrameSchedulerParams params;
+      params.max_frames_behind = 2;
+      FrameScheduler scheduler(params);
+      scheduler.start(200.f);
+      std::this_thread::sleep_for(std::chrono::milliseconds(40));
+      scheduler.wait_for_next_frame();
+      auto stats = scheduler.get_jitter_stats();
+      assert(stats.num_overruns == 1 && stats.num_resyncs == 1);
+      assert(scheduler.get_next_deadline() > Clock::now());
+    }
+  }
+
+}
@@ -7,6 +7,7 @@
 
 #pragma once
 #include "screen/GlyphString.h"
+#include "screen/ShapedText.h"
 #include <cassert>
 
 namespace glyph_string
@@ -47,5 +48,18 @@ namespace glyph_string
       hay.clear();
       assert(hay.empty());
     }
+    
+    {
+      ShapedText<char> st { std::vector<StyledString> { { "HP", { Color16::Red, Color16::Black }, 3 }, { "12", {}, 2 } } };
+      assert(st.width() == 5);
+      const auto& cells = st.get_cells();
+      const auto& cell_cols = st.get_cell_cols();
+      assert(cells.size() == 4);
+      assert(cells[1].ch == 'P' && cells[1].fg == Color16::Red && cells[1].bg == Color16::Black);
+      assert(cell_cols[2] == 3 && cells[2].ch == '1');
+      assert(st.assign("HP", Color16::Red));
+      assert(!st.assign("HP", Color16::Red));
+      assert(st.width() == 2 && st.get_cells().size() == 2);
+    }
   }
 }
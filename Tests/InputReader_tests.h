@@ -0,0 +1,170 @@
+//
+//  InputReader_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "input/InputReader.h"
+#include "input/KeyStateTracker.h"
+#include "input/Keyboard.h"
+#include <deque>
+#include <cassert>
+
+namespace input_reader
+{
+  
+  void unit_tests()
+  {
+    using namespace t8;
+    
+    {
+      SpscRing<int, 4> ring;
+      for (int i = 0; i < 4; ++i)
+        assert(ring.try_push(i));
+      assert(!ring.try_push(4));
+      int val = -1;
+      assert(ring.try_pop(val) && val == 0);
+      assert(ring.try_push(4));
+      assert(ring.size() == 4);
+      for (int i = 1; i <= 4; ++i)
+        assert(ring.try_pop(val) && val == i);
+      assert(!ring.try_pop(val));
+    }
+    
+    {
+      std::vector<KeyEvent> events;
+      auto f_emit = [&events](const KeyEvent& event) { events.emplace_back(event); };
+      auto t0 = KeyEventClock::now();
+      KeyByteDecoder decoder;
+      
+      // "ab", Up split over two reads, Enter, Left with modifier parameters.
+      const unsigned char part0[] = { 'a', 'b', 27, '[' };
+      const unsigned char part1[] = { 'A', 13, 27, '[', '1', ';', '5', 'D' };
+      decoder.feed(part0, 4, t0, f_emit);
+      assert(events.size() == 2 && decoder.has_pending());
+      decoder.feed(part1, 8, t0, f_emit);
+      assert(events.size() == 5);
+      assert(std::get<char>(events[0].key) == 'a');
+      assert(std::get<char>(events[1].key) == 'b');
+      assert(std::get<SpecialKey>(events[2].key) == SpecialKey::Up);
+      assert(std::get<SpecialKey>(events[3].key) == SpecialKey::Enter);
+      assert(std::get<SpecialKey>(events[4].key) == SpecialKey::Left);
+      
+      // A lone ESC is only reported after the timeout.
+      events.clear();
+      const unsigned char esc[] = { 27 };
+      decoder.feed(esc, 1, t0, f_emit);
+      decoder.flush(t0, f_emit);
+      assert(events.empty());
+      decoder.flush(t0 + KeyByteDecoder::c_escape_timeout, f_emit);
+      assert(events.size() == 1 && std::get<SpecialKey>(events[0].key) == SpecialKey::Escape);
+      assert(!decoder.has_pending());
+      
+      // SS3 F1, Delete, Ctrl + Left, Alt + 'x'.
+      events.clear();
+      const unsigned char keys[] = { 27, 'O', 'P', 27, '[', '3', '~', 27, '[', '1', ';', '5', 'D', 27, 'x' };
+      decoder.feed(keys, sizeof(keys), t0, f_emit);
+      assert(events.size() == 4);
+      assert(std::get<SpecialKey>(events[0].key) == SpecialKey::F1);
+      assert(std::get<SpecialKey>(events[1].key) == SpecialKey::Delete);
+      assert(std::get<SpecialKey>(events[2].key) == SpecialKey::Left);
+      assert(events[2].modifiers == static_cast<uint8_t>(KeyMod::Ctrl));
+      assert(std::get<char>(events[3].key) == 'x' && has_key_mod(events[3].modifiers, KeyMod::Alt));
+      
+      // SGR mouse press and bracketed paste.
+      events.clear();
+      const std::string mouse_paste = "\x1b[<0;10;5M\x1b[200~hi\x1b[Az\x1b[201~";
+      decoder.feed(reinterpret_cast<const unsigned char*>(mouse_paste.data()),
+                   static_cast<int>(mouse_paste.size()), t0, f_emit);
+      assert(events.size() == 2 && !decoder.has_pending());
+      assert(events[0].type == KeyEventType::Mouse);
+      assert(events[0].mouse.button == MouseButton::Left && events[0].mouse.action == MouseAction::Press);
+      assert(events[0].mouse.r == 4 && events[0].mouse.c == 9);
+      assert(events[1].type == KeyEventType::Paste && events[1].paste_text == "hi\x1b[Az");
+      
+      // Kitty keyboard protocol : Shift + 'a' (shifted key 'A'), repeat and release of Left.
+      events.clear();
+      const std::string kitty = "\x1b[97:65;2u\x1b[1;1:2D\x1b[1;1:3D\x1b[57441u\x1b[?15u";
+      decoder.feed(reinterpret_cast<const unsigned char*>(kitty.data()),
+                   static_cast<int>(kitty.size()), t0, f_emit);
+      assert(events.size() == 3);
+      assert(std::get<char>(events[0].key) == 'A' && events[0].action == KeyAction::Press);
+      assert(std::get<SpecialKey>(events[1].key) == SpecialKey::Left && events[1].action == KeyAction::Repeat);
+      assert(std::get<SpecialKey>(events[2].key) == SpecialKey::Left && events[2].action == KeyAction::Release);
+    }
+    
+    {
+      // The polling path of StreamKeyboard : Releases and repeats are handed out as frame
+      //   events but never become the transient key.
+      std::deque<KeyEvent> pending;
+      auto f_push = [&pending](const KeyEvent& event) { pending.push_back(event); };
+      auto t0 = KeyEventClock::now();
+      KeyByteDecoder decoder;
+      std::vector<KeyEvent> frame_events;
+      
+      const std::string release_only = "\x1b[97;1:3u";
+      decoder.feed(reinterpret_cast<const unsigned char*>(release_only.data()),
+                   static_cast<int>(release_only.size()), t0, f_push);
+      assert(!keyboard::take_events_until_press(pending, frame_events).has_value());
+      assert(frame_events.size() == 1 && frame_events[0].action == KeyAction::Release);
+      assert(!keyboard::find_first_press(frame_events).has_value());
+      
+      frame_events.clear();
+      const std::string repeat_press_release = "\x1b[97;1:2ux\x1b[120;1:3u";
+      decoder.feed(reinterpret_cast<const unsigned char*>(repeat_press_release.data()),
+                   static_cast<int>(repeat_press_release.size()), t0, f_push);
+      auto kpd = keyboard::take_events_until_press(pending, frame_events);
+      assert(get_char_key(kpd) == 'x');
+      assert(frame_events.size() == 2 && frame_events[0].action == KeyAction::Repeat);
+      assert(get_char_key(keyboard::find_first_press(frame_events)) == 'x');
+      assert(pending.size() == 1 && pending.front().action == KeyAction::Release);
+      
+      frame_events.clear();
+      assert(!keyboard::take_events_until_press(pending, frame_events).has_value());
+      assert(frame_events.size() == 1 && pending.empty());
+    }
+    
+    {
+      using namespace std::chrono_literals;
+      auto t0 = KeyEventClock::now();
+      KeyStateTracker tracker;
+      auto f_key = [](std::variant<SpecialKey, char> key, KeyEventClock::time_point time, KeyAction action = KeyAction::Press)
+      {
+        KeyEvent event;
+        event.key = key;
+        event.time = time;
+        event.action = action;
+        return event;
+      };
+      
+      // Legacy auto-repeat : Down after a press, kept down by the repeats, up once they stop.
+      tracker.update(f_key('w', t0));
+      tracker.advance(t0 + 10ms);
+      assert(tracker.is_down('w') && !tracker.is_down('s'));
+      for (int i = 0; i < 10; ++i)
+        tracker.update(f_key('w', t0 + 400ms + i*30ms));
+      tracker.advance(t0 + 400ms + 9*30ms + 40ms);
+      assert(tracker.is_down('w'));
+      assert(tracker.get_held_keys().test(KeyStateTracker::key_index('w')));
+      assert(tracker.get_repeat_interval() < 33ms && tracker.get_repeat_delay() < 500ms);
+      tracker.advance(t0 + 400ms + 9*30ms + 200ms);
+      assert(!tracker.is_down('w') && !tracker.any_down());
+      
+      // With release events, keys stay down until released.
+      tracker.update(f_key(SpecialKey::Up, t0 + 1ms, KeyAction::Release));
+      assert(tracker.has_release_events());
+      tracker.update(f_key(SpecialKey::Up, t0 + 2ms));
+      tracker.update(f_key('d', t0 + 3ms));
+      tracker.advance(t0 + 500ms);
+      assert(tracker.is_down(SpecialKey::Up) && tracker.is_down('d'));
+      assert(std::get<char>(tracker.get_newest_held()) == 'd');
+      tracker.update(f_key('d', t0 + 4ms, KeyAction::Release));
+      tracker.advance(t0 + 501ms);
+      assert(!tracker.is_down('d'));
+      assert(std::get<SpecialKey>(tracker.get_newest_held()) == SpecialKey::Up);
+    }
+  }
+  
+}
@@ -0,0 +1,209 @@
+//
+//  Logging_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "sys/Logging.h"
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace logging
+{
+  
+  void unit_tests()
+  {
+    using namespace t8;
+    using namespace t8x;
+    
+    {
+      std::string buf;
+      replay_bin::write_varint(buf, 0);
+      replay_bin::write_varint(buf, 127);
+      replay_bin::write_varint(buf, 128);
+      replay_bin::write_varint(buf, 4'000'000'000u);
+      assert(buf.size() == 1 + 1 + 2 + 5);
+      std::vector<uint8_t> data(buf.begin(), buf.end());
+      size_t pos = 0;
+      uint64_t val = 0;
+      assert(replay_bin::read_varint(data, pos, val) && val == 0);
+      assert(replay_bin::read_varint(data, pos, val) && val == 127);
+      assert(replay_bin::read_varint(data, pos, val) && val == 128);
+      assert(replay_bin::read_varint(data, pos, val) && val == 4'000'000'000u);
+      assert(pos == data.size() && !replay_bin::read_varint(data, pos, val));
+      
+      assert(replay_bin::encode_key(std::nullopt) == 0);
+      assert(get_char_key(replay_bin::decode_key(replay_bin::encode_key('q'))) == 'q');
+      assert(get_special_key(replay_bin::decode_key(replay_bin::encode_key(SpecialKey::F12))) == SpecialKey::F12);
+    }
+    
+    {
+      const auto path = (std::filesystem::temp_directory_path() /
+                         "termin8or_binary_log_test.bin").string();
+      const int num_frames = 100'000;
+      auto f_key = [](int frame) -> KeyPressDataPair
+      {
+        if (frame % 250 == 3)
+          return { 'a', 'a' };
+        if (frame % 1000 == 7)
+          return { SpecialKey::Left, SpecialKey::Left };
+        return { std::nullopt, std::nullopt };
+      };
+      
+      {
+        BinaryLogWriter writer;
+        assert(writer.open(path, 12345u));
+        for (int frame = 0; frame < num_frames; ++frame)
+          writer.write_frame(frame, f_key(frame));
+      }
+      assert(std::filesystem::file_size(path) < 2'000);
+      
+      BinaryLogReader reader;
+      unsigned int seed = 0;
+      assert(BinaryLogReader::is_binary_log(path));
+      assert(reader.open(path, seed) && seed == 12345u);
+      KeyPressDataPair kpdp;
+      for (int frame = 0; frame < num_frames; ++frame)
+      {
+        assert(reader.read_frame(frame, kpdp));
+        auto expected = f_key(frame);
+        assert(get_char_key(kpdp.transient) == get_char_key(expected.transient));
+        assert(get_special_key(kpdp.held) == get_special_key(expected.held));
+      }
+      assert(!reader.read_frame(num_frames, kpdp));
+      
+      reader.seek(1003);
+      assert(reader.read_frame(1003, kpdp) && get_char_key(kpdp.transient) == 'a');
+      assert(reader.read_frame(1004, kpdp) && get_char_key(kpdp.transient) == 0);
+      reader.seek(7);
+      assert(reader.read_frame(7, kpdp) && get_special_key(kpdp.held) == SpecialKey::Left);
+      std::remove(path.c_str());
+    }
+    
+    // Held keys and frame events.
+    {
+      const auto path = (std::filesystem::temp_directory_path() /
+                         "termin8or_binary_log_input_test.bin").string();
+      const int idx_w = KeyStateTracker::key_index('w');
+      const int idx_up = KeyStateTracker::key_index(SpecialKey::Up);
+      KeyEvent ev_key;
+      ev_key.key = 'w';
+      ev_key.modifiers = static_cast<uint8_t>(KeyMod::Shift);
+      ev_key.action = KeyAction::Release;
+      KeyEvent ev_mouse;
+      ev_mouse.type = KeyEventType::Mouse;
+      ev_mouse.mouse = { MouseButton::Left, MouseAction::Move, 12, 345 };
+      KeyEvent ev_paste;
+      ev_paste.type = KeyEventType::Paste;
+      ev_paste.paste_text = "hi there\n";
+      auto f_input = [&](int frame)
+      {
+        FrameInput fi;
+        fi.held_keys.set(idx_w, frame >= 10 && frame < 20);
+        fi.held_keys.set(idx_up, frame >= 15);
+        if (frame == 20)
+          fi.events = { ev_key, ev_mouse };
+        if (frame == 30)
+          fi.events = { ev_paste };
+        return fi;
+      };
+      auto f_same_event = [](const KeyEvent& evA, const KeyEvent& evB)
+      {
+        return evA.type == evB.type && evA.key == evB.key && evA.modifiers == evB.modifiers
+          && evA.action == evB.action && evA.mouse.button == evB.mouse.button
+          && evA.mouse.action == evB.mouse.action && evA.mouse.r == evB.mouse.r
+          && evA.mouse.c == evB.mouse.c && evA.paste_text == evB.paste_text;
+      };
+      const int num_frames = 40;
+      
+      {
+        BinaryLogWriter writer;
+        assert(writer.open(path, 7u));
+        for (int frame = 0; frame < num_frames; ++frame)
+        {
+          auto fi = f_input(frame);
+          writer.write_frame(frame, {}, &fi);
+        }
+      }
+      
+      BinaryLogReader reader;
+      unsigned int seed = 0;
+      assert(reader.open(path, seed) && seed == 7u);
+      KeyPressDataPair kpdp;
+      FrameInput fi;
+      for (int frame = 0; frame < num_frames; ++frame)
+      {
+        assert(reader.read_frame(frame, kpdp, &fi));
+        auto expected = f_input(frame);
+        assert(fi.held_keys == expected.held_keys);
+        assert(fi.events.size() == expected.events.size());
+        for (size_t ev_idx = 0; ev_idx < fi.events.size(); ++ev_idx)
+          assert(f_same_event(fi.events[ev_idx], expected.events[ev_idx]));
+      }
+      assert(!reader.read_frame(num_frames, kpdp, &fi));
+      
+      reader.seek(17);
+      assert(reader.read_frame(17, kpdp, &fi) && fi.held_keys.test(idx_w) && fi.held_keys.test(idx_up));
+      reader.seek(25);
+      assert(reader.read_frame(25, kpdp, &fi) && !fi.held_keys.test(idx_w) && fi.held_keys.test(idx_up));
+      std::remove(path.c_str());
+      
+      // Version 1 logs (unshifted frame delta, no FrameInput) still replay.
+      {
+        std::string buf(std::begin(replay_bin::c_magic), std::end(replay_bin::c_magic));
+        buf += static_cast<char>(1);
+        replay_bin::write_varint(buf, 99u);
+        replay_bin::write_varint(buf, 5);
+        buf += static_cast<char>(replay_bin::encode_key('q'));
+        buf += static_cast<char>(replay_bin::encode_key('q'));
+        replay_bin::write_varint(buf, 3);
+        buf += static_cast<char>(replay_bin::c_code_end);
+        std::ofstream fout(path, std::ios::binary);
+        fout.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+      }
+      assert(reader.open(path, seed) && seed == 99u);
+      for (int frame = 0; frame < 8; ++frame)
+      {
+        assert(reader.read_frame(frame, kpdp, &fi));
+        assert(get_char_key(kpdp.transient) == (frame == 5 ? 'q' : 0));
+        assert(fi.held_keys.none() && fi.events.empty());
+      }
+      assert(!reader.read_frame(8, kpdp, &fi));
+      std::remove(path.c_str());
+      
+      // Text logs.
+      std::stringstream ss;
+      KeyStateTracker::KeyBits rec_held, rep_held;
+      for (int frame = 0; frame < num_frames; ++frame)
+      {
+        ss << frame << " -- --";
+        replay_text::write_frame_input(ss, f_input(frame), rec_held);
+        ss << '\n';
+      }
+      std::string line;
+      for (int frame = 0; frame < num_frames; ++frame)
+      {
+        assert(std::getline(ss, line));
+        std::istringstream iss(line);
+        std::string token;
+        iss >> token >> token >> token;
+        std::vector<KeyEvent> events;
+        assert(replay_text::read_frame_input(iss, rep_held, &events));
+        auto expected = f_input(frame);
+        assert(rep_held == expected.held_keys);
+        assert(events.size() == expected.events.size());
+        for (size_t ev_idx = 0; ev_idx < events.size(); ++ev_idx)
+          assert(f_same_event(events[ev_idx], expected.events[ev_idx]));
+      }
+      std::istringstream iss_old("");
+      assert(replay_text::read_frame_input(iss_old, rep_held, nullptr));
+    }
+  }
+
+}
@@ -0,0 +1,279 @@
+//
+//  ParticleSystem_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "physics/ParticleSystem.h"
+#include "physics/ParticleManager.h"
+#include "sys/FrameBudget.h"
+#include <cassert>
+
+namespace particle_system
+{
+
+  void test_particle_rand()
+  {
+    using namespace t8x;
+    
+    ParticleRand rng_A { 1234 };
+    ParticleRand rng_B { 1234 };
+    std::vector<float> batch(1000);
+    rng_A.fill(batch.data(), batch.size());
+    for (auto val : batch)
+    {
+      assert(0.f <= val && val < 1.f);
+      assert(val == rng_B.next_float());
+    }
+    
+    ParticleRand rng_zero { 0 };
+    assert(rng_zero.next_u32() != 0);
+    
+    // Counter-based: value n only depends on the key and n.
+    t8::RandStream rs_A { 42, t8::RandSystem::Particles, 3, 7 };
+    t8::RandStream rs_B { 42, t8::RandSystem::Particles, 3, 7 };
+    t8::RandStream rs_C { 42, t8::RandSystem::Particles, 4, 7 };
+    rs_B.set_counter(5);
+    auto val5 = rs_B.next_u64();
+    for (int i = 0; i < 5; ++i)
+      rs_A.next_u64();
+    assert(rs_A.next_u64() == val5);
+    assert(rs_C.split(1).next_u64() != rs_C.split(2).next_u64());
+    assert(t8::RandStream::at(rs_A.get_key(), 0) != t8::RandStream::at(rs_C.get_key(), 0));
+    for (int i = 0; i < 100; ++i)
+    {
+      auto val = rs_C.next_int(-2, 3);
+      assert(-2 <= val && val <= 3);
+    }
+    std::vector<std::pair<float, int>> weighted { { 0.f, 1 }, { 1.f, 2 } };
+    assert(rs_C.select(weighted) == 2);
+    
+    // Handlers don't draw from the global rnd and take the session seed on their first update.
+    rnd::srand(5);
+    const auto rnd_val = rnd::rand();
+    rnd::srand(5);
+    ParticleHandler ph_A(20);
+    ParticleHandlerSoA ph_soa(20);
+    ParticleManager<> pm(20);
+    assert(rnd::rand() == rnd_val);
+    auto ph_B = ph_A;
+    auto ph_C = ph_A;
+    auto f_spawn = [](ParticleHandler& ph, uint64_t session_seed)
+    {
+      t8::session_rand_seed = session_seed;
+      ph.update({ 10, 10 }, true, 1.f, 1.f, 0.f, 5.f, 1.f, 20, 0.01f, 10.f);
+      return ph.particle_stream;
+    };
+    const auto particles_A = f_spawn(ph_A, 111);
+    const auto particles_B = f_spawn(ph_B, 111);
+    const auto particles_C = f_spawn(ph_C, 222);
+    assert(particles_A[0].vel_r == particles_B[0].vel_r && particles_A[0].vel_c == particles_B[0].vel_c);
+    assert(particles_A[0].vel_r != particles_C[0].vel_r || particles_A[0].vel_c != particles_C[0].vel_c);
+    t8::session_rand_seed = 0;
+  }
+  
+  void test_particle_stream_soa()
+  {
+    using namespace t8x;
+    
+    ParticleRand rng;
+    ParticleStreamSoA ps { 8 };
+    assert(ps.capacity() == 8);
+    assert(ps.empty());
+    
+    assert(ps.spawn(3, rng, 0.f, { 10, 20 }, 0.f, 1.f, 0.f, 0.f, 1.f) == 3);
+    assert(ps.spawn(3, rng, 0.5f, { 10, 20 }, 0.f, 1.f, 0.f, 0.f, 1.f) == 3);
+    assert(ps.size() == 6);
+    // Only two free slots left.
+    assert(ps.spawn(3, rng, 0.5f, { 10, 20 }, 0.f, 1.f, 0.f, 0.f, 1.f) == 2);
+    assert(ps.size() == 8);
+    
+    ps.integrate(0.5f);
+    for (size_t idx = 0; idx < ps.size(); ++idx)
+    {
+      assert(ps.pos_c[idx] == 20.5f);
+      assert(ps.pos_r[idx] == 10.f);
+    }
+    
+    // First three expire at t = 1.
+    ps.cull(1.f);
+    assert(ps.size() == 5);
+    for (size_t idx = 0; idx < ps.size(); ++idx)
+      assert(ps.time_stamp[idx] == 0.5f);
+    
+    ps.kill(0);
+    assert(ps.size() == 4);
+    ps.kill(10);
+    assert(ps.size() == 4);
+    
+    ps.set_max_alive(2);
+    assert(ps.size() == 2);
+    assert(ps.spawn(1, rng, 0.5f, { 0, 0 }, 0.f, 0.f, 0.f, 0.f, 1.f) == 0);
+    
+    ps.cull(2.f);
+    assert(ps.empty());
+  }
+
+  void test_particle_splatter()
+  {
+    using namespace t8x;
+    
+    ParticleSplatter<4, 6> splatter;
+    splatter.set_density_strings({ ".", ":", "#" }, 4);
+    splatter.add(1.2f, 2.4f, 0.8f);
+    splatter.add(0.9f, 1.6f, 0.3f);
+    splatter.add(1.f, 2.f, 0.5f);
+    splatter.add(-1.f, 2.f, 0.1f); // Off-screen.
+    splatter.add(3.f, 6.f, 0.1f); // Off-screen.
+    splatter.add(3.f, 5.f, 0.9f);
+    assert(splatter.num_touched_cells() == 2);
+    assert(splatter.get_count(1, 2) == 3);
+    assert(splatter.get_youngest_t(1, 2) == 0.3f);
+    assert(splatter.get_density(1, 2) == 0.75f);
+    assert(splatter.get_count(3, 5) == 1);
+    
+    splatter.clear();
+    assert(splatter.num_touched_cells() == 0);
+    assert(splatter.get_count(1, 2) == 0);
+    assert(splatter.get_youngest_t(1, 2) == 1.f);
+  }
+
+  void test_baked_gradient()
+  {
+    using namespace t8;
+    using namespace t8x;
+    
+    Gradient<Color> grad { { Color16::Red, Color16::Yellow, Color16::Green, Color16::Blue } };
+    BakedGradient<Color> baked = grad;
+    assert(baked.lut_size() == 256);
+    // Nearest baking is exact at the bucket centers. Elsewhere it may differ by one bucket
+    //   from the Gradient near the midpoints between stops.
+    for (int i = 0; i < baked.lut_size(); ++i)
+    {
+      float t = (i + 0.5f) / baked.lut_size();
+      assert(baked(t) == grad(t));
+    }
+    assert(baked(1.f) == Color(Color16::Blue));
+    
+    // ParticleGradientGroup uses Gradient by default and BakedGradient on request.
+    const Gradient<std::string> grad_str { std::vector<std::string> { "*", "." } };
+    ParticleGradientGroup<> group { grad, grad, grad_str };
+    ParticleGradientGroup<std::string, BakedGradient> baked_group { grad, grad, grad_str };
+    assert(group.fg_color_gradient.gradient.size() == 4);
+    assert(baked_group.fg_color_gradient(0.9f) == Color(Color16::Blue));
+    assert(baked_group.string_gradient(0.1f) == "*");
+    
+    BakedGradient<Color> baked_empty;
+    assert(baked_empty(0.5f) == Color {});
+    
+    Gradient<RGBA> grad_rgba { { { 0.25f, RGBA { 0, 0, 0 } }, { 0.75f, RGBA { 1, 1, 1 } } } };
+    BakedGradient<RGBA> baked_rgba { grad_rgba, GradientBakeMode::Interpolated, 4 };
+    assert(baked_rgba(0.f).r == 0.);
+    assert(std::abs(baked_rgba(0.4f).g - 0.25) < 1e-6);
+    assert(std::abs(baked_rgba(0.6f).b - 0.75) < 1e-6);
+    assert(baked_rgba(1.f).r == 1.);
+  }
+
+  void test_particle_manager()
+  {
+    using namespace t8x;
+    
+    ParticleManager<> pm { 10 };
+    ParticleEmitter<> params;
+    params.cluster_size = 3;
+    params.life_time = 10.f;
+    params.budget = 6;
+    params.trigger = true;
+    auto* emitter_lo = pm.add_emitter(params);
+    params.priority = 1;
+    params.budget = 8;
+    auto* emitter_hi = pm.add_emitter(params);
+    assert(pm.num_emitters() == 2);
+    
+    pm.update(0.01f, 0.f);
+    assert(pm.num_alive(emitter_hi) == 4);
+    assert(pm.num_alive(emitter_lo) == 4);
+    pm.update(0.01f, 0.01f);
+    assert(pm.num_alive(emitter_hi) == 6); // Pool full.
+    assert(pm.num_alive(emitter_lo) == 4);
+    assert(pm.num_alive() == 10 && pm.pool_capacity() == 10);
+    
+    pm.remove_emitter(emitter_hi);
+    assert(pm.num_emitters() == 1);
+    assert(pm.num_alive() == 4);
+    pm.update(0.01f, 0.02f);
+    assert(pm.num_alive(emitter_lo) == 6); // Budget reached.
+    pm.update(0.01f, 0.03f);
+    assert(pm.num_alive(emitter_lo) == 6);
+    
+    // Off-screen emitters don't spawn.
+    pm.clear_particles();
+    pm.set_cull_region({ 0, 0, 20, 40 });
+    emitter_lo->pos = { 30, 10 };
+    pm.update(0.01f, 0.04f);
+    assert(pm.num_alive() == 0);
+    
+    pm.set_frame_time_budget_ms(10.f);
+    pm.report_frame_time_ms(20.f);
+    assert(pm.get_lod() < 1.f);
+    pm.set_frame_time_budget_ms(0.f);
+    pm.report_frame_time_ms(20.f);
+    assert(pm.get_lod() == 1.f);
+  }
+
+  void test_num_active_particles()
+  {
+    using namespace t8x;
+    
+    // Same levels as GameEngine::add_particle_budget_knob().
+    ParticleHandler ph(100);
+    FrameBudgetParams params;
+    params.budget_ms = 10.f;
+    params.degrade_after_frames = 1;
+    params.restore_after_frames = 1;
+    params.cooldown_frames = 0;
+    params.smoothing = 1.f;
+    FrameBudgetGovernor governor(params);
+    governor.add_knob("particles", 4, [&ph](int level)
+    {
+      ph.set_num_active_particles(1.f - 0.25f * static_cast<float>(level));
+    });
+    auto f_num_dead = [&ph]()
+    {
+      return std::count_if(ph.particle_stream.begin(), ph.particle_stream.end(),
+                           [](const auto& particle) { return particle.dead; });
+    };
+    auto f_spawn_all = [&ph](float time)
+    {
+      ph.update({ 10, 10 }, true, 0.f, 0.f, 0.f, 1.f, 1.f, 200, 0.01f, time);
+      return std::count_if(ph.particle_stream.begin(), ph.particle_stream.end(),
+                           [time](const auto& particle) { return !particle.dead && particle.alive(time); });
+    };
+    
+    int frame = 0;
+    for (int i = 0; i < 3; ++i)
+      governor.report_frame_time_ms(20.f, frame++);
+    assert(governor.get_level(0) == 3);
+    assert(f_num_dead() == 75);
+    assert(f_spawn_all(0.f) == 25);
+    
+    for (int i = 0; i < 3; ++i)
+      governor.report_frame_time_ms(1.f, frame++);
+    assert(governor.get_level(0) == 0);
+    assert(f_num_dead() == 0);
+    assert(f_spawn_all(5.f) == 100);
+  }
+
+  void unit_tests()
+  {
+    test_particle_rand();
+    test_particle_stream_soa();
+    test_particle_splatter();
+    test_baked_gradient();
+    test_particle_manager();
+    test_num_active_particles();
+  }
+
+}
@@ -0,0 +1,85 @@
+//
+//  Profiler_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "sys/Profiler.h"
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace profiling
+{
+  
+  void unit_tests()
+  {
+    using namespace t8;
+    using Clock = Profiler::Clock;
+    
+    {
+      Profiler prof(100);
+      prof.begin_frame(0);
+      prof.add_zone(ProfileZone::Update, Clock::now(), Clock::now());
+      prof.end_frame();
+      assert(prof.num_frames() == 0); // Disabled.
+      
+      {
+        ProfileScope scope(ProfileZone::Update, prof);
+      }
+      assert(prof.num_frames() == 0);
+    }
+    
+    {
+      Profiler prof(100);
+      prof.set_enabled(true);
+      // Update takes 1 ms per frame, except for two 10 ms spikes. Frames 0-49 are evicted.
+      for (int frame = 0; frame < 150; ++frame)
+      {
+        prof.begin_frame(frame);
+        const auto t0 = Clock::now();
+        const int dur_ms = (frame == 120 || frame == 140) ? 10 : 1;
+        prof.add_zone(ProfileZone::Update, t0, t0 + std::chrono::milliseconds(dur_ms));
+        prof.add_zone(ProfileZone::TermWrite, t0, t0 + std::chrono::microseconds(500));
+        prof.add_zone(ProfileZone::TermWrite, t0, t0 + std::chrono::microseconds(500));
+        prof.end_frame();
+      }
+      assert(prof.num_frames() == 100);
+      
+      auto stats = prof.get_zone_stats(ProfileZone::Update);
+      assert(std::abs(stats.p50_ms - 1.f) < 1e-3f);
+      assert(std::abs(stats.p95_ms - 1.f) < 1e-3f);
+      assert(std::abs(stats.p99_ms - 10.f) < 1e-3f);
+      assert(std::abs(stats.max_ms - 10.f) < 1e-3f);
+      assert(std::abs(stats.avg_ms - 1.18f) < 1e-3f);
+      assert(stats.num_spikes == 2);
+      
+      stats = prof.get_zone_stats(ProfileZone::TermWrite);
+      assert(std::abs(stats.p50_ms - 1.f) < 1e-3f && stats.num_spikes == 0);
+      stats = prof.get_zone_stats(ProfileZone::Physics);
+      assert(stats.max_ms == 0.f && stats.num_spikes == 0);
+      
+      auto lines = prof.get_overlay_lines();
+      assert(static_cast<int>(lines.size()) == c_num_profile_zones + 2);
+      assert(lines[1 + static_cast<int>(ProfileZone::Update)].find("Update") == 0);
+      
+      const auto path = (std::filesystem::temp_directory_path() /
+                         "termin8or_profiler_test.json").string();
+      assert(prof.write_chrome_trace(path));
+      std::ifstream fin(path);
+      std::stringstream ss;
+      ss << fin.rdbuf();
+      const auto json = ss.str();
+      assert(json.find("\"traceEvents\"") != std::string::npos);
+      assert(json.find("\"frame\":50}") != std::string::npos);
+      assert(json.find("\"frame\":49}") == std::string::npos);
+      std::remove(path.c_str());
+    }
+  }
+
+}
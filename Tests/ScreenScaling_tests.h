@@ -0,0 +1,90 @@
+//
+//  ScreenScaling_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "screen/ScreenScaling.h"
+#include <cassert>
+#include <memory>
+
+namespace screen_scaling
+{
+  
+  template<int NR, int NC>
+  void fill_pattern(t8::ScreenHandler<NR, NC>& sh, bool uniform)
+  {
+    using namespace t8;
+    // Chars whose shading value maps back to the same char, so that resample() keeps them
+    //   where the filter weights are exactly 0 and 1.
+    const std::string chars = "$=(\\:_";
+    const std::array<Color, 6> colors { Color16::Red, Color16::Green, Color16::Blue,
+                                        Color16::Yellow, Color16::White, Color16::Black };
+    sh.clear();
+    for (int r = 0; r < NR; ++r)
+      for (int c = 0; c < NC; ++c)
+      {
+        if (uniform)
+          sh.write_buffer("$", r, c, Color16::Red, Color16::Blue);
+        else
+          sh.write_buffer(std::string(1, chars[(r*3 + c) % chars.size()]), r, c,
+                          colors[(r + c) % colors.size()], colors[(r*2 + c + 1) % colors.size()]);
+      }
+  }
+  
+  // Compares ScreenResampler with t8x::screen_scaling::resample().
+  template<int NRo, int NCo, int NRi, int NCi>
+  bool matches_resample(t8x::ResampleMode mode, bool uniform, int num_threads = 1)
+  {
+    auto sh_src = std::make_unique<t8::ScreenHandler<NRi, NCi>>();
+    auto sh_dst = std::make_unique<t8::ScreenHandler<NRo, NCo>>();
+    fill_pattern(*sh_src, uniform);
+    t8x::screen_scaling::resample(*sh_src, *sh_dst);
+    
+    t8x::ScreenResampler<char> resampler(mode, num_threads);
+    std::vector<t8::BufferCell<char>> dst;
+    // Twice, the second time with the cached taps (and the running worker threads).
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      std::vector<t8::BufferCell<char>> src(sh_src->get_screen_buffer().begin(), sh_src->get_screen_buffer().end());
+      if (!resampler.resample(src, NRi, NCi, dst, NRo, NCo))
+        return false;
+      const auto& ref = sh_dst->get_screen_buffer();
+      for (int idx = 0; idx < NRo*NCo; ++idx)
+        if (dst[idx].ch != ref[idx].ch || dst[idx].fg != ref[idx].fg || dst[idx].bg != ref[idx].bg)
+          return false;
+    }
+    return true;
+  }
+  
+  void unit_tests()
+  {
+    using t8x::ResampleMode;
+    
+    // Bilinear is the separable version of resample().
+    assert((matches_resample<7, 11, 4, 6>(ResampleMode::Bilinear, false))); // Upscale.
+    assert((matches_resample<5, 4, 8, 10>(ResampleMode::Bilinear, false))); // Downscale.
+    assert((matches_resample<8, 9, 5, 7>(ResampleMode::Bilinear, false))); // Non-integer ratios.
+    assert((matches_resample<6, 13, 9, 8>(ResampleMode::Bilinear, false)));
+    
+    // Nearest and AreaAverage agree with resample() wherever the result doesn't depend on
+    //   the filter : for a uniform source, for the same size, and (Nearest) when every
+    //   target cell maps exactly onto a source cell.
+    for (auto mode : { ResampleMode::Nearest, ResampleMode::AreaAverage })
+    {
+      assert((matches_resample<7, 11, 4, 6>(mode, true)));
+      assert((matches_resample<5, 4, 8, 10>(mode, true)));
+      assert((matches_resample<8, 9, 5, 7>(mode, true)));
+      assert((matches_resample<6, 8, 6, 8>(mode, false)));
+    }
+    assert((matches_resample<3, 5, 5, 9>(ResampleMode::Nearest, false)));
+    assert((matches_resample<3, 4, 5, 7>(ResampleMode::Nearest, false)));
+    
+    // Large enough to be split into row bands on several threads.
+    assert((matches_resample<90, 150, 60, 100>(ResampleMode::Bilinear, false, 4)));
+    assert((matches_resample<40, 60, 60, 100>(ResampleMode::Bilinear, false, 3)));
+  }
+
+}
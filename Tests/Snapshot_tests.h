@@ -0,0 +1,140 @@
+//
+//  Snapshot_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "sys/Snapshot.h"
+#include "physics/dynamics/RigidBody.h"
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace snapshot
+{
+  
+  void unit_tests()
+  {
+    using namespace t8x;
+    
+    {
+      StateWriter sw;
+      sw.write(42);
+      sw.write(1.5f);
+      sw.write_vector(std::vector<short> { 1, -2, 3 });
+      sw.write_string("rewind");
+      auto data = sw.release();
+      
+      StateReader sr(data);
+      int i = 0;
+      float f = 0.f;
+      std::vector<short> vec;
+      std::string str;
+      assert(sr.read(i) && i == 42);
+      assert(sr.read(f) && f == 1.5f);
+      assert(sr.read_vector(vec) && vec == std::vector<short>({ 1, -2, 3 }));
+      assert(sr.read_string(str) && str == "rewind");
+      assert(sr.ok() && sr.at_end());
+      assert(!sr.read(i) && !sr.ok());
+    }
+    
+    {
+      std::vector<uint8_t> ref(1000, 7);
+      auto state = ref;
+      state[3] = 1;
+      state[500] = 2;
+      state[501] = 3;
+      state.resize(1010, 9);
+      auto delta = t8x::snapshot::encode_delta(state, ref);
+      assert(delta.size() < 32);
+      std::vector<uint8_t> decoded;
+      assert(t8x::snapshot::decode_delta(delta, ref, decoded) && decoded == state);
+      
+      state.resize(10);
+      delta = t8x::snapshot::encode_delta(state, ref);
+      assert(t8x::snapshot::decode_delta(delta, ref, decoded) && decoded == state);
+      
+      delta.resize(delta.size() - 1);
+      assert(!t8x::snapshot::decode_delta(delta, ref, decoded));
+    }
+    
+    {
+      auto f_state = [](int frame)
+      {
+        std::vector<uint8_t> state(256, 0);
+        state[0] = static_cast<uint8_t>(frame);
+        state[100] = static_cast<uint8_t>(frame * 3);
+        return state;
+      };
+      
+      SnapshotRing ring(6, 3);
+      for (int frame = 0; frame < 100; frame += 10)
+        ring.push(frame, f_state(frame));
+      assert(ring.num_snapshots() <= 6);
+      assert(ring.newest_frame() == 90);
+      assert(ring.num_bytes() < static_cast<size_t>(ring.num_snapshots()) * 256);
+      
+      int snapshot_frame = -1;
+      std::vector<uint8_t> state;
+      assert(ring.find(85, snapshot_frame, state) && snapshot_frame == 80 && state == f_state(80));
+      assert(ring.find(ring.oldest_frame(), snapshot_frame, state) && state == f_state(snapshot_frame));
+      assert(!ring.find(ring.oldest_frame() - 1, snapshot_frame, state));
+      
+      // Rewinding drops the newer snapshots.
+      ring.push(70, f_state(71));
+      assert(ring.newest_frame() == 70);
+      assert(ring.find(1000, snapshot_frame, state) && snapshot_frame == 70 && state == f_state(71));
+    }
+    
+    {
+      SpriteHandler sprh;
+      auto* sprite = sprh.create_bitmap_sprite("box");
+      sprite->init(2, 3);
+      sprite->create_frame(0);
+      sprite->set_sprite_materials(0,
+        1, 1, 1,
+        1, 1, 1
+      );
+      sprite->pos = { 5, 10 };
+      RigidBody rb(sprite, 1.f, std::nullopt, { 2.f, -1.f }, { 0.f, 3.f }, 0.5f);
+      
+      const float dt = 0.1f;
+      int sim_frame = 1;
+      for (; sim_frame < 4; ++sim_frame)
+        rb.update(sim_frame * dt, dt, sim_frame);
+      
+      StateWriter sw;
+      sprite->save_state(sw);
+      rb.save_state(sw);
+      auto data = sw.release();
+      const auto sprite_pos = sprite->pos;
+      const auto cm = rb.get_curr_cm();
+      const auto vel = rb.get_curr_lin_vel();
+      const auto ang = rb.get_curr_ang();
+      const auto prev_aabb = rb.get_prev_AABB();
+      const auto aabb = rb.get_curr_AABB();
+      
+      for (; sim_frame < 10; ++sim_frame)
+        rb.update(sim_frame * dt, dt, sim_frame);
+      assert(rb.get_curr_cm().r != cm.r || rb.get_curr_cm().c != cm.c);
+      
+      StateReader sr(data);
+      assert(sprite->load_state(sr) && rb.load_state(sr) && sr.at_end());
+      assert(sprite->pos == sprite_pos);
+      assert(rb.get_curr_cm().r == cm.r && rb.get_curr_cm().c == cm.c);
+      assert(rb.get_curr_lin_vel().r == vel.r && rb.get_curr_lin_vel().c == vel.c);
+      assert(rb.get_curr_ang() == ang);
+      assert(rb.get_prev_AABB().r_min() == prev_aabb.r_min() && rb.get_prev_AABB().r_max() == prev_aabb.r_max());
+      assert(rb.get_prev_AABB().c_min() == prev_aabb.c_min() && rb.get_prev_AABB().c_max() == prev_aabb.c_max());
+      assert(rb.get_curr_AABB().r_min() == aabb.r_min() && rb.get_curr_AABB().c_max() == aabb.c_max());
+      
+      // Truncated state.
+      data.resize(data.size() - 1);
+      StateReader sr_trunc(data);
+      assert(sprite->load_state(sr_trunc) && !rb.load_state(sr_trunc));
+    }
+  }
+
+}
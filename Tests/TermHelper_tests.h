@@ -0,0 +1,67 @@
+//
+//  TermHelper_tests.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "screen/TermHelper.h"
+#include <cassert>
+#include <vector>
+
+namespace term_helper
+{
+  
+  void test_render_cache()
+  {
+    using namespace t8::term;
+    
+    clear_render_cache();
+    
+    // Printable ASCII bypasses the cache.
+    assert(can_render_single_column_cp_cached(U'A'));
+    assert(find_render_cache_entry(U'A').cp == none32);
+    
+    // Miss, then hit with the same result as the uncached function.
+    const char32_t cp = 0x2588; // Full block.
+    assert(find_render_cache_entry(cp).cp == none32);
+    const bool renderable = can_render_single_column_cp_cached(cp);
+    assert(renderable == can_render_single_column_cp(cp, false));
+    auto entry = find_render_cache_entry(cp);
+    assert(entry.cp == cp && (entry.renderable != 0) == renderable);
+    assert(can_render_single_column_cp_cached(cp) == renderable);
+    
+    // Out of range code points are rejected without being cached.
+    assert(!can_render_single_column_cp_cached(0x110000));
+    assert(find_render_cache_entry(0x110000).cp == none32);
+    
+    // Eviction : A full set keeps the latest code point and all but one of the others.
+    const auto set_idx = impl::get_render_cache_set_idx(cp);
+    std::vector<char32_t> same_set { cp };
+    for (char32_t cp_i = 0x100; same_set.size() <= impl::render_cache_num_ways; ++cp_i)
+      if (cp_i != cp && impl::get_render_cache_set_idx(cp_i) == set_idx)
+        same_set.emplace_back(cp_i);
+    for (auto cp_i : same_set)
+      can_render_single_column_cp_cached(cp_i);
+    assert(find_render_cache_entry(same_set.back()).cp == same_set.back());
+    size_t num_cached = 0;
+    for (auto cp_i : same_set)
+      if (find_render_cache_entry(cp_i).cp == cp_i)
+        num_cached++;
+    assert(num_cached == impl::render_cache_num_ways);
+    
+    clear_render_cache();
+    for (auto cp_i : same_set)
+      assert(find_render_cache_entry(cp_i).cp == none32);
+    assert(can_render_single_column_cp_cached(cp) == renderable);
+    assert(find_render_cache_entry(cp).cp == cp);
+    clear_render_cache();
+  }
+  
+  void unit_tests()
+  {
+    test_render_cache();
+  }
+
+}
@@ -7,10 +7,13 @@
 
 #pragma once
 #include "drawing/TextureFile.h"
+#include "drawing/AssetPack.h"
 #include <cassert>
 #include <cstdio>
 #include <filesystem>
+#include <fstream>
 #include <string>
+#include <cstring>
 
 namespace texture_file
 {
@@ -130,10 +133,185 @@ namespace texture_file
     }
   }
 
+  void test_ansi_stream_parsing()
+  {
+    using namespace t8;
+    
+    const auto path = (std::filesystem::temp_directory_path() /
+                       "termin8or_ansi_stream_test.ans").string();
+    
+    // Save/restore continuation over CRLF, cursor forward, SGR and a SAUCE record after the EOF char.
+    std::string bytes = "\033[31mAB\033[s\r\n\033[uC\033[2CD\r\n\033[0;44mE\x1A";
+    std::string sauce(128, ' ');
+    sauce.replace(0, 7, "SAUCE00");
+    sauce[94] = 1; // Character.
+    sauce[96] = 10; // Width.
+    sauce[97] = 0;
+    sauce[98] = 2; // Height.
+    sauce[99] = 0;
+    bytes += sauce;
+    {
+      std::ofstream fout(path, std::ios::binary);
+      fout << bytes;
+    }
+    
+    Texture loaded;
+    assert(TextureFile::load(loaded, path, false));
+    std::remove(path.c_str());
+    
+    assert((loaded.size == RC { 2, 6 }));
+    assert(loaded(0, 0).glyph == Glyph { 'A' });
+    assert(loaded(0, 0).fg_color == Color16::DarkRed);
+    assert(loaded(0, 2).glyph == Glyph { 'C' });
+    assert(loaded(0, 3).glyph == Glyph { ' ' });
+    assert(loaded(0, 5).glyph == Glyph { 'D' });
+    assert(loaded(1, 0).glyph == Glyph { 'E' });
+    assert(loaded(1, 0).fg_color == Color16::Default);
+    assert(loaded(1, 0).bg_color == Color16::DarkBlue);
+  }
+
+  void test_bin_roundtrip_and_view()
+  {
+    using namespace t8;
+    
+    Texture tex { 3, 40 };
+    tex.ver = 30;
+    tex.set_textel_glyph(0, 0, Glyph { U'█', '#' });
+    tex.set_textel_fg_color(0, 0, RGB6(1, 2, 3));
+    tex.set_textel_bg_color(0, 0, Gray24(23));
+    tex.set_textel_material(0, 0, 254);
+    tex.set_textel_glyph(2, 39, Glyph { 'Z' });
+    tex.set_textel_fg_color(2, 39, Color16::Green);
+    tex.set_textel_material(2, 39, 62);
+    
+    for (bool compress : { false, true })
+    {
+      const auto path = (std::filesystem::temp_directory_path() /
+                         "termin8or_bin_roundtrip_test.txb").string();
+      
+      assert(TextureFile::save(tex, path, TextureFileFormat::Auto, false,
+                               TxGlyphEncoding::TryUnicodePreferredAndFallbackElseAsciiOnly,
+                               AnsiSaveGlyphEncoding::AutoPreserveGlyphs,
+                               Color16::Default, Color16::Transparent2, compress));
+      if (compress)
+        assert(std::filesystem::file_size(path) < 64 + 10*static_cast<size_t>(tex.area));
+      
+      Texture loaded;
+      assert(TextureFile::load(loaded, path, false));
+      assert(loaded.size == tex.size);
+      assert(loaded.ver == tex.ver);
+      for (int i = 0; i < tex.area; ++i)
+      {
+        assert(loaded.glyphs[i] == tex.glyphs[i]);
+        assert(loaded.fg_colors[i] == tex.fg_colors[i]);
+        assert(loaded.bg_colors[i] == tex.bg_colors[i]);
+        assert(loaded.materials_raw[i] == tex.materials_raw[i]);
+      }
+      
+      MappedTexture mapped;
+      assert(TextureFileBin::open_view(mapped, path) == !compress);
+      if (!compress)
+      {
+        assert(mapped.view(0, 0) == tex(0, 0));
+        assert(mapped.view(2, 39) == tex(2, 39));
+        assert(mapped.view(3, 0) == Textel {});
+      }
+      mapped.file.close();
+      
+      // rows*cols overflowing an int is rejected rather than wrapping around to an empty texture.
+      if (!compress)
+      {
+        std::vector<char> bytes(64);
+        std::ifstream(path, std::ios::binary).read(bytes.data(), 64);
+        const int32_t rows = 65536, cols = 65536;
+        const uint64_t planes_size = 0;
+        std::memcpy(bytes.data() + 24, &rows, sizeof(rows));
+        std::memcpy(bytes.data() + 28, &cols, sizeof(cols));
+        std::memcpy(bytes.data() + 32, &planes_size, sizeof(planes_size));
+        std::memcpy(bytes.data() + 40, &planes_size, sizeof(planes_size));
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), 64);
+        assert(!TextureFileBin::load_bin(loaded, path));
+        assert(!TextureFileBin::open_view(mapped, path));
+      }
+      
+      std::remove(path.c_str());
+    }
+  }
+
+  void test_asset_pack()
+  {
+    using namespace t8;
+    
+    const auto tmp_dir = std::filesystem::temp_directory_path();
+    const auto tx_path = (tmp_dir / "termin8or_asset_pack_test.tx").string();
+    const auto manifest_path = (tmp_dir / "termin8or_asset_pack_test.manifest").string();
+    const auto pack_path = (tmp_dir / "termin8or_asset_pack_test.t8pack").string();
+    
+    Texture tex { 2, 3 };
+    tex.set_textel_glyph(0, 0, Glyph { U'♥', 'v' });
+    tex.set_textel_fg_color(0, 0, Color16::Red);
+    tex.set_textel_material(1, 2, 7);
+    assert(TextureFile::save(tex, tx_path, TextureFileFormat::Auto, false));
+    
+    {
+      std::ofstream manifest(manifest_path);
+      manifest << "# Test manifest.\n";
+      manifest << "texture heart_0 termin8or_asset_pack_test.tx\n";
+      manifest << "texture heart_1 " << tx_path << "\n";
+      manifest << "sprite heart 2 heart_0 heart_1 heart_0\n";
+    }
+    assert(AssetPackWriter::pack_from_manifest(manifest_path, pack_path, true, false));
+    
+    AssetPack pack;
+    assert(pack.open(pack_path));
+    assert(pack.get_entry_names().size() == 3);
+    assert(pack.get_entry_names(AssetType::Texture).size() == 2);
+    assert(!pack.has_entry("heart_2"));
+    
+    Texture loaded;
+    assert(pack.load_texture("heart_1", loaded));
+    assert(loaded.size == tex.size);
+    for (int i = 0; i < tex.area; ++i)
+    {
+      assert(loaded.glyphs[i] == tex.glyphs[i]);
+      assert(loaded.fg_colors[i] == tex.fg_colors[i]);
+      assert(loaded.materials_raw[i] == tex.materials_raw[i]);
+    }
+    
+    AssetSpriteDef sprite_def;
+    assert(pack.load_sprite_def("heart", sprite_def));
+    assert(sprite_def.size == tex.size);
+    assert(sprite_def.layer_id == 2);
+    assert((sprite_def.frames == std::vector<std::string> { "heart_0", "heart_1", "heart_0" }));
+    assert(!pack.load_sprite_def("heart_0", sprite_def));
+    
+    pack.close();
+    
+    // A table of contents whose offset + size wraps around is rejected.
+    {
+      std::vector<char> bytes(std::filesystem::file_size(pack_path));
+      std::ifstream(pack_path, std::ios::binary).read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+      asset_pack::Header hdr;
+      std::memcpy(&hdr, bytes.data(), sizeof(hdr));
+      hdr.toc_size = hdr.toc_size + 16;
+      hdr.toc_offset = ~uint64_t(0) - 7;
+      std::memcpy(bytes.data(), &hdr, sizeof(hdr));
+      std::ofstream(pack_path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+      assert(!pack.open(pack_path));
+    }
+    
+    std::remove(tx_path.c_str());
+    std::remove(manifest_path.c_str());
+    std::remove(pack_path.c_str());
+  }
+
   void unit_tests()
   {
     test_material_encoding();
     test_tx_roundtrip_preserves_unicode_and_materials();
     test_ansi_extension_auto_detection();
+    test_ansi_stream_parsing();
+    test_bin_roundtrip_and_view();
+    test_asset_pack();
   }
 }
@@ -10,6 +10,20 @@
 #include "Glyph_tests.h"
 #include "GlyphString_tests.h"
 #include "TextureFile_tests.h"
+#include "ParticleSystem_tests.h"
+#include "AssetCodegen_tests.h"
+#include "ASCII_Fonts_tests.h"
+#include "InputReader_tests.h"
+#include "Logging_tests.h"
+#include "Snapshot_tests.h"
+#include "Profiler_tests.h"
+#include "FrameBudget_tests.h"
+#include "FrameScheduler_tests.h"
+#include "Compositor_tests.h"
+#include "ScreenScaling_tests.h"
+#include "AssetLoader_tests.h"
+#include "TermHelper_tests.h"
+#include "CollisionHandler_tests.h"
 #include <iostream>
 
 
@@ -25,6 +39,34 @@ int main(int argc, char** argv)
   glyph_string::unit_tests();
   std::cout << "### TextureFile Tests ###" << std::endl;
   texture_file::unit_tests();
+  std::cout << "### ParticleSystem Tests ###" << std::endl;
+  particle_system::unit_tests();
+  std::cout << "### AssetCodegen Tests ###" << std::endl;
+  asset_codegen::unit_tests();
+  std::cout << "### ASCII_Fonts Tests ###" << std::endl;
+  ascii_fonts::unit_tests();
+  std::cout << "### InputReader Tests ###" << std::endl;
+  input_reader::unit_tests();
+  std::cout << "### Logging Tests ###" << std::endl;
+  logging::unit_tests();
+  std::cout << "### Snapshot Tests ###" << std::endl;
+  snapshot::unit_tests();
+  std::cout << "### Profiler Tests ###" << std::endl;
+  profiling::unit_tests();
+  std::cout << "### FrameBudget Tests ###" << std::endl;
+  frame_budget::unit_tests();
+  std::cout << "### FrameScheduler Tests ###" << std::endl;
+  frame_scheduler::unit_tests();
+  std::cout << "### Compositor Tests ###" << std::endl;
+  compositor::unit_tests();
+  std::cout << "### ScreenScaling Tests ###" << std::endl;
+  screen_scaling::unit_tests();
+  std::cout << "### AssetLoader Tests ###" << std::endl;
+  asset_loader::unit_tests();
+  std::cout << "### TermHelper Tests ###" << std::endl;
+  term_helper::unit_tests();
+  std::cout << "### CollisionHandler Tests ###" << std::endl;
+  collision_handler::unit_tests();
   
   return 0;
 }
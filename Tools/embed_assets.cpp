@@ -0,0 +1,47 @@
+//
+//  embed_assets.cpp
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+//  Usage: embed_assets <output header> <namespace> [texture <name> <file path>]... [fonts <font data folder>]
+//  See termin8or_embed_assets() in cmake/Termin8orEmbedAssets.cmake.
+//
+
+#include <Termin8or/sys/AssetCodegen.h>
+#include <iostream>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <output header> <namespace> [texture <name> <file path>]... [fonts <font data folder>]\n";
+    return EXIT_FAILURE;
+  }
+  
+  t8x::AssetCodegen codegen;
+  for (int a_idx = 3; a_idx < argc; )
+  {
+    std::string kind = argv[a_idx];
+    if (kind == "texture" && a_idx + 2 < argc)
+    {
+      if (!codegen.add_texture_file(argv[a_idx + 1], argv[a_idx + 2]))
+        return EXIT_FAILURE;
+      a_idx += 3;
+    }
+    else if (kind == "fonts" && a_idx + 1 < argc)
+    {
+      if (!codegen.add_font_data_dir(argv[a_idx + 1]))
+        return EXIT_FAILURE;
+      a_idx += 2;
+    }
+    else
+    {
+      std::cerr << "ERROR in embed_assets : Unexpected argument \"" << kind << "\".\n";
+      return EXIT_FAILURE;
+    }
+  }
+  
+  return codegen.write(std::string(argv[1]), std::string(argv[2])) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
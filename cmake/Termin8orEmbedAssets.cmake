@@ -0,0 +1,78 @@
+# termin8or_embed_assets(<target>
+#                        OUTPUT <header>
+#                        [NAMESPACE <namespace>]
+#                        [TEXTURES <name> <file> [<name> <file> ...]]
+#                        [FONTS <font data folder>])
+#
+# Generates <header> at build time with the textures as t8::TextureView objects and the fonts
+# as t8x::EmbeddedFont tables over constexpr arrays (see include/Termin8or/sys/AssetCodegen.h),
+# and adds the folder of <header> to the include path of <target>. A relative OUTPUT is
+# relative to the current binary dir. NAMESPACE defaults to t8_assets.
+# The tool leaves an up-to-date header untouched so that its dependents aren't rebuilt, and
+# the command therefore tracks a <header>.stamp file instead. Font files added to or removed
+# from the FONTS folder are picked up at the next build.
+#
+# Example:
+#   termin8or_embed_assets(my_game
+#     OUTPUT embedded_assets.h
+#     TEXTURES background ${CMAKE_CURRENT_SOURCE_DIR}/background.tx
+#     FONTS ${TERMIN8OR_FONTS_DIR})
+
+set(TERMIN8OR_EMBED_ASSETS_TOOL_SOURCE "${CMAKE_CURRENT_LIST_DIR}/../Tools/embed_assets.cpp"
+    CACHE INTERNAL "Source of the Termin8or asset embedding tool")
+set(TERMIN8OR_FONTS_DIR "${CMAKE_CURRENT_LIST_DIR}/../include/Termin8or/title/fonts"
+    CACHE INTERNAL "Folder with the font data files bundled with Termin8or")
+
+function(termin8or_embed_assets target)
+  cmake_parse_arguments(ARG "" "OUTPUT;NAMESPACE;FONTS" "TEXTURES" ${ARGN})
+  
+  if(NOT ARG_OUTPUT)
+    message(FATAL_ERROR "termin8or_embed_assets(): OUTPUT is required.")
+  endif()
+  if(NOT ARG_NAMESPACE)
+    set(ARG_NAMESPACE t8_assets)
+  endif()
+  cmake_path(ABSOLUTE_PATH ARG_OUTPUT BASE_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}")
+  
+  if(NOT TARGET termin8or_embed_assets_tool)
+    add_executable(termin8or_embed_assets_tool "${TERMIN8OR_EMBED_ASSETS_TOOL_SOURCE}")
+    target_link_libraries(termin8or_embed_assets_tool PRIVATE Termin8or::Termin8or)
+  endif()
+  
+  set(tool_args "${ARG_OUTPUT}" "${ARG_NAMESPACE}")
+  set(asset_files)
+  
+  list(LENGTH ARG_TEXTURES num_texture_args)
+  math(EXPR odd_texture_args "${num_texture_args} % 2")
+  if(odd_texture_args)
+    message(FATAL_ERROR "termin8or_embed_assets(): TEXTURES expects <name> <file> pairs.")
+  endif()
+  while(ARG_TEXTURES)
+    list(POP_FRONT ARG_TEXTURES tex_name tex_file)
+    cmake_path(ABSOLUTE_PATH tex_file BASE_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}")
+    list(APPEND tool_args texture "${tex_name}" "${tex_file}")
+    list(APPEND asset_files "${tex_file}")
+  endwhile()
+  
+  if(ARG_FONTS)
+    cmake_path(ABSOLUTE_PATH ARG_FONTS BASE_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}")
+    file(GLOB font_files CONFIGURE_DEPENDS "${ARG_FONTS}/font_data_*.txt")
+    list(APPEND tool_args fonts "${ARG_FONTS}")
+    list(APPEND asset_files ${font_files})
+  endif()
+  
+  set(stamp_file "${ARG_OUTPUT}.stamp")
+  add_custom_command(
+    OUTPUT "${stamp_file}"
+    BYPRODUCTS "${ARG_OUTPUT}"
+    COMMAND termin8or_embed_assets_tool ${tool_args}
+    COMMAND "${CMAKE_COMMAND}" -E touch "${stamp_file}"
+    DEPENDS termin8or_embed_assets_tool ${asset_files}
+    COMMENT "Embedding Termin8or assets into ${ARG_OUTPUT}"
+    VERBATIM)
+  
+  target_sources(${target} PRIVATE "${stamp_file}" "${ARG_OUTPUT}")
+  cmake_path(GET ARG_OUTPUT PARENT_PATH output_dir)
+  file(MAKE_DIRECTORY "${output_dir}")
+  target_include_directories(${target} PRIVATE "${output_dir}")
+endfunction()
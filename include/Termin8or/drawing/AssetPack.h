@@ -0,0 +1,432 @@
+//
+//  AssetPack.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "TextureFile.h"
+#include "texture_file/TextureFileBin.h"
+#include "texture_file/MappedFile.h"
+#include <map>
+#include <vector>
+#include <string>
+#include <optional>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <cstring>
+
+
+namespace t8
+{
+  
+  enum class AssetType : uint8_t
+  {
+    Texture,
+    Sprite,
+    Raw,
+  };
+  
+  struct AssetEntry
+  {
+    AssetType type = AssetType::Raw;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+  
+  // Bitmap sprite definition: frames refer to texture entries in the same pack.
+  struct AssetSpriteDef
+  {
+    RC size { 0, 0 };
+    int layer_id = 0;
+    std::vector<std::string> frames;
+  };
+  
+  namespace asset_pack
+  {
+    constexpr char c_magic[8] = { 'T', '8', 'P', 'A', 'C', 'K', '\0', '\0' };
+    constexpr uint32_t c_format_version = 1;
+    constexpr uint32_t c_byte_order_mark = 0x01020304;
+    constexpr size_t c_entry_alignment = 8;
+    
+    struct Header
+    {
+      char magic[8];
+      uint32_t format_version = c_format_version;
+      uint32_t byte_order_mark = c_byte_order_mark;
+      uint32_t num_entries = 0;
+      uint32_t reserved = 0;
+      uint64_t toc_offset = 0;
+      uint64_t toc_size = 0;
+    };
+    static_assert(sizeof(Header) == 40, "Unexpected padding in asset_pack::Header.");
+    
+    template<typename T>
+    void write_pod(std::vector<uint8_t>& bytes, const T& val)
+    {
+      auto offs = bytes.size();
+      bytes.resize(offs + sizeof(T));
+      std::memcpy(bytes.data() + offs, &val, sizeof(T));
+    }
+    
+    inline void write_string(std::vector<uint8_t>& bytes, const std::string& str)
+    {
+      write_pod(bytes, static_cast<uint16_t>(str.size()));
+      bytes.insert(bytes.end(), str.begin(), str.end());
+    }
+    
+    template<typename T>
+    bool read_pod(const uint8_t* data, size_t size, size_t& pos, T& val)
+    {
+      if (pos > size || sizeof(T) > size - pos)
+        return false;
+      std::memcpy(&val, data + pos, sizeof(T));
+      pos += sizeof(T);
+      return true;
+    }
+    
+    inline bool read_string(const uint8_t* data, size_t size, size_t& pos, std::string& str)
+    {
+      uint16_t len = 0;
+      if (!read_pod(data, size, pos, len) || len > size - pos)
+        return false;
+      str.assign(reinterpret_cast<const char*>(data + pos), len);
+      pos += len;
+      return true;
+    }
+  }
+  
+  // Single-file container holding many textures, sprite definitions and raw blobs.
+  // The whole file is memory mapped when opened and only the table of contents (TOC) is parsed.
+  //   Entries are decoded lazily when requested.
+  class AssetPack
+  {
+    MappedFile m_file;
+    std::map<std::string, AssetEntry> m_toc;
+  
+  public:
+    bool open(const std::string& pack_path)
+    {
+      close();
+      if (!m_file.open(pack_path))
+        return false;
+      
+      const auto* data = m_file.data();
+      const auto size = m_file.size();
+      asset_pack::Header hdr;
+      size_t pos = 0;
+      if (!asset_pack::read_pod(data, size, pos, hdr)
+          || std::memcmp(hdr.magic, asset_pack::c_magic, sizeof(asset_pack::c_magic)) != 0)
+      {
+        std::cerr << "ERROR in AssetPack::open() : File \"" << pack_path << "\" is not an asset pack.\n";
+        close();
+        return false;
+      }
+      if (hdr.byte_order_mark != asset_pack::c_byte_order_mark || hdr.format_version > asset_pack::c_format_version)
+      {
+        std::cerr << "ERROR in AssetPack::open() : Incompatible asset pack \"" << pack_path << "\".\n";
+        close();
+        return false;
+      }
+      // Written so that corrupt offsets and sizes can't wrap around.
+      if (hdr.toc_offset > size || hdr.toc_size > size - hdr.toc_offset)
+      {
+        std::cerr << "ERROR in AssetPack::open() : Asset pack \"" << pack_path << "\" is truncated.\n";
+        close();
+        return false;
+      }
+      
+      pos = static_cast<size_t>(hdr.toc_offset);
+      const auto toc_end = static_cast<size_t>(hdr.toc_offset + hdr.toc_size);
+      for (uint32_t e_idx = 0; e_idx < hdr.num_entries; ++e_idx)
+      {
+        std::string name;
+        uint8_t type = 0;
+        AssetEntry entry;
+        if (!asset_pack::read_string(data, toc_end, pos, name)
+            || !asset_pack::read_pod(data, toc_end, pos, type)
+            || !asset_pack::read_pod(data, toc_end, pos, entry.offset)
+            || !asset_pack::read_pod(data, toc_end, pos, entry.size)
+            || entry.offset > size || entry.size > size - entry.offset)
+        {
+          std::cerr << "ERROR in AssetPack::open() : Corrupt table of contents in \"" << pack_path << "\".\n";
+          close();
+          return false;
+        }
+        entry.type = static_cast<AssetType>(type);
+        m_toc[name] = entry;
+      }
+      return true;
+    }
+    
+    void close()
+    {
+      m_file.close();
+      m_toc.clear();
+    }
+    
+    bool is_open() const { return m_file.is_open(); }
+    
+    const AssetEntry* find_entry(const std::string& name) const
+    {
+      auto it = m_toc.find(name);
+      return it == m_toc.end() ? nullptr : &it->second;
+    }
+    
+    bool has_entry(const std::string& name) const { return find_entry(name) != nullptr; }
+    
+    std::vector<std::string> get_entry_names(std::optional<AssetType> type = std::nullopt) const
+    {
+      std::vector<std::string> names;
+      for (const auto& [name, entry] : m_toc)
+        if (!type.has_value() || entry.type == type.value())
+          names.emplace_back(name);
+      return names;
+    }
+    
+    // Raw bytes of an entry, pointing into the mapped file. Valid until the pack is closed.
+    std::pair<const uint8_t*, size_t> get_bytes(const std::string& name) const
+    {
+      const auto* entry = find_entry(name);
+      if (entry == nullptr)
+        return { nullptr, 0 };
+      return { m_file.data() + entry->offset, static_cast<size_t>(entry->size) };
+    }
+    
+    bool load_texture(const std::string& name, Texture& tex) const
+    {
+      const auto* entry = find_entry(name);
+      if (entry == nullptr || entry->type != AssetType::Texture)
+      {
+        std::cerr << "ERROR in AssetPack::load_texture() : No texture entry named \"" << name << "\".\n";
+        return false;
+      }
+      return TextureFileBin::load_bin(tex, m_file.data() + entry->offset, static_cast<size_t>(entry->size), name);
+    }
+    
+    bool load_sprite_def(const std::string& name, AssetSpriteDef& sprite_def) const
+    {
+      const auto* entry = find_entry(name);
+      if (entry == nullptr || entry->type != AssetType::Sprite)
+      {
+        std::cerr << "ERROR in AssetPack::load_sprite_def() : No sprite entry named \"" << name << "\".\n";
+        return false;
+      }
+      const auto* data = m_file.data() + entry->offset;
+      const auto size = static_cast<size_t>(entry->size);
+      size_t pos = 0;
+      int32_t rows = 0, cols = 0, layer_id = 0;
+      uint32_t num_frames = 0;
+      if (!asset_pack::read_pod(data, size, pos, rows)
+          || !asset_pack::read_pod(data, size, pos, cols)
+          || !asset_pack::read_pod(data, size, pos, layer_id)
+          || !asset_pack::read_pod(data, size, pos, num_frames)
+          || num_frames > size)
+      {
+        std::cerr << "ERROR in AssetPack::load_sprite_def() : Corrupt sprite entry \"" << name << "\".\n";
+        return false;
+      }
+      sprite_def.size = { rows, cols };
+      sprite_def.layer_id = layer_id;
+      sprite_def.frames.resize(num_frames);
+      for (auto& frame : sprite_def.frames)
+        if (!asset_pack::read_string(data, size, pos, frame))
+        {
+          std::cerr << "ERROR in AssetPack::load_sprite_def() : Corrupt sprite entry \"" << name << "\".\n";
+          return false;
+        }
+      return true;
+    }
+  };
+  
+  // Builds an asset pack file.
+  class AssetPackWriter
+  {
+    struct PendingEntry
+    {
+      std::string name;
+      AssetType type = AssetType::Raw;
+      std::vector<uint8_t> bytes;
+    };
+    std::vector<PendingEntry> m_entries;
+    
+    bool add_entry(const std::string& name, AssetType type, std::vector<uint8_t>&& bytes)
+    {
+      if (name.empty() || name.size() > 0xFFFF)
+      {
+        std::cerr << "ERROR in AssetPackWriter::add_entry() : Invalid entry name \"" << name << "\".\n";
+        return false;
+      }
+      if (stlutils::contains_if(m_entries, [&name](const auto& e) { return e.name == name; }))
+      {
+        std::cerr << "ERROR in AssetPackWriter::add_entry() : Duplicate entry name \"" << name << "\".\n";
+        return false;
+      }
+      m_entries.push_back({ name, type, std::move(bytes) });
+      return true;
+    }
+  
+  public:
+    bool add_texture(const std::string& name, const Texture& tex, bool compress = true)
+    {
+      std::vector<uint8_t> bytes;
+      TextureFileBin::save_bin(tex, bytes, compress);
+      return add_entry(name, AssetType::Texture, std::move(bytes));
+    }
+    
+    // Any format supported by TextureFile::load().
+    bool add_texture_file(const std::string& name, const std::string& file_path,
+                          bool compress = true, bool verbose = false)
+    {
+      Texture tex;
+      if (!TextureFile::load(tex, file_path, verbose))
+        return false;
+      return add_texture(name, tex, compress);
+    }
+    
+    bool add_sprite(const std::string& name, const AssetSpriteDef& sprite_def)
+    {
+      std::vector<uint8_t> bytes;
+      asset_pack::write_pod(bytes, static_cast<int32_t>(sprite_def.size.r));
+      asset_pack::write_pod(bytes, static_cast<int32_t>(sprite_def.size.c));
+      asset_pack::write_pod(bytes, static_cast<int32_t>(sprite_def.layer_id));
+      asset_pack::write_pod(bytes, static_cast<uint32_t>(sprite_def.frames.size()));
+      for (const auto& frame : sprite_def.frames)
+        asset_pack::write_string(bytes, frame);
+      return add_entry(name, AssetType::Sprite, std::move(bytes));
+    }
+    
+    bool add_raw(const std::string& name, std::vector<uint8_t> bytes)
+    {
+      return add_entry(name, AssetType::Raw, std::move(bytes));
+    }
+    
+    int num_entries() const { return stlutils::sizeI(m_entries); }
+    
+    bool write(const std::string& pack_path) const
+    {
+      std::vector<uint8_t> bytes;
+      asset_pack::Header hdr;
+      std::memcpy(hdr.magic, asset_pack::c_magic, sizeof(asset_pack::c_magic));
+      hdr.num_entries = static_cast<uint32_t>(m_entries.size());
+      asset_pack::write_pod(bytes, hdr);
+      
+      std::vector<uint64_t> offsets;
+      for (const auto& entry : m_entries)
+      {
+        while (bytes.size() % asset_pack::c_entry_alignment != 0)
+          bytes.emplace_back(0);
+        offsets.emplace_back(bytes.size());
+        bytes.insert(bytes.end(), entry.bytes.begin(), entry.bytes.end());
+      }
+      
+      hdr.toc_offset = bytes.size();
+      for (size_t e_idx = 0; e_idx < m_entries.size(); ++e_idx)
+      {
+        const auto& entry = m_entries[e_idx];
+        asset_pack::write_string(bytes, entry.name);
+        asset_pack::write_pod(bytes, static_cast<uint8_t>(entry.type));
+        asset_pack::write_pod(bytes, offsets[e_idx]);
+        asset_pack::write_pod(bytes, static_cast<uint64_t>(entry.bytes.size()));
+      }
+      hdr.toc_size = bytes.size() - hdr.toc_offset;
+      std::memcpy(bytes.data(), &hdr, sizeof(hdr));
+      
+      std::ofstream file(pack_path, std::ios::binary | std::ios::trunc);
+      if (!file)
+      {
+        std::cerr << "ERROR in AssetPackWriter::write() : Unable to open file \"" << pack_path << "\" for writing.\n";
+        return false;
+      }
+      file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+      return static_cast<bool>(file);
+    }
+    
+    // Packing tool entry point. The manifest is a text file with one asset per line:
+    //   texture <name> <file path>
+    //   sprite <name> <layer id> <frame texture name> [<frame texture name> ...]
+    // Relative file paths are relative to the folder of the manifest.
+    //   Sprite frames must be textures listed earlier in the manifest. Lines starting with '#' are ignored.
+    static bool pack_from_manifest(const std::string& manifest_path, const std::string& pack_path,
+                                   bool compress = true, bool verbose = true)
+    {
+      std::ifstream manifest(manifest_path);
+      if (!manifest)
+      {
+        std::cerr << "ERROR in AssetPackWriter::pack_from_manifest() : Unable to open manifest \"" << manifest_path << "\".\n";
+        return false;
+      }
+      const auto base_dir = std::filesystem::path(manifest_path).parent_path();
+      
+      AssetPackWriter writer;
+      std::map<std::string, RC> texture_sizes;
+      std::string line;
+      int line_nr = 0;
+      while (std::getline(manifest, line))
+      {
+        line_nr++;
+        std::istringstream iss(line);
+        std::string kind, name;
+        if (!(iss >> kind) || kind.starts_with("#"))
+          continue;
+        iss >> name;
+        if (kind == "texture")
+        {
+          std::string file_path;
+          std::getline(iss >> std::ws, file_path);
+          auto path = std::filesystem::path(file_path);
+          if (path.is_relative())
+            path = base_dir / path;
+          Texture tex;
+          if (!TextureFile::load(tex, path.string(), false))
+          {
+            std::cerr << "ERROR in AssetPackWriter::pack_from_manifest() : Unable to load texture on line " << line_nr << ".\n";
+            return false;
+          }
+          texture_sizes[name] = tex.size;
+          if (!writer.add_texture(name, tex, compress))
+            return false;
+        }
+        else if (kind == "sprite")
+        {
+          AssetSpriteDef sprite_def;
+          iss >> sprite_def.layer_id;
+          std::string frame;
+          while (iss >> frame)
+          {
+            auto it = texture_sizes.find(frame);
+            if (it == texture_sizes.end())
+            {
+              std::cerr << "ERROR in AssetPackWriter::pack_from_manifest() : Unknown frame texture \"" << frame << "\" on line " << line_nr << ".\n";
+              return false;
+            }
+            if (sprite_def.frames.empty())
+              sprite_def.size = it->second;
+            else if (it->second != sprite_def.size)
+            {
+              std::cerr << "ERROR in AssetPackWriter::pack_from_manifest() : Frame sizes differ for sprite \"" << name << "\" on line " << line_nr << ".\n";
+              return false;
+            }
+            sprite_def.frames.emplace_back(frame);
+          }
+          if (!writer.add_sprite(name, sprite_def))
+            return false;
+        }
+        else
+        {
+          std::cerr << "ERROR in AssetPackWriter::pack_from_manifest() : Unknown asset kind \"" << kind << "\" on line " << line_nr << ".\n";
+          return false;
+        }
+      }
+      
+      if (!writer.write(pack_path))
+        return false;
+      if (verbose)
+        std::cout << "Packed " << writer.num_entries() << " assets into \"" << pack_path << "\".\n";
+      return true;
+    }
+  };
+
+}
@@ -6,7 +6,12 @@
 //
 
 #pragma once
+#include "../screen/Color.h"
 #include <Core/MathUtils.h>
+#include <Core/StlUtils.h>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
 #include <assert.h>
 
 namespace t8x
@@ -57,5 +62,105 @@ namespace t8x
       return closest_obj;
     }
   };
+  
+  enum class GradientBakeMode { Nearest, Interpolated };
+  
+  // Gradient sampled into a fixed-size lookup table when constructed, giving O(1) evaluation.
+  // Each LUT entry holds the value at the center of its t-bucket.
+  // GradientBakeMode::Interpolated blends linearly between the stop centers for
+  //   RGBA and Color (via color2rgba, quantized back to the nearest palette color).
+  //   Other types, and stops without an RGBA value (e.g. Color::Default), fall back to Nearest.
+  // Implicitly constructible from a Gradient so it can be used wherever a Gradient was passed.
+  template<typename T>
+  struct BakedGradient
+  {
+    BakedGradient(T def = T{}) : default_value(def) {}
+    BakedGradient(const Gradient<T>& grad,
+                  GradientBakeMode mode = GradientBakeMode::Nearest, int lut_size = 256)
+    {
+      bake(grad, mode, lut_size);
+    }
+    
+    void bake(const Gradient<T>& grad,
+              GradientBakeMode mode = GradientBakeMode::Nearest, int lut_size = 256)
+    {
+      default_value = grad.default_value;
+      bake_mode = mode;
+      lut.clear();
+      if (grad.gradient.empty() || lut_size <= 0)
+        return;
+      
+      auto stops = grad.gradient;
+      std::stable_sort(stops.begin(), stops.end(),
+                       [](const auto& sA, const auto& sB) { return sA.first < sB.first; });
+      
+      lut.resize(lut_size);
+      for (int i = 0; i < lut_size; ++i)
+      {
+        float t = (i + 0.5f) / lut_size;
+        if (mode == GradientBakeMode::Interpolated)
+          lut[i] = sample_interpolated(grad, stops, t);
+        else
+          lut[i] = grad(t);
+      }
+    }
+    
+    T operator() (float t) const
+    {
+      assert(0.f <= t && t <= 1.f);
+      if (lut.empty())
+        return default_value;
+      int N = stlutils::sizeI(lut);
+      int idx = std::clamp(static_cast<int>(t * N), 0, N - 1);
+      return lut[idx];
+    }
+    
+    int lut_size() const { return stlutils::sizeI(lut); }
+    GradientBakeMode get_bake_mode() const { return bake_mode; }
+    
+    T default_value;
+    
+  private:
+    std::vector<T> lut;
+    GradientBakeMode bake_mode = GradientBakeMode::Nearest;
+    
+    static T sample_interpolated(const Gradient<T>& grad,
+                                 const std::vector<std::pair<float, T>>& stops, float t)
+    {
+      if (t <= stops.front().first)
+        return stops.front().second;
+      if (t >= stops.back().first)
+        return stops.back().second;
+      
+      size_t i1 = 1;
+      while (i1 < stops.size() && stops[i1].first < t)
+        ++i1;
+      const auto& s0 = stops[i1 - 1];
+      const auto& s1 = stops[i1];
+      float span = s1.first - s0.first;
+      float w = span > 0.f ? (t - s0.first) / span : 0.f;
+      
+      if constexpr (std::is_same_v<T, t8::RGBA>)
+        return lerp_rgba(s0.second, s1.second, w);
+      else if constexpr (std::is_same_v<T, t8::Color>)
+      {
+        auto it0 = t8::color2rgba.find(s0.second);
+        auto it1 = t8::color2rgba.find(s1.second);
+        if (it0 == t8::color2rgba.end() || it1 == t8::color2rgba.end())
+          return grad(t);
+        return t8::to_nearest_color(lerp_rgba(it0->second, it1->second, w));
+      }
+      else
+        return grad(t);
+    }
+    
+    static t8::RGBA lerp_rgba(const t8::RGBA& c0, const t8::RGBA& c1, float w)
+    {
+      return { c0.r + (c1.r - c0.r)*w,
+               c0.g + (c1.g - c0.g)*w,
+               c0.b + (c1.b - c0.b)*w,
+               c0.a + (c1.a - c0.a)*w };
+    }
+  };
 
 }
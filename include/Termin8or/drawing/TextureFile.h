@@ -8,6 +8,7 @@
 #pragma once
 #include "texture_file/TextureFileTx.h"
 #include "texture_file/TextureFileAnsi.h"
+#include "texture_file/TextureFileBin.h"
 
 
 namespace t8
@@ -18,6 +19,7 @@ namespace t8
     Auto,
     Tx,
     Ansi,
+    Bin,
   };
 
   class TextureFile
@@ -30,6 +32,8 @@ namespace t8
         return TextureFileFormat::Ansi;
       if (ext == "tx")
         return TextureFileFormat::Tx;
+      if (ext == "txb")
+        return TextureFileFormat::Bin;
       return TextureFileFormat::Auto;
     }
     
@@ -65,6 +69,9 @@ namespace t8
                                           ansi_glyph_encoding,
                                           ansi_default_fg, ansi_default_bg);
           break;
+        case TextureFileFormat::Bin:
+          ok = TextureFileBin::load_bin(parsed, file_path);
+          break;
       }
       
       if (!ok)
@@ -85,7 +92,8 @@ namespace t8
                      TxGlyphEncoding encoding_mode = TxGlyphEncoding::TryUnicodePreferredAndFallbackElseAsciiOnly,
                      AnsiSaveGlyphEncoding ansi_glyph_encoding = AnsiSaveGlyphEncoding::AutoPreserveGlyphs,
                      Color ansi_default_fg = Color16::Default,
-                     Color ansi_default_bg = Color16::Transparent2)
+                     Color ansi_default_bg = Color16::Transparent2,
+                     bool bin_compress = false)
     {
       auto resolved_format = format == TextureFileFormat::Auto ?
       deduce_file_format(file_path) : format;
@@ -101,6 +109,8 @@ namespace t8
                                             ansi_glyph_encoding,
                                             ansi_default_fg,
                                             ansi_default_bg);
+        case TextureFileFormat::Bin:
+          return TextureFileBin::save_bin(tex, file_path, bin_compress);
       }
       
       return false;
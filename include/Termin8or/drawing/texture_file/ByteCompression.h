@@ -0,0 +1,152 @@
+//
+//  ByteCompression.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+
+namespace t8
+{
+  
+  // Small LZ77 block compressor in the spirit of LZ4.
+  // Sequence: token (literal length << 4 | (match length - 4)), optional extra literal length bytes,
+  //   literals, 16-bit LE match offset, optional extra match length bytes.
+  //   Extra length bytes are 255-continued. The last sequence has literals only.
+  // Fast to decompress and good enough for texture planes, which are dominated by runs.
+  namespace byte_compression
+  {
+    constexpr size_t c_min_match = 4;
+    constexpr size_t c_max_offset = 65535;
+    constexpr int c_hash_bits = 12;
+    
+    namespace detail
+    {
+      inline void write_len_ext(std::vector<uint8_t>& dst, size_t len)
+      {
+        while (len >= 255)
+        {
+          dst.emplace_back(255);
+          len -= 255;
+        }
+        dst.emplace_back(static_cast<uint8_t>(len));
+      }
+      
+      inline bool read_len_ext(const uint8_t* src, size_t src_size, size_t& ip, size_t& len)
+      {
+        uint8_t b = 0;
+        do
+        {
+          if (ip >= src_size)
+            return false;
+          b = src[ip++];
+          len += b;
+        } while (b == 255);
+        return true;
+      }
+      
+      inline uint32_t read32(const uint8_t* p)
+      {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+      }
+    }
+    
+    inline std::vector<uint8_t> compress(const uint8_t* src, size_t src_size)
+    {
+      std::vector<uint8_t> dst;
+      dst.reserve(src_size/2 + 16);
+      
+      constexpr size_t npos = static_cast<size_t>(-1);
+      std::vector<size_t> hash_table(size_t(1) << c_hash_bits, npos);
+      auto hash = [](uint32_t v) { return (v * 2654435761u) >> (32 - c_hash_bits); };
+      
+      size_t anchor = 0;
+      auto emit = [&](size_t lit_len, size_t match_len, size_t offset, bool last)
+      {
+        auto ml = last ? 0 : match_len - c_min_match;
+        uint8_t token = static_cast<uint8_t>(std::min<size_t>(lit_len, 15) << 4);
+        if (!last)
+          token |= static_cast<uint8_t>(std::min<size_t>(ml, 15));
+        dst.emplace_back(token);
+        if (lit_len >= 15)
+          detail::write_len_ext(dst, lit_len - 15);
+        dst.insert(dst.end(), src + anchor, src + anchor + lit_len);
+        if (!last)
+        {
+          dst.emplace_back(static_cast<uint8_t>(offset & 0xFF));
+          dst.emplace_back(static_cast<uint8_t>((offset >> 8) & 0xFF));
+          if (ml >= 15)
+            detail::write_len_ext(dst, ml - 15);
+        }
+      };
+      
+      size_t pos = 0;
+      while (pos + c_min_match <= src_size)
+      {
+        auto v = detail::read32(src + pos);
+        auto h = hash(v);
+        auto cand = hash_table[h];
+        hash_table[h] = pos;
+        if (cand != npos && pos - cand <= c_max_offset && detail::read32(src + cand) == v)
+        {
+          auto len = c_min_match;
+          while (pos + len < src_size && src[cand + len] == src[pos + len])
+            ++len;
+          emit(pos - anchor, len, pos - cand, false);
+          pos += len;
+          anchor = pos;
+        }
+        else
+          ++pos;
+      }
+      emit(src_size - anchor, 0, 0, true);
+      
+      return dst;
+    }
+    
+    // dst_size must be the exact uncompressed size. Returns false on corrupt input.
+    inline bool decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size)
+    {
+      size_t ip = 0;
+      size_t op = 0;
+      while (ip < src_size)
+      {
+        uint8_t token = src[ip++];
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !detail::read_len_ext(src, src_size, ip, lit_len))
+          return false;
+        if (ip + lit_len > src_size || op + lit_len > dst_size)
+          return false;
+        std::memcpy(dst + op, src + ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == src_size)
+          break; // Last sequence.
+        
+        if (ip + 2 > src_size)
+          return false;
+        size_t offset = src[ip] | (static_cast<size_t>(src[ip + 1]) << 8);
+        ip += 2;
+        size_t match_len = token & 0x0F;
+        if (match_len == 15 && !detail::read_len_ext(src, src_size, ip, match_len))
+          return false;
+        match_len += c_min_match;
+        if (offset == 0 || offset > op || op + match_len > dst_size)
+          return false;
+        for (size_t i = 0; i < match_len; ++i, ++op) // Byte-wise since the match may overlap.
+          dst[op] = dst[op - offset];
+      }
+      return op == dst_size;
+    }
+  }
+
+}
@@ -0,0 +1,146 @@
+//
+//  MappedFile.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX // Should fix the std::min()/max() and std::numeric_limits<T>::min()/max() compilation problems
+#endif
+#include <windows.h>
+#else // POSIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // COMMON
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <utility>
+
+
+namespace t8
+{
+  
+  // Read-only memory mapping of a whole file.
+  class MappedFile
+  {
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+  
+  public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+      if (this != &other)
+      {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+#ifdef _WIN32
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+#else
+        std::swap(m_fd, other.m_fd);
+#endif
+      }
+      return *this;
+    }
+    ~MappedFile() { close(); }
+    
+    bool open(const std::string& file_path)
+    {
+      close();
+#ifdef _WIN32
+      m_file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (m_file == INVALID_HANDLE_VALUE)
+      {
+        std::cerr << "ERROR in MappedFile::open() : Unable to open file \"" << file_path << "\".\n";
+        return false;
+      }
+      LARGE_INTEGER file_size;
+      if (!GetFileSizeEx(m_file, &file_size) || file_size.QuadPart == 0)
+      {
+        std::cerr << "ERROR in MappedFile::open() : Empty or unreadable file \"" << file_path << "\".\n";
+        close();
+        return false;
+      }
+      m_size = static_cast<size_t>(file_size.QuadPart);
+      m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (m_mapping == nullptr)
+      {
+        std::cerr << "ERROR in MappedFile::open() : Unable to map file \"" << file_path << "\".\n";
+        close();
+        return false;
+      }
+      m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+      m_fd = ::open(file_path.c_str(), O_RDONLY);
+      if (m_fd == -1)
+      {
+        std::cerr << "ERROR in MappedFile::open() : Unable to open file \"" << file_path << "\".\n";
+        return false;
+      }
+      struct stat st;
+      if (fstat(m_fd, &st) != 0 || st.st_size == 0)
+      {
+        std::cerr << "ERROR in MappedFile::open() : Empty or unreadable file \"" << file_path << "\".\n";
+        close();
+        return false;
+      }
+      m_size = static_cast<size_t>(st.st_size);
+      void* addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+      m_data = addr == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(addr);
+#endif
+      if (m_data == nullptr)
+      {
+        std::cerr << "ERROR in MappedFile::open() : Unable to map file \"" << file_path << "\".\n";
+        close();
+        return false;
+      }
+      return true;
+    }
+    
+    void close()
+    {
+#ifdef _WIN32
+      if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+      if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+      if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+      m_mapping = nullptr;
+      m_file = INVALID_HANDLE_VALUE;
+#else
+      if (m_data != nullptr)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+      if (m_fd != -1)
+        ::close(m_fd);
+      m_fd = -1;
+#endif
+      m_data = nullptr;
+      m_size = 0;
+    }
+    
+    bool is_open() const { return m_data != nullptr; }
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+  };
+
+}
@@ -10,11 +10,13 @@
 #include "TextureFileCommon.h"
 #include "../Texture.h"
 #include "../../screen/Ansi.h"
+#include "MappedFile.h"
 #include <Core/TextIO.h>
 #include <Core/StringHelper.h>
 #include <Core/FolderHelper.h>
 #include <fstream>
 #include <sstream>
+#include <string_view>
 
 
 namespace t8
@@ -44,13 +46,13 @@ namespace t8
   {
     // BOM (Byte Order Mark).
     // UTF-8 : EF BB BF
-    static bool has_utf8_bom(const std::vector<std::string>& lines)
+    static bool has_utf8_bom(std::string_view bytes)
     {
-      if (!lines.empty() && lines[0].size() >= 3)
+      if (bytes.size() >= 3)
       {
-        const unsigned char b0 = static_cast<unsigned char>(lines[0][0]);
-        const unsigned char b1 = static_cast<unsigned char>(lines[0][1]);
-        const unsigned char b2 = static_cast<unsigned char>(lines[0][2]);
+        const unsigned char b0 = static_cast<unsigned char>(bytes[0]);
+        const unsigned char b1 = static_cast<unsigned char>(bytes[1]);
+        const unsigned char b2 = static_cast<unsigned char>(bytes[2]);
         
         if (b0 == 0xEF && b1 == 0xBB && b2 == 0xBF)
           return true;
@@ -58,11 +60,6 @@ namespace t8
       return false;
     }
     
-    static void strip_utf8_bom(std::vector<std::string>& lines)
-    {
-      lines[0].erase(0, 3);
-    }
-    
     static void add_utf8_bom(std::vector<std::string>& lines)
     {
       const char b0 = static_cast<char>(0xEF);
@@ -79,7 +76,7 @@ namespace t8
         lines[0].insert(0, bstr);
     }
 
-    static bool is_sauce_record_at(const std::string& bytes, size_t pos)
+    static bool is_sauce_record_at(std::string_view bytes, size_t pos)
     {
       // SAUCE part is 128 bytes long:
       //   [art data][optional 0x1A][SAUCE00 ... 121 bytes sauce data].
@@ -114,14 +111,14 @@ namespace t8
       return data_type <= 8;
     }
 
-    static uint16_t read_sauce_le_uint16(const std::string& bytes, size_t pos)
+    static uint16_t read_sauce_le_uint16(std::string_view bytes, size_t pos)
     {
       const auto lo = static_cast<unsigned char>(bytes[pos]);
       const auto hi = static_cast<unsigned char>(bytes[pos + 1]);
       return static_cast<uint16_t>(lo | (hi << 8));
     }
 
-    static bool read_sauce_ansi_size(const std::string& bytes, size_t pos, RC& size)
+    static bool read_sauce_ansi_size(std::string_view bytes, size_t pos, RC& size)
     {
       if (!is_sauce_record_at(bytes, pos))
         return false;
@@ -140,7 +137,7 @@ namespace t8
       return true;
     }
 
-    static bool find_sauce_ansi_size(const std::string& bytes, RC& size)
+    static bool find_sauce_ansi_size(std::string_view bytes, RC& size)
     {
       const std::string sauce_str = "SAUCE00";
       bool found = false;
@@ -154,7 +151,7 @@ namespace t8
       return found;
     }
 
-    static size_t find_inline_sauce_record_end(const std::string& bytes, size_t pos)
+    static size_t find_inline_sauce_record_end(std::string_view bytes, size_t pos)
     {
       // Sauce record ends either at end of file or after 128 bytes.
       //   If '\0' not found then return npos.
@@ -435,50 +432,85 @@ namespace t8
       return true;
     }
     
-    static bool read_ansi_file(const std::string& file_path,
-                               std::vector<std::string>& lines,
-                               RC* sauce_size = nullptr,
-                               int verbosity = 3)
+    static size_t find_first_sauce_record(std::string_view bytes)
     {
-      std::ifstream file(file_path, std::ios::binary);
-      if (!file.is_open())
+      const std::string sauce_str = "SAUCE00";
+      for (size_t pos = bytes.find(sauce_str);
+           pos != std::string::npos;
+           pos = bytes.find(sauce_str, pos + sauce_str.length()))
       {
-        if (verbosity >= 1)
-          std::cerr << "ERROR in TextureFileAnsi::read_ansi_file() : Unable to open file \"" << file_path << "\"!" << std::endl;
-        return false;
+        if (is_sauce_record_at(bytes, pos)
+            || find_inline_sauce_record_end(bytes, pos) != std::string::npos)
+          return pos;
       }
-
-      std::string bytes((std::istreambuf_iterator<char>(file)),
-                         std::istreambuf_iterator<char>());
-      if (bytes.empty())
-      {
-        if (verbosity >= 2)
-          std::cerr << "ERROR in TextureFileAnsi::read_ansi_file() : End of file reached." << std::endl;
+      return std::string::npos;
+    }
+    
+    // Maps the file and sets data to the art bytes, i.e. everything before the first EOF char (0x1A),
+    //   without SAUCE records. data points straight into mapped_file unless a SAUCE record precedes
+    //   the EOF char, in which case the records are stripped from a copy held by stripped_bytes.
+    static bool read_ansi_file(const std::string& file_path,
+                               MappedFile& mapped_file,
+                               std::string& stripped_bytes,
+                               std::string_view& data,
+                               RC* sauce_size = nullptr)
+    {
+      if (!mapped_file.open(file_path))
         return false;
-      }
-
+      
+      std::string_view bytes { reinterpret_cast<const char*>(mapped_file.data()), mapped_file.size() };
+      
       if (sauce_size != nullptr)
         find_sauce_ansi_size(bytes, *sauce_size);
-
-      strip_sauce_records(bytes);
-
-      lines.clear();
-      size_t line_start = 0;
-      for (size_t i = 0; i < bytes.size(); ++i)
+      
+      const auto sauce_pos = find_first_sauce_record(bytes);
+      if (sauce_pos != std::string::npos && sauce_pos < bytes.find('\x1A'))
       {
-        if (bytes[i] == '\n')
-        {
-          lines.emplace_back(bytes.substr(line_start, i - line_start));
-          line_start = i + 1; // The +1 filters out '\n'.
-        }
+        stripped_bytes.assign(bytes);
+        strip_sauce_records(stripped_bytes);
+        bytes = stripped_bytes;
       }
-      // If '\n' not found then add the remaining bytes.
-      if (line_start < bytes.size())
-        lines.emplace_back(bytes.substr(line_start));
-
+      
+      data = bytes.substr(0, bytes.find('\x1A'));
       return true;
     }
     
+    // Some old ANSI files split a logical 80-column stream over several
+    //   physical file lines by saving the cursor before CRLF and restoring it
+    //   at the start of the next line. That only renders correctly with wrap.
+    // A single overlong line (optionally followed by one more line) is also
+    //   treated as a wrapped stream.
+    // Only scans for line breaks, the escape codes are parsed in load_ansi().
+    static bool has_ansi_wrapped_line_layout(std::string_view data, int wrap_width)
+    {
+      ansi::AnsiCsiSequence ansi_seq;
+      int num_lines = 0;
+      int num_long_lines = 0;
+      bool prev_line_ends_with_save = false;
+      for (size_t line_start = 0; line_start < data.size(); )
+      {
+        auto line_end = std::min(data.find('\n', line_start), data.size());
+        auto line = data.substr(line_start, line_end - line_start);
+        if (!line.empty() && line.back() == '\r')
+          line.remove_suffix(1);
+        
+        // Only treat save as continuation syntax when it is the final code
+        //   on the physical line; saves in the middle are normal cursor state.
+        int pos = 0;
+        if (prev_line_ends_with_save
+            && ansi::parse_ansi_csi_sequence(line, pos, ansi_seq)
+            && ansi_seq.command == 'u')
+          return true;
+        prev_line_ends_with_save = line.ends_with("\033[s");
+        
+        if (wrap_width < static_cast<int>(line.size()))
+          ++num_long_lines;
+        ++num_lines;
+        line_start = line_end + 1;
+      }
+      return num_long_lines == 1 && num_lines <= 2;
+    }
+    
     static bool has_non_cp437_convertible_glyphs_preferred(const Texture& tex)
     {
       for (auto& g : tex.glyphs)
@@ -499,9 +531,13 @@ namespace t8
                           Color ansi_default_fg = Color16::Default,
                           Color ansi_default_bg = Color16::Transparent2)
     {
-      std::vector<std::string> lines;
+      // The file is parsed in a single pass over the mapped bytes: textels are
+      //   emitted as soon as they are decoded and escape codes are parsed in place.
+      MappedFile mapped_file;
+      std::string stripped_bytes;
+      std::string_view data;
       RC sauce_size;
-      bool ret = read_ansi_file(file_path, lines, &sauce_size);
+      bool ret = read_ansi_file(file_path, mapped_file, stripped_bytes, data, &sauce_size);
       if (!ret)
         return false;
       
@@ -512,10 +548,10 @@ namespace t8
       // *.utf8ans (no BOM): Auto->UTF8:c, UTF8:c, CP437:w
       // *.utf8ans (has BOM): Auto->UTF8:c, UTF8:c, CP437:w (via BOM/CP437 conflict, not extension).
       auto ext = get_file_ext(file_path);
-      bool utf8_bom = has_utf8_bom(lines);
+      bool utf8_bom = has_utf8_bom(data);
       if (utf8_bom)
       {
-        strip_utf8_bom(lines);
+        data.remove_prefix(3);
         
         if (glyph_encoding == AnsiLoadGlyphEncoding::Auto)
           glyph_encoding = AnsiLoadGlyphEncoding::UTF8;
@@ -541,23 +577,6 @@ namespace t8
           std::cerr << "WARNING in TextureFileAnsi::load_ansi() : Attempting to load a UTF-8 ANSI (*.utf8ans) file in CP437 encoding!\n";
       }
       
-      // Normalizes DOS/Windows CRLF lines to plain content lines.
-      for (auto& line : lines)
-        if (!line.empty() && line.back() == '\r')
-          line.pop_back();
-      
-      const int Nl = stlutils::sizeI(lines);
-      for (int i = 0; i < Nl; ++i)
-      {
-        auto eof_pos = lines[i].find('\x1A');
-        if (eof_pos != std::string::npos)
-        {
-          lines[i].erase(eof_pos);
-          lines.resize(lines[i].empty() ? i : i + 1);
-          break;
-        }
-      }
-      
       const std::string empty_str_row;
       
       std::vector<std::string> fb_lines;
@@ -577,46 +596,15 @@ namespace t8
       };
       
       std::vector<std::vector<Cell>> rows;
+      if (sauce_size.r > 0)
+        rows.reserve(sauce_size.r);
       
       Color fg = ansi_default_fg;
       Color bg = ansi_default_bg;
       constexpr int ansi_terminal_width = 80;
       const int ansi_wrap_width = sauce_size.c > 0 ? sauce_size.c : ansi_terminal_width;
-      const auto num_long_lines = static_cast<int>(stlutils::count_if(lines,
-        [ansi_wrap_width](const auto& line) { return ansi_wrap_width < str::lenI(line); }));
-
-      // Some old ANSI files split a logical 80-column stream over several
-      //   physical file lines by saving the cursor before CRLF and restoring it
-      //   at the start of the next line. That only renders correctly with wrap.
-      const auto f_has_save_restore_continuation = [&]()
-      {
-        auto f_has_cursor_save_restore_at = [](const std::string& line, int pos, char command)
-        {
-          char parsed_command = '\0';
-          return ansi::parse_ansi_cursor_save_restore(line, pos, parsed_command)
-            && parsed_command == command;
-        };
-        
-        for (int i = 0; i + 1 < stlutils::sizeI(lines); ++i)
-        {
-          const auto& line = lines[i];
-          const auto& next_line = lines[i + 1];
-          
-          // Only treat save as continuation syntax when it is the final code
-          //   on the physical line; saves in the middle are normal cursor state.
-          const int save_pos = line.size() >= 3 ? stlutils::sizeI(line) - 3 : 0;
-          const bool line_ends_with_save = f_has_cursor_save_restore_at(line, save_pos, 's')
-            && save_pos + 3 == stlutils::sizeI(line);
-          const bool next_line_starts_with_restore = f_has_cursor_save_restore_at(next_line, 0, 'u');
-
-          if (line_ends_with_save && next_line_starts_with_restore)
-            return true;
-        }
-        return false;
-      }();
       const bool ansi_auto_wrap = sauce_size.c > 0
-        || f_has_save_restore_continuation
-        || (num_long_lines == 1 && stlutils::sizeI(lines) <= 2);
+        || has_ansi_wrapped_line_layout(data, ansi_wrap_width);
       
       auto f_make_blank_cell = [&]()
       {
@@ -630,7 +618,7 @@ namespace t8
       auto f_ensure_cursor_cell = [&](int r, int c)
       {
         while (stlutils::sizeI(rows) <= r)
-          rows.emplace_back();
+          rows.emplace_back().reserve(ansi_wrap_width);
         
         auto& row = rows[r];
         while (stlutils::sizeI(row) <= c)
@@ -655,197 +643,201 @@ namespace t8
         cursor_c = cursor_c % ansi_wrap_width;
       };
       
+      // fb/mat side files are indexed by physical input line and glyph position within that line.
       int input_r = 0;
-      const int num_input_rows = stlutils::sizeI(lines);
-      for (const auto& line : lines)
+      const std::string* fb_row = fb_lines.empty() ? &empty_str_row : &fb_lines[0];
+      const std::string* mat_row = mat_lines.empty() ? &empty_str_row : &mat_lines[0];
+      int fb_pos = 0;
+      int mat_pos = 0;
+      
+      ansi::AnsiCsiSequence ansi_seq;
+      const int num_bytes = static_cast<int>(data.size());
+      for (int i = 0; i < num_bytes; )
       {
-        const auto& fb_row = input_r < stlutils::sizeI(fb_lines) ? fb_lines[input_r] : empty_str_row;
-        const auto& mat_row = input_r < stlutils::sizeI(mat_lines) ? mat_lines[input_r] : empty_str_row;
+        const char ch = data[i];
         
-        size_t byte_idx = 0;
-        char32_t ch32 = utf8::none;
-        int fb_pos = 0;
-        int mat_pos = 0;
+        if (ch == '\n')
+        {
+          // A trailing line break doesn't start a new row.
+          ++i;
+          ++input_r;
+          if (i < num_bytes)
+          {
+            ++cursor_r;
+            cursor_c = 0;
+          }
+          fb_row = input_r < stlutils::sizeI(fb_lines) ? &fb_lines[input_r] : &empty_str_row;
+          mat_row = input_r < stlutils::sizeI(mat_lines) ? &mat_lines[input_r] : &empty_str_row;
+          fb_pos = 0;
+          mat_pos = 0;
+          continue;
+        }
         
-        int len_line = str::lenI(line);
-        for (int i = 0; i < len_line; )
+        // Normalizes DOS/Windows CRLF line endings.
+        if (ch == '\r' && (i + 1 == num_bytes || data[i + 1] == '\n'))
         {
-          byte_idx = static_cast<size_t>(i);
-          
-          if (line[i] == '\033')
+          ++i;
+          continue;
+        }
+        
+        if (ch == '\033')
+        {
+          int next = i;
+          bool handled = ansi::parse_ansi_csi_sequence(data, next, ansi_seq);
+          if (handled)
           {
-            std::vector<int> params;
-            int next = i;
-            if (ansi::parse_ansi_sgr_params(line, next, params))
-            {
-              ansi::apply_ansi_sgr_params(params, fg, bg,
-                                          bright_fg,
-                                          ansi_default_fg,
-                                          ansi_default_bg);
-              i = next;
-              continue;
-            }
-            
-            char cursor_dir = '\0';
-            int cursor_count = 0;
-            next = i;
-            if (ansi::parse_ansi_cursor_move(line, next, cursor_dir, cursor_count))
+            const auto& params = ansi_seq.params;
+            const int param0 = params.empty() ? 0 : params[0];
+            switch (ansi_seq.command)
             {
-              switch (cursor_dir)
-              {
-                case 'A':
-                  cursor_r = std::max(0, cursor_r - cursor_count);
-                  break;
-                case 'B':
-                  cursor_r += cursor_count;
-                  break;
-                case 'C':
-                  cursor_c += cursor_count;
-                  f_wrap_cursor();
-                  break;
-                case 'D':
-                  cursor_c = std::max(0, cursor_c - cursor_count);
-                  break;
-              }
+              case 'm':
+                ansi::apply_ansi_sgr_params(params, fg, bg,
+                                            bright_fg,
+                                            ansi_default_fg,
+                                            ansi_default_bg);
+                break;
               
-              i = next;
-              continue;
-            }
-            
-            char erase_target = '\0';
-            int erase_mode = 0;
-            next = i;
-            if (ansi::parse_ansi_erase(line, next, erase_target, erase_mode))
-            {
-              if (erase_target == 'J' && erase_mode == 2)
-              {
-                rows.clear();
-                cursor_r = 0;
-                cursor_c = 0;
-                has_saved_cursor = false;
-              }
-              else if (erase_target == 'K' && erase_mode == 2)
-              {
-                while (stlutils::sizeI(rows) <= cursor_r)
-                  rows.emplace_back();
-                rows[cursor_r].resize(cursor_c);
-              }
+              case 'A':
+                cursor_r = std::max(0, cursor_r - (params.empty() ? 1 : param0));
+                break;
+              case 'B':
+                cursor_r += params.empty() ? 1 : param0;
+                break;
+              case 'C':
+                cursor_c += params.empty() ? 1 : param0;
+                f_wrap_cursor();
+                break;
+              case 'D':
+                cursor_c = std::max(0, cursor_c - (params.empty() ? 1 : param0));
+                break;
               
-              i = next;
-              continue;
-            }
-            
-            char cursor_save_restore = '\0';
-            next = i;
-            if (ansi::parse_ansi_cursor_save_restore(line, next, cursor_save_restore))
-            {
-              if (cursor_save_restore == 's')
-              {
+              case 'J':
+                if (param0 == 2)
+                {
+                  rows.clear();
+                  cursor_r = 0;
+                  cursor_c = 0;
+                  has_saved_cursor = false;
+                }
+                break;
+              case 'K':
+                if (param0 == 2)
+                {
+                  while (stlutils::sizeI(rows) <= cursor_r)
+                    rows.emplace_back();
+                  rows[cursor_r].resize(cursor_c);
+                }
+                break;
+              
+              case 's':
                 saved_cursor_r = cursor_r;
                 saved_cursor_c = cursor_c;
                 has_saved_cursor = true;
-              }
-              else if (has_saved_cursor)
-              {
-                cursor_r = saved_cursor_r;
-                cursor_c = saved_cursor_c;
-              }
-              
-              i = next;
-              continue;
-            }
-            
-            int cursor_row = 1;
-            int cursor_col = 1;
-            next = i;
-            if (ansi::parse_ansi_cursor_position(line, next, cursor_row, cursor_col))
-            {
-              cursor_r = cursor_row - 1;
-              cursor_c = cursor_col - 1;
-              i = next;
-              continue;
-            }
-            
-            if (verbose)
-            {
-              std::cerr << "ERROR in TextureFileAnsi::load_ansi() : Unsupported ANSI escape sequence";
-              if (i + 1 < len_line && line[i + 1] == '[')
-              {
-                std::cerr << ": \\033[";
-                for (int j = i + 2; j < len_line; ++j)
+                break;
+              case 'u':
+                if (has_saved_cursor)
                 {
-                  char ch = line[j];
-                  if (str::is_printable_ascii(ch))
-                    std::cerr << ch;
-                  else
-                    std::cerr << "0x" << str::int2hex(ch);
-                  
-                  if ('@' <= ch && ch <= '~')
-                    break;
+                  cursor_r = saved_cursor_r;
+                  cursor_c = saved_cursor_c;
                 }
-                std::cerr << ".";
-              }
-              std::cerr << "\n";
+                break;
+              
+              case 'H':
+              case 'f':
+                // Coordinates are 1-based.
+                cursor_r = params.empty() || param0 <= 0 ? 0 : param0 - 1;
+                cursor_c = params.size() < 2 || params[1] <= 0 ? 0 : params[1] - 1;
+                break;
+              
+              default:
+                handled = false;
+                break;
             }
-            return false;
           }
           
-          bool decoded = false;
+          if (handled)
+          {
+            i = next;
+            continue;
+          }
           
-          unsigned char b = static_cast<unsigned char>(line[i]);
-          if (glyph_encoding == AnsiLoadGlyphEncoding::UTF8)
+          if (verbose)
           {
-            if (b < 0x20)
-            {
-              ch32 = U' ';
-              ++i;
-              decoded = true;
-            }
-            else
+            std::cerr << "ERROR in TextureFileAnsi::load_ansi() : Unsupported ANSI escape sequence";
+            if (i + 1 < num_bytes && data[i + 1] == '[')
             {
-              decoded = utf8::decode_next_utf8_char32(line, ch32, byte_idx);
-              i = static_cast<int>(byte_idx);
+              std::cerr << ": \\033[";
+              for (int j = i + 2; j < num_bytes && data[j] != '\n'; ++j)
+              {
+                char ch_j = data[j];
+                if (str::is_printable_ascii(ch_j))
+                  std::cerr << ch_j;
+                else
+                  std::cerr << "0x" << str::int2hex(ch_j);
+                
+                if ('@' <= ch_j && ch_j <= '~')
+                  break;
+              }
+              std::cerr << ".";
             }
+            std::cerr << "\n";
           }
-          else if (glyph_encoding == AnsiLoadGlyphEncoding::CP437)
+          return false;
+        }
+        
+        bool decoded = false;
+        char32_t ch32 = utf8::none;
+        
+        unsigned char b = static_cast<unsigned char>(ch);
+        if (glyph_encoding == AnsiLoadGlyphEncoding::UTF8)
+        {
+          if (b < 0x20)
           {
-            auto cp = utf8::cp437_to_unicode(b);
-            if (cp.has_value())
-            {
-              ch32 = cp.value();
-              ++i;
-              decoded = true;
-            }
+            ch32 = U' ';
+            ++i;
+            decoded = true;
           }
-          
-          if (!decoded)
-            return false;
-          
-          Cell cell;
-          const auto fb = fb_pos < str::lenI(fb_row) ? fb_row[fb_pos] : Glyph::none;
-          ++fb_pos;
-          if (!create_glyph_from_ansi(ch32, fb, cell.glyph, verbose))
+          else
           {
-            if (verbose)
-              std::cerr << "ERROR in TextureFileAnsi::load_ansi() : Unable to create glyph object from ANSI file unicode bytes.\n";
-            return false;
+            size_t byte_idx = static_cast<size_t>(i);
+            decoded = utf8::decode_next_utf8_char32(data, ch32, byte_idx);
+            i = static_cast<int>(byte_idx);
+          }
+        }
+        else if (glyph_encoding == AnsiLoadGlyphEncoding::CP437)
+        {
+          auto cp = utf8::cp437_to_unicode(b);
+          if (cp.has_value())
+          {
+            ch32 = cp.value();
+            ++i;
+            decoded = true;
           }
-          cell.mat_raw = texture::str_to_raw_mat(mat_row, mat_pos);
-          cell.fg = fg;
-          cell.bg = bg;
-          
-          f_ensure_cursor_cell(cursor_r, cursor_c);
-          rows[cursor_r][cursor_c] = cell;
-          ++cursor_c;
-          f_wrap_cursor();
         }
         
-        ++input_r;
-        if (input_r < num_input_rows)
+        if (!decoded)
         {
-          ++cursor_r;
-          cursor_c = 0;
+          if (verbose)
+            std::cerr << "ERROR in TextureFileAnsi::load_ansi() : Unable to decode the char at byte offset " << i << ".\n";
+          return false;
+        }
+        
+        f_ensure_cursor_cell(cursor_r, cursor_c);
+        auto& cell = rows[cursor_r][cursor_c];
+        const auto fb = fb_pos < str::lenI(*fb_row) ? (*fb_row)[fb_pos] : Glyph::none;
+        ++fb_pos;
+        if (!create_glyph_from_ansi(ch32, fb, cell.glyph, verbose))
+        {
+          if (verbose)
+            std::cerr << "ERROR in TextureFileAnsi::load_ansi() : Unable to create glyph object from ANSI file unicode bytes.\n";
+          return false;
         }
+        cell.mat_raw = texture::str_to_raw_mat(*mat_row, mat_pos);
+        cell.fg = fg;
+        cell.bg = bg;
+        
+        ++cursor_c;
+        f_wrap_cursor();
       }
       
       int num_rows = stlutils::sizeI(rows);
@@ -0,0 +1,308 @@
+//
+//  TextureFileBin.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "../Texture.h"
+#include "MappedFile.h"
+#include "ByteCompression.h"
+#include <fstream>
+#include <cstring>
+#include <climits>
+
+
+namespace t8
+{
+  
+  // Read-only view of the planes of an uncompressed binary texture.
+  // The pointers refer directly into the memory mapped file, so no parsing or copying takes place.
+  struct TextureView
+  {
+    int ver = 10;
+    RC size;
+    int area = 0;
+    const uint32_t* glyphs_preferred = nullptr;
+    const int16_t* fg_colors = nullptr;
+    const int16_t* bg_colors = nullptr;
+    const uint8_t* glyphs_fallback = nullptr;
+    const uint8_t* materials_raw = nullptr;
+    
+    bool valid() const { return glyphs_preferred != nullptr; }
+    
+    inline int index(int r, int c) const noexcept
+    {
+      return r * size.c + c;
+    }
+    
+    Textel operator()(int r, int c) const
+    {
+      if (!valid() || r < 0 || size.r <= r || c < 0 || size.c <= c)
+        return {};
+      Textel tex;
+      int idx = index(r, c);
+      tex.glyph = Glyph { static_cast<char32_t>(glyphs_preferred[idx]), static_cast<char>(glyphs_fallback[idx]) };
+      tex.fg_color = Color(fg_colors[idx]);
+      tex.bg_color = Color(bg_colors[idx]);
+      tex.mat_raw = materials_raw[idx];
+      return tex;
+    }
+    
+    Textel operator()(const RC& pos) const
+    {
+      return operator()(pos.r, pos.c);
+    }
+    
+    Texture to_texture() const
+    {
+      Texture tex { size };
+      tex.ver = ver;
+      if (!valid())
+        return tex;
+      for (int idx = 0; idx < area; ++idx)
+      {
+        tex.glyphs[idx] = Glyph { static_cast<char32_t>(glyphs_preferred[idx]), static_cast<char>(glyphs_fallback[idx]) };
+        tex.fg_colors[idx] = Color(fg_colors[idx]);
+        tex.bg_colors[idx] = Color(bg_colors[idx]);
+      }
+      std::memcpy(tex.materials_raw.data(), materials_raw, static_cast<size_t>(area));
+      return tex;
+    }
+  };
+  
+  // Keeps the mapping alive for as long as the view is used.
+  struct MappedTexture
+  {
+    MappedFile file;
+    TextureView view;
+  };
+  
+  // Binary texture format (.txb):
+  //   64 byte header followed by the planes, optionally compressed as one block:
+  //   u32 glyph preferred[area], i16 fg color[area], i16 bg color[area],
+  //   u8 glyph fallback[area], u8 raw material[area].
+  // Numbers are stored in host byte order, which is verified via a byte order mark.
+  class TextureFileBin
+  {
+    static constexpr char c_magic[8] = { 'T', '8', 'T', 'X', 'B', 'I', 'N', '\0' };
+    static constexpr uint32_t c_format_version = 1;
+    static constexpr uint32_t c_byte_order_mark = 0x01020304;
+    static constexpr uint32_t c_flag_compressed = 1;
+    
+    struct Header
+    {
+      char magic[8];
+      uint32_t format_version = c_format_version;
+      uint32_t flags = 0;
+      uint32_t byte_order_mark = c_byte_order_mark;
+      int32_t tex_ver = 10;
+      int32_t rows = 0;
+      int32_t cols = 0;
+      uint64_t planes_size = 0;
+      uint64_t stored_size = 0;
+      uint8_t reserved[16] = {};
+    };
+    static_assert(sizeof(Header) == 64, "Unexpected padding in TextureFileBin::Header.");
+    
+    static size_t calc_planes_size(int area)
+    {
+      return static_cast<size_t>(area) * (sizeof(uint32_t) + 2*sizeof(int16_t) + 2*sizeof(uint8_t));
+    }
+    
+    static void write_planes(const Texture& tex, uint8_t* dst)
+    {
+      const auto area = static_cast<size_t>(tex.area);
+      auto* preferred = dst;
+      auto* fg = preferred + area*sizeof(uint32_t);
+      auto* bg = fg + area*sizeof(int16_t);
+      auto* fallback = bg + area*sizeof(int16_t);
+      auto* mats = fallback + area;
+      for (size_t idx = 0; idx < area; ++idx)
+      {
+        auto cp = static_cast<uint32_t>(tex.glyphs[idx].preferred);
+        auto fg_idx = static_cast<int16_t>(tex.fg_colors[idx].get_index());
+        auto bg_idx = static_cast<int16_t>(tex.bg_colors[idx].get_index());
+        std::memcpy(preferred + idx*sizeof(uint32_t), &cp, sizeof(cp));
+        std::memcpy(fg + idx*sizeof(int16_t), &fg_idx, sizeof(fg_idx));
+        std::memcpy(bg + idx*sizeof(int16_t), &bg_idx, sizeof(bg_idx));
+        fallback[idx] = static_cast<uint8_t>(tex.glyphs[idx].fallback);
+      }
+      std::memcpy(mats, tex.materials_raw.data(), area);
+    }
+    
+    static void set_view_planes(TextureView& view, const uint8_t* planes)
+    {
+      const auto area = static_cast<size_t>(view.area);
+      view.glyphs_preferred = reinterpret_cast<const uint32_t*>(planes);
+      view.fg_colors = reinterpret_cast<const int16_t*>(planes + area*sizeof(uint32_t));
+      view.bg_colors = view.fg_colors + area;
+      view.glyphs_fallback = reinterpret_cast<const uint8_t*>(view.bg_colors + area);
+      view.materials_raw = view.glyphs_fallback + area;
+    }
+    
+    // area is rows*cols, checked to fit in an int.
+    static bool read_header(Header& hdr, int& area, const uint8_t* data, size_t size, const std::string& file_path)
+    {
+      if (size < sizeof(Header))
+      {
+        std::cerr << "ERROR in TextureFileBin::read_header() : File \"" << file_path << "\" is too small.\n";
+        return false;
+      }
+      std::memcpy(&hdr, data, sizeof(Header));
+      if (std::memcmp(hdr.magic, c_magic, sizeof(c_magic)) != 0)
+      {
+        std::cerr << "ERROR in TextureFileBin::read_header() : File \"" << file_path << "\" is not a binary texture file.\n";
+        return false;
+      }
+      if (hdr.byte_order_mark != c_byte_order_mark)
+      {
+        std::cerr << "ERROR in TextureFileBin::read_header() : File \"" << file_path << "\" has an incompatible byte order.\n";
+        return false;
+      }
+      if (hdr.format_version > c_format_version)
+      {
+        std::cerr << "ERROR in TextureFileBin::read_header() : Incompatible binary format version: version = " << hdr.format_version << '\n';
+        return false;
+      }
+      if (hdr.tex_ver > Texture::compatible_version_until_and_including)
+      {
+        std::cerr << "ERROR in TextureFileBin::read_header() : Incompatible texture version: version = " << hdr.tex_ver << '\n';
+        return false;
+      }
+      const int64_t area64 = static_cast<int64_t>(hdr.rows) * static_cast<int64_t>(hdr.cols);
+      if (hdr.rows < 0 || hdr.cols < 0 || area64 > INT_MAX
+          || hdr.planes_size != calc_planes_size(static_cast<int>(area64))
+          || hdr.stored_size != size - sizeof(Header)
+          || ((hdr.flags & c_flag_compressed) == 0 && hdr.stored_size != hdr.planes_size))
+      {
+        std::cerr << "ERROR in TextureFileBin::read_header() : File \"" << file_path << "\" is truncated or corrupt.\n";
+        return false;
+      }
+      area = static_cast<int>(area64);
+      return true;
+    }
+  
+  public:
+    static bool load_bin(Texture& tex, const std::string& file_path)
+    {
+      MappedFile file;
+      if (!file.open(file_path))
+        return false;
+      return load_bin(tex, file.data(), file.size(), file_path);
+    }
+    
+    // Loads from a memory block holding a whole binary texture file, e.g. an entry of an asset pack.
+    // source_name is only used for error messages.
+    static bool load_bin(Texture& tex, const uint8_t* data, size_t size, const std::string& source_name)
+    {
+      Header hdr;
+      int area = 0;
+      if (!read_header(hdr, area, data, size, source_name))
+        return false;
+      
+      const uint8_t* planes = data + sizeof(Header);
+      std::vector<uint8_t> planes_buffer;
+      if ((hdr.flags & c_flag_compressed) != 0)
+      {
+        planes_buffer.resize(hdr.planes_size);
+        if (!byte_compression::decompress(planes, hdr.stored_size, planes_buffer.data(), planes_buffer.size()))
+        {
+          std::cerr << "ERROR in TextureFileBin::load_bin() : Corrupt compressed data in \"" << source_name << "\".\n";
+          return false;
+        }
+        planes = planes_buffer.data();
+      }
+      else if (reinterpret_cast<uintptr_t>(planes) % alignof(uint32_t) != 0)
+      {
+        planes_buffer.assign(planes, planes + hdr.planes_size);
+        planes = planes_buffer.data();
+      }
+      
+      TextureView view;
+      view.ver = hdr.tex_ver;
+      view.size = { hdr.rows, hdr.cols };
+      view.area = area;
+      if (view.area > 0)
+        set_view_planes(view, planes);
+      tex = view.to_texture();
+      return true;
+    }
+    
+    // Zero-copy: the view points into the mapped file. Only works for uncompressed files.
+    static bool open_view(MappedTexture& mapped_tex, const std::string& file_path)
+    {
+      mapped_tex.view = {};
+      if (!mapped_tex.file.open(file_path))
+        return false;
+      
+      Header hdr;
+      int area = 0;
+      if (!read_header(hdr, area, mapped_tex.file.data(), mapped_tex.file.size(), file_path))
+      {
+        mapped_tex.file.close();
+        return false;
+      }
+      if ((hdr.flags & c_flag_compressed) != 0)
+      {
+        std::cerr << "ERROR in TextureFileBin::open_view() : File \"" << file_path << "\" is compressed. Use load_bin() instead.\n";
+        mapped_tex.file.close();
+        return false;
+      }
+      
+      auto& view = mapped_tex.view;
+      view.ver = hdr.tex_ver;
+      view.size = { hdr.rows, hdr.cols };
+      view.area = area;
+      if (view.area > 0)
+        set_view_planes(view, mapped_tex.file.data() + sizeof(Header));
+      return true;
+    }
+    
+    // Serializes a whole binary texture file into bytes.
+    static void save_bin(const Texture& tex, std::vector<uint8_t>& bytes, bool compress = false)
+    {
+      Header hdr;
+      std::memcpy(hdr.magic, c_magic, sizeof(c_magic));
+      hdr.tex_ver = tex.ver;
+      hdr.rows = tex.size.r;
+      hdr.cols = tex.size.c;
+      hdr.planes_size = calc_planes_size(tex.area);
+      
+      std::vector<uint8_t> planes(hdr.planes_size);
+      write_planes(tex, planes.data());
+      if (compress)
+      {
+        auto compressed = byte_compression::compress(planes.data(), planes.size());
+        if (compressed.size() < planes.size())
+        {
+          hdr.flags |= c_flag_compressed;
+          planes = std::move(compressed);
+        }
+      }
+      hdr.stored_size = planes.size();
+      
+      bytes.resize(sizeof(Header) + planes.size());
+      std::memcpy(bytes.data(), &hdr, sizeof(Header));
+      if (!planes.empty())
+        std::memcpy(bytes.data() + sizeof(Header), planes.data(), planes.size());
+    }
+    
+    static bool save_bin(const Texture& tex, const std::string& file_path, bool compress = false)
+    {
+      std::vector<uint8_t> bytes;
+      save_bin(tex, bytes, compress);
+      
+      std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+      if (!file)
+      {
+        std::cerr << "ERROR in TextureFileBin::save_bin() : Unable to open file \"" << file_path << "\" for writing.\n";
+        return false;
+      }
+      file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+      return static_cast<bool>(file);
+    }
+  };
+
+}
@@ -43,13 +43,8 @@ namespace t8x
       cmax = cmin + static_cast<T>(rectangle.c_len - offs());
     }
     
-    AABB(const AABB& aabb)
-    {
-      rmin = aabb.rmin;
-      cmin = aabb.cmin;
-      rmax = aabb.rmax;
-      cmax = aabb.cmax;
-    }
+    // Defaulted so that AABB stays trivially copyable (e.g. for StateWriter).
+    AABB(const AABB& aabb) = default;
     
     std::pair<T, T> p0() const { return { rmin, cmin }; }
     
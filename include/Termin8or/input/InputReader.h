@@ -0,0 +1,201 @@
+//
+//  InputReader.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "KeyDecoder.h"
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <conio.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <array>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <variant>
+#include <vector>
+#include <cstddef>
+
+
+namespace t8
+{
+  
+  // Lock-free single producer / single consumer ring buffer.
+  // try_push() must only be called from one thread and try_pop() from one (other) thread.
+  template<typename T, size_t Capacity>
+  class SpscRing
+  {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "ERROR in SpscRing : Capacity must be a power of two.");
+    
+    std::array<T, Capacity> m_items {};
+    alignas(64) std::atomic<size_t> m_head = 0; // Next slot to pop.
+    alignas(64) std::atomic<size_t> m_tail = 0; // Next slot to push.
+  
+  public:
+    bool try_push(const T& item)
+    {
+      const auto tail = m_tail.load(std::memory_order_relaxed);
+      if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+        return false;
+      m_items[tail & (Capacity - 1)] = item;
+      m_tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+    
+    bool try_pop(T& item)
+    {
+      const auto head = m_head.load(std::memory_order_relaxed);
+      if (head == m_tail.load(std::memory_order_acquire))
+        return false;
+      item = m_items[head & (Capacity - 1)];
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+    
+    // Only exact when called from the producer or the consumer thread.
+    size_t size() const
+    {
+      return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+  };
+  
+  // Reads stdin on a separate thread, so that input is drained in bulk as soon as it arrives,
+  //   independent of the frame rate. The decoded and timestamped key events are handed over
+  //   to the main thread through a lock-free SPSC ring. Expects the terminal to be in raw mode
+  //   (see StreamKeyboard).
+  class InputReader
+  {
+    static constexpr size_t c_queue_capacity = 1024;
+    
+    SpscRing<KeyEvent, c_queue_capacity> m_queue;
+    std::thread m_thread;
+    std::atomic<bool> m_stop = false;
+    std::atomic<int> m_num_dropped = 0;
+    
+    void push(const KeyEvent& event)
+    {
+      if (!m_queue.try_push(event))
+        m_num_dropped++;
+    }
+    
+    void reader_loop()
+    {
+      auto f_emit = [this](const KeyEvent& event) { push(event); };
+#ifdef _WIN32
+      while (!m_stop.load(std::memory_order_relaxed))
+      {
+        if (!_kbhit())
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          continue;
+        }
+        auto now = KeyEventClock::now();
+        int ch = _getch();
+        switch (ch)
+        {
+          case 224: // Special keys
+            switch (_getch())
+            {
+              case 75: f_emit({ SpecialKey::Left, now }); break;
+              case 77: f_emit({ SpecialKey::Right, now }); break;
+              case 72: f_emit({ SpecialKey::Up, now }); break;
+              case 80: f_emit({ SpecialKey::Down, now }); break;
+            }
+            break;
+          case 27: f_emit({ SpecialKey::Escape, now }); break;
+          case 13: f_emit({ SpecialKey::Enter, now }); break;
+          case 9: f_emit({ SpecialKey::Tab, now }); break;
+          case 8: f_emit({ SpecialKey::Backspace, now }); break;
+          default:
+            if (ch >= 32 && ch <= 126)
+              f_emit({ static_cast<char>(ch), now });
+            else
+              f_emit({ SpecialKey::None, now });
+            break;
+        }
+      }
+#else
+      KeyByteDecoder decoder;
+      std::array<unsigned char, 256> buf;
+      pollfd pfd { STDIN_FILENO, POLLIN, 0 };
+      while (!m_stop.load(std::memory_order_relaxed))
+      {
+        // Short timeout so that stop() and pending escapes are handled promptly.
+        int result = poll(&pfd, 1, 10);
+        auto now = KeyEventClock::now();
+        if (result > 0 && (pfd.revents & POLLIN) != 0)
+        {
+          auto num_read = read(STDIN_FILENO, buf.data(), buf.size());
+          if (num_read > 0)
+            decoder.feed(buf.data(), static_cast<int>(num_read), now, f_emit);
+          else // EOF (e.g. piped input), don't spin on it.
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        decoder.flush(now, f_emit);
+      }
+#endif
+    }
+  
+  public:
+    InputReader() = default;
+    ~InputReader()
+    {
+      stop();
+    }
+    
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+    
+    void start()
+    {
+      if (m_thread.joinable())
+        return;
+      m_stop = false;
+      m_thread = std::thread(&InputReader::reader_loop, this);
+    }
+    
+    void stop()
+    {
+      m_stop = true;
+      if (m_thread.joinable())
+        m_thread.join();
+    }
+    
+    bool is_running() const { return m_thread.joinable(); }
+    
+    // Consumer side. Must only be called from one thread.
+    bool pop(KeyEvent& event)
+    {
+      return m_queue.try_pop(event);
+    }
+    
+    // Appends all queued events to events. Returns the number of events appended.
+    int drain(std::vector<KeyEvent>& events)
+    {
+      int num = 0;
+      KeyEvent event;
+      while (m_queue.try_pop(event))
+      {
+        events.emplace_back(event);
+        num++;
+      }
+      return num;
+    }
+    
+    // Events lost because the queue was full.
+    int num_dropped() const { return m_num_dropped; }
+  };
+
+}
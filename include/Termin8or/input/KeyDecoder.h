@@ -0,0 +1,447 @@
+//
+//  KeyDecoder.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "KeyboardEnums.h"
+#include <array>
+#include <chrono>
+#include <variant>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <algorithm>
+
+
+namespace t8
+{
+  
+  using KeyEventClock = std::chrono::steady_clock;
+  
+  enum class KeyEventType { Key, Mouse, Paste };
+  
+  // Bits of KeyEvent::modifiers. Same bit order as the xterm modifier parameter minus one.
+  enum class KeyMod : uint8_t
+  {
+    None = 0,
+    Shift = 1,
+    Alt = 2,
+    Ctrl = 4,
+    Meta = 8,
+  };
+  
+  inline bool has_key_mod(uint8_t modifiers, KeyMod mod)
+  {
+    return (modifiers & static_cast<uint8_t>(mod)) != 0;
+  }
+  
+  // Only the kitty keyboard protocol reports Repeat and Release, legacy terminals send
+  //   Press for each auto-repeat as well.
+  enum class KeyAction : uint8_t { Press, Repeat, Release };
+  
+  enum class MouseButton { None, Left, Middle, Right, WheelUp, WheelDown };
+  enum class MouseAction { Press, Release, Move };
+  
+  struct MouseEvent
+  {
+    MouseButton button = MouseButton::None;
+    MouseAction action = MouseAction::Press;
+    int r = 0; // Zero-based screen row.
+    int c = 0; // Zero-based screen column.
+  };
+  
+  struct KeyEvent
+  {
+    std::variant<SpecialKey, char> key = SpecialKey::None;
+    KeyEventClock::time_point time;
+    KeyEventType type = KeyEventType::Key;
+    uint8_t modifiers = 0; // KeyMod bits.
+    KeyAction action = KeyAction::Press;
+    MouseEvent mouse; // If type == KeyEventType::Mouse.
+    std::string paste_text; // If type == KeyEventType::Paste.
+  };
+  
+  namespace key_decoder
+  {
+    struct KeyCode
+    {
+      SpecialKey key = SpecialKey::None;
+      char ch = 0;
+      uint8_t modifiers = 0;
+    };
+    
+    // Single bytes outside of escape sequences.
+    inline constexpr std::array<KeyCode, 128> c_byte_keys = []()
+    {
+      std::array<KeyCode, 128> tbl {};
+      for (int c = 32; c <= 126; ++c)
+        tbl[c].ch = static_cast<char>(c);
+      tbl[9].key = SpecialKey::Tab;
+      tbl[10].key = SpecialKey::Enter;
+      tbl[13].key = SpecialKey::Enter;
+      tbl[8].key = SpecialKey::Backspace;
+      tbl[127].key = SpecialKey::Backspace;
+      return tbl;
+    }();
+    
+    // Final bytes 0x40-0x7F of CSI sequences (ESC [ ... <final>) and SS3 sequences (ESC O <final>).
+    inline constexpr std::array<KeyCode, 64> c_final_byte_keys = []()
+    {
+      std::array<KeyCode, 64> tbl {};
+      tbl['A' - 0x40].key = SpecialKey::Up;
+      tbl['B' - 0x40].key = SpecialKey::Down;
+      tbl['C' - 0x40].key = SpecialKey::Right;
+      tbl['D' - 0x40].key = SpecialKey::Left;
+      tbl['H' - 0x40].key = SpecialKey::Home;
+      tbl['F' - 0x40].key = SpecialKey::End;
+      tbl['P' - 0x40].key = SpecialKey::F1;
+      tbl['Q' - 0x40].key = SpecialKey::F2;
+      tbl['R' - 0x40].key = SpecialKey::F3;
+      tbl['S' - 0x40].key = SpecialKey::F4;
+      tbl['Z' - 0x40] = { SpecialKey::Tab, 0, static_cast<uint8_t>(KeyMod::Shift) }; // Back tab.
+      tbl['M' - 0x40].key = SpecialKey::Enter; // SS3 keypad Enter.
+      return tbl;
+    }();
+    
+    // First parameter of CSI sequences ending with '~' (VT style).
+    inline constexpr std::array<KeyCode, 25> c_tilde_keys = []()
+    {
+      std::array<KeyCode, 25> tbl {};
+      tbl[1].key = SpecialKey::Home;
+      tbl[2].key = SpecialKey::Insert;
+      tbl[3].key = SpecialKey::Delete;
+      tbl[4].key = SpecialKey::End;
+      tbl[5].key = SpecialKey::PageUp;
+      tbl[6].key = SpecialKey::PageDown;
+      tbl[7].key = SpecialKey::Home;
+      tbl[8].key = SpecialKey::End;
+      tbl[11].key = SpecialKey::F1;
+      tbl[12].key = SpecialKey::F2;
+      tbl[13].key = SpecialKey::F3;
+      tbl[14].key = SpecialKey::F4;
+      tbl[15].key = SpecialKey::F5;
+      tbl[17].key = SpecialKey::F6;
+      tbl[18].key = SpecialKey::F7;
+      tbl[19].key = SpecialKey::F8;
+      tbl[20].key = SpecialKey::F9;
+      tbl[21].key = SpecialKey::F10;
+      tbl[23].key = SpecialKey::F11;
+      tbl[24].key = SpecialKey::F12;
+      return tbl;
+    }();
+    
+    inline constexpr std::string_view c_paste_end = "\x1b[201~";
+    
+    // Kitty keyboard protocol (ESC [ code ; modifiers : event-type u). Functional keys that
+    //   have no legacy encoding (keypad, modifier keys etc.) use codes in the Unicode private use
+    //   area and are dropped.
+    inline constexpr KeyCode get_kitty_key(int code)
+    {
+      KeyCode kc;
+      switch (code)
+      {
+        case 9: kc.key = SpecialKey::Tab; break;
+        case 13: kc.key = SpecialKey::Enter; break;
+        case 27: kc.key = SpecialKey::Escape; break;
+        case 127: kc.key = SpecialKey::Backspace; break;
+        default:
+          if (32 <= code && code <= 126)
+            kc.ch = static_cast<char>(code);
+          break;
+      }
+      return kc;
+    }
+  }
+  
+  // Table-driven decoder (a small state machine) for raw terminal input bytes.
+  // Handles CSI and SS3 key sequences incl. xterm modifier parameters (e.g. ESC [ 1 ; 5 D is
+  //   Ctrl + Left), Alt + key as ESC <key>, bracketed paste (ESC [ 200 ~ ... ESC [ 201 ~) and
+  //   SGR 1006 mouse reports (ESC [ < b ; x ; y M/m).
+  // Also decodes the kitty keyboard protocol (progressive enhancement flags 1, 2, 4 and 8, see
+  //   StreamKeyboard::enable_kitty_keyboard()), which adds KeyAction::Repeat and
+  //   KeyAction::Release events.
+  // Bytes can be fed in arbitrary chunks, a sequence that is split between two reads is
+  //   completed by the next feed(). An unfinished sequence is resolved by flush() once
+  //   c_escape_timeout has passed without any further bytes, e.g. a lone ESC becomes
+  //   SpecialKey::Escape.
+  class KeyByteDecoder
+  {
+    enum class State { Ground, Esc, Csi, Ss3, Paste };
+    
+    static constexpr int c_max_params = 8;
+    static constexpr int c_max_param_val = 99'999;
+    static constexpr size_t c_max_paste_size = 1 << 20;
+    
+    State m_state = State::Ground;
+    KeyEventClock::time_point m_seq_time;
+    std::array<int, c_max_params> m_params {};
+    std::array<int, c_max_params> m_sub_params {}; // First ':' sub-parameter of each parameter or -1.
+    int m_num_params = 0;
+    int m_sub_param_idx = 0; // 0 : In the parameter itself, 1 : In its first sub-parameter etc.
+    char m_private_marker = 0;
+    std::string m_paste;
+    
+    template<typename EmitF>
+    static void emit_key(const key_decoder::KeyCode& kc, uint8_t modifiers,
+                         KeyEventClock::time_point time, EmitF&& emit,
+                         KeyAction action = KeyAction::Press)
+    {
+      KeyEvent event;
+      if (kc.ch != 0)
+        event.key = kc.ch;
+      else
+        event.key = kc.key;
+      event.time = time;
+      event.modifiers = kc.modifiers | modifiers;
+      event.action = action;
+      emit(event);
+    }
+    
+    template<typename EmitF>
+    static void emit_byte(unsigned char c, uint8_t modifiers, KeyEventClock::time_point time, EmitF&& emit)
+    {
+      static const key_decoder::KeyCode no_key;
+      emit_key(c < key_decoder::c_byte_keys.size() ? key_decoder::c_byte_keys[c] : no_key, modifiers, time, emit);
+    }
+    
+    uint8_t get_param_modifiers(int param_idx) const
+    {
+      if (param_idx >= m_num_params || m_params[param_idx] <= 1)
+        return 0;
+      return static_cast<uint8_t>((m_params[param_idx] - 1) & 0xF);
+    }
+    
+    // Kitty event type sub-parameter: 1 = press, 2 = repeat, 3 = release.
+    KeyAction get_param_action(int param_idx) const
+    {
+      if (param_idx >= m_num_params)
+        return KeyAction::Press;
+      switch (m_sub_params[param_idx])
+      {
+        case 2: return KeyAction::Repeat;
+        case 3: return KeyAction::Release;
+        default: return KeyAction::Press;
+      }
+    }
+    
+    template<typename EmitF>
+    void emit_kitty_key(EmitF&& emit) const
+    {
+      const auto modifiers = get_param_modifiers(1);
+      // With flag 4 the shifted key is reported as a sub-parameter of the key code.
+      int code = m_num_params > 0 ? m_params[0] : 0;
+      if (has_key_mod(modifiers, KeyMod::Shift) && m_sub_params[0] > 0)
+        code = m_sub_params[0];
+      const auto kc = key_decoder::get_kitty_key(code);
+      if (kc.ch != 0 || kc.key != SpecialKey::None)
+        emit_key(kc, modifiers, m_seq_time, emit, get_param_action(1));
+    }
+    
+    template<typename EmitF>
+    void emit_mouse(char final_byte, EmitF&& emit) const
+    {
+      if (m_num_params < 3)
+        return;
+      const int b = m_params[0];
+      KeyEvent event;
+      event.time = m_seq_time;
+      event.type = KeyEventType::Mouse;
+      event.mouse.r = m_params[2] - 1;
+      event.mouse.c = m_params[1] - 1;
+      if ((b & 4) != 0)
+        event.modifiers |= static_cast<uint8_t>(KeyMod::Shift);
+      if ((b & 8) != 0)
+        event.modifiers |= static_cast<uint8_t>(KeyMod::Alt);
+      if ((b & 16) != 0)
+        event.modifiers |= static_cast<uint8_t>(KeyMod::Ctrl);
+      if ((b & 64) != 0)
+        event.mouse.button = (b & 1) != 0 ? MouseButton::WheelDown : MouseButton::WheelUp;
+      else
+      {
+        static constexpr MouseButton buttons[4] = { MouseButton::Left, MouseButton::Middle, MouseButton::Right, MouseButton::None };
+        event.mouse.button = buttons[b & 3];
+        if ((b & 32) != 0)
+          event.mouse.action = MouseAction::Move;
+        else if (final_byte == 'm')
+          event.mouse.action = MouseAction::Release;
+      }
+      emit(event);
+    }
+    
+    template<typename EmitF>
+    void dispatch_csi(char final_byte, EmitF&& emit)
+    {
+      m_state = State::Ground;
+      if (m_private_marker == '<' && (final_byte == 'M' || final_byte == 'm'))
+      {
+        emit_mouse(final_byte, emit);
+        return;
+      }
+      if (final_byte == 'u')
+      {
+        if (m_private_marker == 0) // Skip replies to kitty protocol queries.
+          emit_kitty_key(emit);
+        return;
+      }
+      if (final_byte == '~')
+      {
+        const int p0 = m_num_params > 0 ? m_params[0] : 0;
+        if (p0 == 200)
+        {
+          m_paste.clear();
+          m_state = State::Paste;
+        }
+        else if (0 <= p0 && p0 < static_cast<int>(key_decoder::c_tilde_keys.size()))
+          emit_key(key_decoder::c_tilde_keys[p0], get_param_modifiers(1), m_seq_time, emit, get_param_action(1));
+        else if (p0 != 201)
+          emit_key({}, 0, m_seq_time, emit);
+        return;
+      }
+      emit_key(key_decoder::c_final_byte_keys[final_byte - 0x40], get_param_modifiers(1), m_seq_time, emit,
+               get_param_action(1));
+    }
+    
+    // Returns false if c didn't belong to the current sequence and has to be decoded again.
+    template<typename EmitF>
+    bool consume(unsigned char c, KeyEventClock::time_point time, EmitF&& emit)
+    {
+      switch (m_state)
+      {
+        case State::Ground:
+          if (c == 27)
+          {
+            m_state = State::Esc;
+            m_seq_time = time;
+          }
+          else
+            emit_byte(c, 0, time, emit);
+          return true;
+        
+        case State::Esc:
+          if (c == '[' || c == 'O')
+          {
+            m_state = c == '[' ? State::Csi : State::Ss3;
+            m_params.fill(0);
+            m_sub_params.fill(-1);
+            m_num_params = 0;
+            m_sub_param_idx = 0;
+            m_private_marker = 0;
+          }
+          else if (c == 27)
+          {
+            emit_key({ SpecialKey::Escape }, 0, m_seq_time, emit);
+            m_seq_time = time;
+          }
+          else
+          {
+            emit_byte(c, static_cast<uint8_t>(KeyMod::Alt), m_seq_time, emit);
+            m_state = State::Ground;
+          }
+          return true;
+        
+        case State::Csi:
+          if ('0' <= c && c <= '9')
+          {
+            if (m_num_params == 0)
+              m_num_params = 1;
+            if (m_sub_param_idx == 0)
+            {
+              auto& param = m_params[m_num_params - 1];
+              param = std::min(param * 10 + (c - '0'), c_max_param_val);
+            }
+            else if (m_sub_param_idx == 1)
+            {
+              auto& sub_param = m_sub_params[m_num_params - 1];
+              sub_param = std::min(std::max(sub_param, 0) * 10 + (c - '0'), c_max_param_val);
+            }
+          }
+          else if (c == ';')
+          {
+            if (m_num_params == 0)
+              m_num_params = 1;
+            if (m_num_params < c_max_params)
+              m_params[m_num_params++] = 0;
+            m_sub_param_idx = 0;
+          }
+          else if (c == ':') // Only the first sub-parameter is kept.
+          {
+            if (m_num_params == 0)
+              m_num_params = 1;
+            m_sub_param_idx++;
+          }
+          else if (0x3C <= c && c <= 0x3F) // Private marker '<', '=', '>' or '?'.
+            m_private_marker = static_cast<char>(c);
+          else if (0x40 <= c && c <= 0x7E)
+            dispatch_csi(static_cast<char>(c), emit);
+          else if (c < 0x20 || c > 0x2F) // Intermediate bytes 0x20-0x2F don't change the key.
+          {
+            m_state = State::Ground; // Broken sequence.
+            return false;
+          }
+          return true;
+        
+        case State::Ss3:
+          m_state = State::Ground;
+          if (0x40 <= c && c <= 0x7E)
+          {
+            emit_key(key_decoder::c_final_byte_keys[c - 0x40], 0, m_seq_time, emit);
+            return true;
+          }
+          return false;
+        
+        case State::Paste:
+          m_paste += static_cast<char>(c);
+          if (m_paste.size() >= key_decoder::c_paste_end.size()
+              && std::string_view(m_paste).substr(m_paste.size() - key_decoder::c_paste_end.size()) == key_decoder::c_paste_end)
+          {
+            m_paste.resize(m_paste.size() - key_decoder::c_paste_end.size());
+            KeyEvent event;
+            event.time = m_seq_time;
+            event.type = KeyEventType::Paste;
+            event.paste_text = std::move(m_paste);
+            m_paste.clear();
+            emit(event);
+            m_state = State::Ground;
+          }
+          else if (m_paste.size() > c_max_paste_size)
+            m_paste.clear();
+          return true;
+      }
+      return true;
+    }
+  
+  public:
+    static constexpr auto c_escape_timeout = std::chrono::milliseconds(50);
+    
+    template<typename EmitF>
+    void feed(const unsigned char* data, int num_bytes, KeyEventClock::time_point time, EmitF&& emit)
+    {
+      for (int b_idx = 0; b_idx < num_bytes; ++b_idx)
+        if (!consume(data[b_idx], time, emit))
+          consume(data[b_idx], time, emit); // Now in State::Ground.
+    }
+    
+    // Resolves an unfinished sequence if it is older than c_escape_timeout: ESC alone is
+    //   SpecialKey::Escape, ESC [ and ESC O are Alt + '[' and Alt + 'O' and longer sequences
+    //   are dropped. An unfinished paste is kept.
+    template<typename EmitF>
+    void flush(KeyEventClock::time_point now, EmitF&& emit)
+    {
+      if (m_state == State::Ground || m_state == State::Paste || now - m_seq_time < c_escape_timeout)
+        return;
+      if (m_state == State::Esc)
+        emit_key({ SpecialKey::Escape }, 0, m_seq_time, emit);
+      else if (m_state == State::Ss3)
+        emit_byte('O', static_cast<uint8_t>(KeyMod::Alt), m_seq_time, emit);
+      else if (m_num_params == 0 && m_private_marker == 0)
+        emit_byte('[', static_cast<uint8_t>(KeyMod::Alt), m_seq_time, emit);
+      m_state = State::Ground;
+    }
+    
+    bool has_pending() const { return m_state != State::Ground; }
+  };
+
+}
@@ -0,0 +1,222 @@
+//
+//  KeyStateTracker.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "KeyDecoder.h"
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <algorithm>
+
+
+namespace t8
+{
+  
+  // Timing used for terminals that only report key presses (and auto-repeats as more presses).
+  struct KeyHoldTiming
+  {
+    // How long a key counts as held after a single press.
+    std::chrono::milliseconds initial_hold { 200 };
+    // If true, a single press is held until the learned auto-repeat delay has passed, so that
+    //   a held key doesn't flicker up before the terminal starts to repeat it. Taps then stay
+    //   down somewhat longer.
+    bool bridge_repeat_delay = false;
+    // While auto-repeating : repeat_hold_factor times the learned repeat interval, but at least
+    //   repeat_hold_min.
+    float repeat_hold_factor = 2.5f;
+    std::chrono::milliseconds repeat_hold_min { 50 };
+    // Safety timeout for terminals with release events, in case a release never arrives
+    //   (e.g. when the terminal loses focus).
+    std::chrono::milliseconds release_timeout { 1000 };
+  };
+  
+  // Keeps track of which keys are held down, based on the timestamps of the KeyEvents rather
+  //   than on the frame rate.
+  // With the kitty keyboard protocol (see StreamKeyboard::enable_kitty_keyboard()) keys are
+  //   down from their press until their release. Otherwise a key stays down for a while after
+  //   each press and the terminal's auto-repeat delay and interval are learned from the presses
+  //   so that a held key stays down between the repeats. Release events are detected
+  //   automatically.
+  class KeyStateTracker
+  {
+  public:
+    static constexpr int c_num_char_keys = 256;
+    static constexpr int c_num_keys = c_num_char_keys + 32;
+    using KeyBits = std::bitset<c_num_keys>;
+    
+    // Index into KeyBits. -1 for SpecialKey::None and the null char.
+    static int key_index(char ch)
+    {
+      return ch == 0 ? -1 : static_cast<unsigned char>(ch);
+    }
+    static int key_index(SpecialKey key)
+    {
+      return key == SpecialKey::None ? -1 : c_num_char_keys + static_cast<int>(key);
+    }
+    static int key_index(const std::variant<SpecialKey, char>& key)
+    {
+      return std::visit([](auto k) { return key_index(k); }, key);
+    }
+    // Inverse of key_index().
+    static std::variant<SpecialKey, char> key_at_index(int idx)
+    {
+      if (idx < 0 || idx >= c_num_keys)
+        return SpecialKey::None;
+      if (idx < c_num_char_keys)
+        return static_cast<char>(idx);
+      return static_cast<SpecialKey>(idx - c_num_char_keys);
+    }
+    
+    KeyStateTracker(const KeyHoldTiming& timing = {})
+      : m_timing(timing)
+    {}
+    
+    void set_timing(const KeyHoldTiming& timing) { m_timing = timing; }
+    const KeyHoldTiming& get_timing() const { return m_timing; }
+    
+    // Events must come in chronological order. Other event types than KeyEventType::Key are ignored.
+    void update(const KeyEvent& event)
+    {
+      if (event.type != KeyEventType::Key)
+        return;
+      const int idx = key_index(event.key);
+      if (idx < 0)
+        return;
+      auto& state = m_states[idx];
+      
+      if (event.action == KeyAction::Release)
+      {
+        m_has_release_events = true;
+        m_down.reset(idx);
+        return;
+      }
+      if (event.action == KeyAction::Repeat)
+        m_has_release_events = true;
+      
+      // Learn the auto-repeat timing from legacy presses. The gap before the first repeat is
+      //   only taken as the repeat delay once a second repeat follows quickly, so that two
+      //   separate taps aren't mistaken for it.
+      const auto dt = event.time - state.last_time;
+      const bool is_repeat_interval = c_min_repeat_interval <= dt && dt <= c_max_repeat_interval;
+      if (m_down.test(idx) && is_repeat_interval)
+      {
+        if (state.repeating)
+          m_repeat_interval = blend(m_repeat_interval, dt);
+        else if (c_min_repeat_delay <= state.delay_candidate && state.delay_candidate <= c_max_repeat_delay)
+          m_repeat_delay = blend(m_repeat_delay, state.delay_candidate);
+        state.repeating = true;
+      }
+      else
+      {
+        state.delay_candidate = dt;
+        state.repeating = false;
+      }
+      
+      state.last_time = event.time;
+      if (m_has_release_events)
+        state.deadline = event.time + m_timing.release_timeout;
+      else if (state.repeating)
+        state.deadline = event.time + std::max<KeyEventClock::duration>(m_timing.repeat_hold_min,
+          std::chrono::duration_cast<KeyEventClock::duration>(m_repeat_interval * m_timing.repeat_hold_factor));
+      else if (m_timing.bridge_repeat_delay)
+        state.deadline = event.time + std::max<KeyEventClock::duration>(m_timing.initial_hold,
+          m_repeat_delay + m_repeat_interval);
+      else
+        state.deadline = event.time + m_timing.initial_hold;
+      m_down.set(idx);
+      m_newest_idx = idx;
+    }
+    
+    template<typename Cont>
+    void update(const Cont& events)
+    {
+      for (const auto& event : events)
+        update(event);
+    }
+    
+    // Releases the keys whose hold time has run out. Call once per frame, after update().
+    void advance(KeyEventClock::time_point now)
+    {
+      if (m_down.none())
+      {
+        m_newest_idx = -1;
+        return;
+      }
+      for (int idx = 0; idx < c_num_keys; ++idx)
+        if (m_down.test(idx) && m_states[idx].deadline <= now)
+          m_down.reset(idx);
+      if (m_newest_idx >= 0 && !m_down.test(m_newest_idx))
+      {
+        m_newest_idx = -1;
+        for (int idx = 0; idx < c_num_keys; ++idx)
+          if (m_down.test(idx) && (m_newest_idx < 0 || m_states[idx].last_time > m_states[m_newest_idx].last_time))
+            m_newest_idx = idx;
+      }
+    }
+    
+    bool is_down(char ch) const
+    {
+      const int idx = key_index(ch);
+      return idx >= 0 && m_down.test(idx);
+    }
+    bool is_down(SpecialKey key) const
+    {
+      const int idx = key_index(key);
+      return idx >= 0 && m_down.test(idx);
+    }
+    
+    const KeyBits& get_held_keys() const { return m_down; }
+    bool any_down() const { return m_down.any(); }
+    
+    // The held key that was pressed (or repeated) most recently.
+    std::variant<SpecialKey, char> get_newest_held() const
+    {
+      return key_at_index(m_newest_idx);
+    }
+    
+    bool has_release_events() const { return m_has_release_events; }
+    
+    KeyEventClock::duration get_repeat_delay() const { return m_repeat_delay; }
+    KeyEventClock::duration get_repeat_interval() const { return m_repeat_interval; }
+    
+    void clear()
+    {
+      m_down.reset();
+      m_newest_idx = -1;
+    }
+  
+  private:
+    struct KeyState
+    {
+      KeyEventClock::time_point last_time;
+      KeyEventClock::time_point deadline;
+      KeyEventClock::duration delay_candidate {};
+      bool repeating = false;
+    };
+    
+    static constexpr auto c_min_repeat_delay = std::chrono::milliseconds(100);
+    static constexpr auto c_max_repeat_delay = std::chrono::milliseconds(2000);
+    static constexpr auto c_min_repeat_interval = std::chrono::milliseconds(5);
+    static constexpr auto c_max_repeat_interval = std::chrono::milliseconds(200);
+    
+    // Exponential moving average that follows changed terminal settings within a few repeats.
+    static KeyEventClock::duration blend(KeyEventClock::duration avg, KeyEventClock::duration sample)
+    {
+      return avg + (sample - avg) / 4;
+    }
+    
+    KeyHoldTiming m_timing;
+    std::array<KeyState, c_num_keys> m_states {};
+    KeyBits m_down;
+    int m_newest_idx = -1;
+    bool m_has_release_events = false;
+    // Typical defaults (e.g. X11 : 660 ms / 25 Hz, macOS : ~500 ms / ~30 Hz).
+    KeyEventClock::duration m_repeat_delay = std::chrono::milliseconds(500);
+    KeyEventClock::duration m_repeat_interval = std::chrono::milliseconds(33);
+  };
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "KeyboardEnums.h"
+#include "InputReader.h"
+#include "KeyStateTracker.h"
 #ifdef _WIN32
 #ifndef NOMINMAX
 #define NOMINMAX // Should fix the std::min()/max() and std::numeric_limits<T>::min()/max() compilation problems
@@ -13,6 +15,8 @@
 #include <optional>
 #include <variant>
 #include <iostream>
+#include <memory>
+#include <deque>
 #include <Core/Delay.h>
 
 
@@ -52,6 +56,24 @@ namespace t8
       case SpecialKey::Tab: return "Tab";
       case SpecialKey::Backspace: return "Backspace";
       case SpecialKey::Escape: return "Escape";
+      case SpecialKey::Home: return "Home";
+      case SpecialKey::End: return "End";
+      case SpecialKey::Insert: return "Insert";
+      case SpecialKey::Delete: return "Delete";
+      case SpecialKey::PageUp: return "PageUp";
+      case SpecialKey::PageDown: return "PageDown";
+      case SpecialKey::F1: return "F1";
+      case SpecialKey::F2: return "F2";
+      case SpecialKey::F3: return "F3";
+      case SpecialKey::F4: return "F4";
+      case SpecialKey::F5: return "F5";
+      case SpecialKey::F6: return "F6";
+      case SpecialKey::F7: return "F7";
+      case SpecialKey::F8: return "F8";
+      case SpecialKey::F9: return "F9";
+      case SpecialKey::F10: return "F10";
+      case SpecialKey::F11: return "F11";
+      case SpecialKey::F12: return "F12";
     }
     return "N/A";
   }
@@ -76,6 +98,42 @@ namespace t8
       return SpecialKey::Backspace;
     else if (special_key_str == "Escape")
       return SpecialKey::Escape;
+    else if (special_key_str == "Home")
+      return SpecialKey::Home;
+    else if (special_key_str == "End")
+      return SpecialKey::End;
+    else if (special_key_str == "Insert")
+      return SpecialKey::Insert;
+    else if (special_key_str == "Delete")
+      return SpecialKey::Delete;
+    else if (special_key_str == "PageUp")
+      return SpecialKey::PageUp;
+    else if (special_key_str == "PageDown")
+      return SpecialKey::PageDown;
+    else if (special_key_str == "F1")
+      return SpecialKey::F1;
+    else if (special_key_str == "F2")
+      return SpecialKey::F2;
+    else if (special_key_str == "F3")
+      return SpecialKey::F3;
+    else if (special_key_str == "F4")
+      return SpecialKey::F4;
+    else if (special_key_str == "F5")
+      return SpecialKey::F5;
+    else if (special_key_str == "F6")
+      return SpecialKey::F6;
+    else if (special_key_str == "F7")
+      return SpecialKey::F7;
+    else if (special_key_str == "F8")
+      return SpecialKey::F8;
+    else if (special_key_str == "F9")
+      return SpecialKey::F9;
+    else if (special_key_str == "F10")
+      return SpecialKey::F10;
+    else if (special_key_str == "F11")
+      return SpecialKey::F11;
+    else if (special_key_str == "F12")
+      return SpecialKey::F12;
     return SpecialKey::None;
   }
   
@@ -107,19 +165,60 @@ namespace t8
     KeyPressData held = std::nullopt;
   };
   
+  namespace keyboard
+  {
+    inline KeyPressData to_key_press_data(const std::variant<SpecialKey, char>& key)
+    {
+      return std::visit([](auto k) -> KeyPressData { return k; }, key);
+    }
+    
+    // The first key press among events. Repeats and releases (kitty keyboard protocol) don't count.
+    inline KeyPressData find_first_press(const std::vector<KeyEvent>& events)
+    {
+      for (const auto& event : events)
+        if (event.type == KeyEventType::Key && event.action == KeyAction::Press)
+          return to_key_press_data(event.key);
+      return std::nullopt;
+    }
+    
+    // Moves the queued events up to and including the next key press into frame_events and
+    //   returns that key press, if any.
+    inline KeyPressData take_events_until_press(std::deque<KeyEvent>& pending_events, std::vector<KeyEvent>& frame_events)
+    {
+      while (!pending_events.empty())
+      {
+        frame_events.emplace_back(std::move(pending_events.front()));
+        pending_events.pop_front();
+        const auto& event = frame_events.back();
+        if (event.type == KeyEventType::Key && event.action == KeyAction::Press)
+          return to_key_press_data(event.key);
+      }
+      return std::nullopt;
+    }
+  }
+  
   
   
   class StreamKeyboard
   {
   public:
-    StreamKeyboard(int buf_size = 10)
+    StreamKeyboard(const KeyHoldTiming& hold_timing = {})
+      : key_state(hold_timing)
     {
-      key_press_buffer.resize(buf_size);
       enableRawMode();
     }
     
+    [[deprecated("The key press buffer is replaced by KeyStateTracker, use StreamKeyboard(const KeyHoldTiming&).")]]
+    StreamKeyboard(int /*buf_size*/)
+      : StreamKeyboard(KeyHoldTiming {})
+    {}
+    
     ~StreamKeyboard()
     {
+      stop_input_thread();
+      enable_kitty_keyboard(false);
+      enable_mouse_reporting(false);
+      enable_bracketed_paste(false);
       disableRawMode();
     }
     
@@ -128,36 +227,142 @@ namespace t8
       return raw_mode_enabled;
     }
     
+    // Reads stdin on a separate thread from now on, see InputReader.
+    //   readKey() then consumes all keys that arrived since the previous call.
+    bool start_input_thread()
+    {
+      if (!raw_mode_enabled)
+      {
+        std::cerr << "ERROR in StreamKeyboard::start_input_thread() : Raw mode is not enabled." << std::endl;
+        return false;
+      }
+      if (input_reader == nullptr)
+        input_reader = std::make_unique<InputReader>();
+      input_reader->start();
+      return true;
+    }
+    
+    void stop_input_thread()
+    {
+      if (input_reader != nullptr)
+        input_reader->stop();
+    }
+    
+    bool is_input_thread_running() const
+    {
+      return input_reader != nullptr && input_reader->is_running();
+    }
+    
+    // All events consumed by the last readKey() call, oldest first. Besides keys (with
+    //   modifiers) these can be mouse reports and pastes, see enable_mouse_reporting() and
+    //   enable_bracketed_paste().
+    const std::vector<KeyEvent>& get_frame_events() const
+    {
+      return frame_events;
+    }
+    
+    // Mouse reports (SGR 1006) end up in get_frame_events() as KeyEventType::Mouse.
+    bool enable_mouse_reporting(bool enable, bool report_motion = false)
+    {
+#ifdef _WIN32
+      if (enable)
+      {
+        std::cerr << "ERROR in StreamKeyboard::enable_mouse_reporting() : Not supported on Windows." << std::endl;
+        return false;
+      }
+#else
+      if (enable)
+        std::cout << (report_motion ? "\x1b[?1003h" : "\x1b[?1000h") << "\x1b[?1006h" << std::flush;
+      else if (mouse_reporting_enabled)
+        std::cout << "\x1b[?1006l\x1b[?1003l\x1b[?1000l" << std::flush;
+      mouse_reporting_enabled = enable;
+#endif
+      return true;
+    }
+    
+    // Pasted text ends up in get_frame_events() as one KeyEventType::Paste event instead of
+    //   as separate key presses.
+    bool enable_bracketed_paste(bool enable)
+    {
+#ifdef _WIN32
+      if (enable)
+      {
+        std::cerr << "ERROR in StreamKeyboard::enable_bracketed_paste() : Not supported on Windows." << std::endl;
+        return false;
+      }
+#else
+      if (enable)
+        std::cout << "\x1b[?2004h" << std::flush;
+      else if (bracketed_paste_enabled)
+        std::cout << "\x1b[?2004l" << std::flush;
+      bracketed_paste_enabled = enable;
+#endif
+      return true;
+    }
+    
+    // Asks the terminal for key release and repeat events (kitty keyboard protocol), which makes
+    //   the held key tracking exact. Terminals without support for the protocol ignore this.
+    bool enable_kitty_keyboard(bool enable)
+    {
+#ifdef _WIN32
+      if (enable)
+      {
+        std::cerr << "ERROR in StreamKeyboard::enable_kitty_keyboard() : Not supported on Windows." << std::endl;
+        return false;
+      }
+#else
+      // Flags : 1 = disambiguate, 2 = event types, 4 = alternate (shifted) keys, 8 = all keys as escape codes.
+      if (enable && !kitty_keyboard_enabled)
+        std::cout << "\x1b[>15u" << std::flush;
+      else if (!enable && kitty_keyboard_enabled)
+        std::cout << "\x1b[<u" << std::flush;
+      kitty_keyboard_enabled = enable;
+#endif
+      return true;
+    }
+    
+    [[deprecated("No-op. Held keys are tracked by KeyStateTracker, see KeyHoldTiming.")]]
+    void set_held_buffer_size_from_fps(float /*fps*/) {}
+    
+    // Held keys, updated by readKey().
+    const KeyStateTracker& get_key_state() const { return key_state; }
+    bool is_key_down(char ch) const { return key_state.is_down(ch); }
+    bool is_key_down(SpecialKey key) const { return key_state.is_down(key); }
+    
     // Reads a key and returns either a SpecialKey or a regular character.
+    // With the input thread running, transient is the oldest key since the previous call
+    //   and the rest are available through get_frame_events().
+    // held is the transient key if any, otherwise the most recently pressed key that is still
+    //   held down according to get_key_state().
     KeyPressDataPair readKey()
     {
       KeyPressDataPair kpdp;
-      auto kpd = parseKey();
-      kpdp.transient = kpd;
-      
-      key_press_buffer[buffer_idx++] = kpd;
-      if (buffer_idx >= static_cast<int>(key_press_buffer.size()))
-        buffer_idx = 0;
-      if (is_key_pressed(kpd))
-      {
-        kpdp.held = kpd;
-        return kpdp;
-      }
-        
-      for (const auto& buf_kpd : key_press_buffer)
+      frame_events.clear();
+      if (is_input_thread_running())
+        input_reader->drain(frame_events);
+      else
       {
-        if (char ch = get_char_key(buf_kpd); ch != 0)
-        {
-          kpdp.held = ch;
-          return kpdp;
-        }
-        if (SpecialKey key = get_special_key(buf_kpd); key != SpecialKey::None)
+        [[maybe_unused]] auto parsed_kpd = parseKey();
+#ifdef _WIN32
+        if (parsed_kpd.has_value())
         {
-          kpdp.held = key;
-          return kpdp;
+          KeyEvent event;
+          event.key = parsed_kpd.value();
+          event.time = KeyEventClock::now();
+          frame_events.emplace_back(event);
         }
+#endif
       }
-      kpdp.held = SpecialKey::None;
+      // Both input paths : Only a press is taken as the transient key.
+      auto kpd = keyboard::find_first_press(frame_events);
+      kpdp.transient = kpd;
+      
+      key_state.update(frame_events);
+      key_state.advance(KeyEventClock::now());
+      if (is_key_pressed(kpd))
+        kpdp.held = kpd;
+      else
+        kpdp.held = keyboard::to_key_press_data(key_state.get_newest_held());
       return kpdp;
     }
     
@@ -181,13 +386,6 @@ namespace t8
       waitKey();
     }
     
-    void set_held_buffer_size_from_fps(float fps)
-    {
-      auto buf_size = static_cast<int>(std::max(5.f, -4.4893e-05f*math::sq(fps) + 1.9383e-01f*fps + 1.0662e+00f));
-      //std::cout << "fps = " << fps << ", buf_size = " << buf_size << std::endl;
-      key_press_buffer.resize(buf_size);
-    }
-    
   private:
     bool disableRawMode()
     {
@@ -301,53 +499,30 @@ namespace t8
       }
       return std::nullopt;
 #else
-      unsigned char c;
-      fd_set read_fds;
-      struct timeval tv = {0, 100}; // 100 microseconds to avoid CPU overload
-      
-      FD_ZERO(&read_fds);
-      FD_SET(STDIN_FILENO, &read_fds);
-      
-      int result = select(STDIN_FILENO + 1, &read_fds, nullptr, nullptr, &tv);
-      if (result > 0 && FD_ISSET(STDIN_FILENO, &read_fds))
+      auto f_push = [this](const KeyEvent& event) { pending_events.push_back(event); };
+      auto now = KeyEventClock::now();
+      if (pending_events.empty())
       {
-        if (read(STDIN_FILENO, &c, 1) == -1) return std::nullopt;
+        fd_set read_fds;
+        struct timeval tv = {0, 100}; // 100 microseconds to avoid CPU overload
         
-        // Process escape sequences and special keys
-        if (c == 27)
-        {
-          if (read(STDIN_FILENO, &c, 1) == -1) return std::nullopt;
-          if (c == '[')
-          {
-            if (read(STDIN_FILENO, &c, 1) == -1) return std::nullopt;
-            switch (c)
-            {
-              case 'A': return SpecialKey::Up;
-              case 'B': return SpecialKey::Down;
-              case 'C': return SpecialKey::Right;
-              case 'D': return SpecialKey::Left;
-            }
-          }
-          return SpecialKey::Escape;
-        }
-        else
+        FD_ZERO(&read_fds);
+        FD_SET(STDIN_FILENO, &read_fds);
+        
+        // Reads everything that is available in one go and decodes it with KeyByteDecoder.
+        int result = select(STDIN_FILENO + 1, &read_fds, nullptr, nullptr, &tv);
+        if (result > 0 && FD_ISSET(STDIN_FILENO, &read_fds))
         {
-          // Handle Enter, Tab, Backspace, and printable ASCII characters
-          switch (c)
-          {
-            case 10:
-            case 13: return SpecialKey::Enter;
-            case 9: return SpecialKey::Tab;
-            case 8:
-            case 127: return SpecialKey::Backspace;
-            default:
-              if (c >= 32 && c <= 126)
-                return static_cast<char>(c);
-              return SpecialKey::None;
-          }
+          unsigned char buf[256];
+          auto num_read = read(STDIN_FILENO, buf, sizeof(buf));
+          if (num_read > 0)
+            decoder.feed(buf, static_cast<int>(num_read), now, f_push);
         }
       }
-      return std::nullopt;
+      decoder.flush(now, f_push);
+      
+      // Hand out the queued events up to and including the next key press.
+      return keyboard::take_events_until_press(pending_events, frame_events);
 #endif
     }
     
@@ -358,8 +533,16 @@ namespace t8
     struct termios orig_termios;
 #endif
     bool raw_mode_enabled = false;
-    std::vector<KeyPressData> key_press_buffer;
-    int buffer_idx = 0;
+    KeyStateTracker key_state;
+    std::unique_ptr<InputReader> input_reader;
+    std::vector<KeyEvent> frame_events;
+#ifndef _WIN32
+    KeyByteDecoder decoder;
+    std::deque<KeyEvent> pending_events;
+    bool mouse_reporting_enabled = false;
+    bool bracketed_paste_enabled = false;
+    bool kitty_keyboard_enabled = false;
+#endif
   };
   
 }
@@ -20,7 +20,25 @@ namespace t8
     Enter,
     Tab,
     Backspace,
-    Escape
+    Escape,
+    Home,
+    End,
+    Insert,
+    Delete,
+    PageUp,
+    PageDown,
+    F1,
+    F2,
+    F3,
+    F4,
+    F5,
+    F6,
+    F7,
+    F8,
+    F9,
+    F10,
+    F11,
+    F12
   };
 
 }
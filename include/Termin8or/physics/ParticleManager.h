@@ -0,0 +1,253 @@
+//
+//  ParticleManager.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "ParticleSystem.h"
+#include "../geom/Rectangle.h"
+#include <Core/StlUtils.h>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <algorithm>
+
+
+namespace t8x
+{
+  
+  // Spawn and appearance parameters of a single emitter.
+  // vel_r, vel_c, g, spread, life_time and cluster_size have the same meaning
+  //   as the corresponding arguments of ParticleHandler::update().
+  template<typename StrT = std::string>
+  struct ParticleEmitter
+  {
+    RC pos;
+    bool trigger = false; // Set each frame, like the trigger argument of ParticleHandler::update().
+    bool enabled = true;
+    
+    float vel_r = 0.f;
+    float vel_c = 0.f;
+    float g = 0.f;
+    float spread = 1.f;
+    float life_time = 1.f;
+    int cluster_size = 0;
+    
+    int budget = 100; // Max number of live particles for this emitter.
+    int priority = 0; // Higher priority emitters get to spawn first when the pool is running out.
+    
+    ParticleGradientGroup<StrT, BakedGradient> gradients;
+  };
+  
+  // Owns one particle pool that is shared by all emitters.
+  // Each frame, triggered emitters spawn in priority order, limited by their own budget,
+  //   by the free slots in the pool and by the current level of detail (LOD).
+  // The LOD drops when the reported frame time exceeds the frame time budget and
+  //   recovers slowly when it doesn't. Emitters outside of the cull region (+ margin)
+  //   don't spawn any new particles.
+  template<typename StrT = std::string>
+  class ParticleManager
+  {
+    ParticleStreamSoA m_pool;
+    std::vector<std::unique_ptr<ParticleEmitter<StrT>>> m_emitters;
+    std::vector<int> m_num_alive_per_emitter;
+    std::vector<int> m_spawn_order;
+    t8::RandStreamKey m_rnd_key;
+    bool m_rnd_seeded = false;
+    
+    std::optional<t8::Rectangle> m_cull_region;
+    int m_cull_margin = 0;
+    
+    float m_frame_time_budget_ms = 0.f; // 0 => LOD disabled.
+    float m_lod = 1.f;
+    float m_lod_min = 0.1f;
+    float m_lod_decay = 0.8f;
+    float m_lod_recovery = 0.05f;
+    
+    int find_emitter_idx(const ParticleEmitter<StrT>* emitter) const
+    {
+      for (int e_idx = 0; e_idx < stlutils::sizeI(m_emitters); ++e_idx)
+        if (m_emitters[e_idx].get() == emitter)
+          return e_idx;
+      return -1;
+    }
+    
+    void count_alive()
+    {
+      m_num_alive_per_emitter.assign(m_emitters.size(), 0);
+      for (size_t idx = 0; idx < m_pool.size(); ++idx)
+      {
+        auto e_idx = m_pool.owner[idx];
+        if (0 <= e_idx && e_idx < stlutils::sizeI(m_emitters))
+          m_num_alive_per_emitter[e_idx]++;
+      }
+    }
+    
+    bool is_culled(const ParticleEmitter<StrT>& emitter) const
+    {
+      return m_cull_region.has_value() && !m_cull_region->is_inside_offs(emitter.pos, m_cull_margin);
+    }
+  
+  public:
+    ParticleManager(size_t pool_size)
+      : m_pool(pool_size)
+    {
+      m_rnd_key.system = t8::RandSystem::Particles;
+      m_rnd_key.entity = t8::next_rand_entity();
+    }
+    
+    // Each emitter draws from its own stream keyed by (seed, emitter index, frame),
+    //   so spawning doesn't depend on the order or number of the other emitters.
+    //   Without it, the first update() takes t8::session_rand_seed.
+    void set_rnd_seed(uint64_t seed)
+    {
+      m_rnd_key.seed = seed;
+      m_rnd_key.frame = 0;
+      m_rnd_seeded = true;
+    }
+    
+    ParticleEmitter<StrT>* add_emitter(const ParticleEmitter<StrT>& params = {})
+    {
+      auto emitter = std::make_unique<ParticleEmitter<StrT>>(params);
+      auto* emitter_raw = emitter.get();
+      // Reuse the slot of a removed emitter so that the owner indices in the pool stay valid.
+      auto it = std::find(m_emitters.begin(), m_emitters.end(), nullptr);
+      if (it != m_emitters.end())
+        *it = std::move(emitter);
+      else
+        m_emitters.emplace_back(std::move(emitter));
+      return emitter_raw;
+    }
+    
+    // Kills all the particles of the emitter.
+    void remove_emitter(ParticleEmitter<StrT>* emitter)
+    {
+      auto e_idx = find_emitter_idx(emitter);
+      if (e_idx == -1)
+        return;
+      size_t idx = 0;
+      while (idx < m_pool.size())
+      {
+        if (m_pool.owner[idx] == e_idx)
+          m_pool.kill(idx);
+        else
+          idx++;
+      }
+      m_emitters[e_idx].reset();
+    }
+    
+    void set_cull_region(const t8::Rectangle& region, int margin = 0)
+    {
+      m_cull_region = region;
+      m_cull_margin = margin;
+    }
+    void clear_cull_region() { m_cull_region.reset(); }
+    
+    void set_frame_time_budget_ms(float budget_ms) { m_frame_time_budget_ms = budget_ms; }
+    void set_lod_params(float lod_min, float lod_decay, float lod_recovery)
+    {
+      m_lod_min = math::clamp(lod_min, 0.f, 1.f);
+      m_lod_decay = math::clamp(lod_decay, 0.f, 1.f);
+      m_lod_recovery = std::max(lod_recovery, 0.f);
+    }
+    float get_lod() const { return m_lod; }
+    
+    // Call once per frame with the measured frame time (e.g. from the previous frame).
+    void report_frame_time_ms(float frame_time_ms)
+    {
+      if (m_frame_time_budget_ms <= 0.f)
+        m_lod = 1.f;
+      else if (frame_time_ms > m_frame_time_budget_ms)
+        m_lod = std::max(m_lod_min, m_lod * m_lod_decay);
+      else
+        m_lod = std::min(1.f, m_lod + m_lod_recovery);
+    }
+    
+    void update(float dt, float time)
+    {
+      m_pool.cull(time);
+      m_pool.integrate(dt);
+      if (!m_rnd_seeded)
+        set_rnd_seed(t8::session_rand_seed);
+      count_alive();
+      
+      m_spawn_order.clear();
+      for (int e_idx = 0; e_idx < stlutils::sizeI(m_emitters); ++e_idx)
+      {
+        const auto* emitter = m_emitters[e_idx].get();
+        if (emitter != nullptr && emitter->enabled && emitter->trigger && emitter->cluster_size >= 0
+            && !is_culled(*emitter))
+          m_spawn_order.emplace_back(e_idx);
+      }
+      std::stable_sort(m_spawn_order.begin(), m_spawn_order.end(), [this](int eA, int eB)
+      {
+        return m_emitters[eA]->priority > m_emitters[eB]->priority;
+      });
+      
+      m_rnd_key.frame++;
+      for (auto e_idx : m_spawn_order)
+      {
+        const auto& emitter = *m_emitters[e_idx];
+        auto num_wanted = std::max(1, math::roundI((emitter.cluster_size + 1) * m_lod));
+        auto budget = std::max(1, math::roundI(emitter.budget * m_lod));
+        auto num_spawn = std::min(num_wanted, budget - m_num_alive_per_emitter[e_idx]);
+        if (num_spawn <= 0)
+          continue;
+        auto rng = m_rnd_key.stream(static_cast<uint32_t>(e_idx) + 1);
+        auto num_spawned = m_pool.spawn(static_cast<size_t>(num_spawn), rng,
+                                        time, emitter.pos, emitter.vel_r, emitter.vel_c, emitter.g,
+                                        emitter.spread, emitter.life_time, e_idx);
+        m_num_alive_per_emitter[e_idx] += static_cast<int>(num_spawned);
+        if (num_spawned == 0)
+          break; // Pool is full.
+      }
+    }
+    
+    template<int NR, int NC, typename CharT>
+    void draw(ScreenHandler<NR, NC, CharT>& sh, float time) const
+    {
+      for (size_t idx = 0; idx < m_pool.size(); ++idx)
+      {
+        const auto e_idx = m_pool.owner[idx];
+        if (e_idx < 0 || e_idx >= stlutils::sizeI(m_emitters) || m_emitters[e_idx] == nullptr)
+          continue;
+        const auto& grads = m_emitters[e_idx]->gradients;
+        auto t = m_pool.calc_t(idx, time);
+        sh.write_buffer(grads.string_gradient(t), math::roundI(m_pool.pos_r[idx]), math::roundI(m_pool.pos_c[idx]),
+                        grads.fg_color_gradient(t), grads.bg_color_gradient(t));
+      }
+    }
+    
+    template<int NR, int NC, typename CharT>
+    void draw(ScreenHandler<NR, NC, CharT>& sh, ParticleSplatter<NR, NC, StrT>& splatter, float time) const
+    {
+      splatter.clear();
+      for (size_t idx = 0; idx < m_pool.size(); ++idx)
+        splatter.add(m_pool.pos_r[idx], m_pool.pos_c[idx], m_pool.calc_t(idx, time));
+      splatter.resolve(sh);
+    }
+    
+    size_t num_alive() const { return m_pool.size(); }
+    int num_alive(const ParticleEmitter<StrT>* emitter) const
+    {
+      auto e_idx = find_emitter_idx(emitter);
+      if (e_idx == -1 || e_idx >= stlutils::sizeI(m_num_alive_per_emitter))
+        return 0;
+      return m_num_alive_per_emitter[e_idx];
+    }
+    size_t pool_capacity() const { return m_pool.capacity(); }
+    int num_emitters() const
+    {
+      return static_cast<int>(std::count_if(m_emitters.begin(), m_emitters.end(), [](const auto& e) { return e != nullptr; }));
+    }
+    
+    void clear_particles()
+    {
+      m_pool.clear();
+      m_num_alive_per_emitter.assign(m_emitters.size(), 0);
+    }
+  };
+
+}
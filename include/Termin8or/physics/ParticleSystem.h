@@ -2,13 +2,19 @@
 #include "../screen/ScreenUtils.h"
 #include "../geom/RC.h"
 #include "../drawing/Gradient.h"
+#include "../sys/RandStream.h"
+#include "../sys/Snapshot.h"
 #include <Core/Rand.h>
 #include <Core/MathUtils.h>
+#include <array>
+#include <cstdint>
+#include <limits>
 
 namespace t8x
 {
   using RC = t8::RC;
   using Color = t8::Color;
+  using Color16 = t8::Color16;
   template<int NR, int NC, typename CharT>
   using ScreenHandler = t8::ScreenHandler<NR, NC, CharT>;
   
@@ -27,11 +33,27 @@ namespace t8x
     bool dead = false;
     
     void init(float time, const RC& pos0, float vr, float vc, float gravity_acc, float spread, float life_t)
+    {
+      init(time, pos0, vr, vc, gravity_acc, spread, life_t,
+           static_cast<float>(rnd::rand()), static_cast<float>(rnd::rand()));
+    }
+    
+    void init(float time, const RC& pos0, float vr, float vc, float gravity_acc, float spread, float life_t,
+              t8::RandStream& rng)
+    {
+      auto u_r = rng.next_float();
+      auto u_c = rng.next_float();
+      init(time, pos0, vr, vc, gravity_acc, spread, life_t, u_r, u_c);
+    }
+    
+    // u_r, u_c : uniform random numbers in [0, 1).
+    void init(float time, const RC& pos0, float vr, float vc, float gravity_acc, float spread, float life_t,
+              float u_r, float u_c)
     {
       time_stamp = time;
       start_pos = pos0;
-      vel_r = vr + spread * (rnd::rand() - 0.5f);
-      vel_c = vc + spread * (rnd::rand() - 0.5f);
+      vel_r = vr + spread * (u_r - 0.5f);
+      vel_c = vc + spread * (u_c - 0.5f);
       g = gravity_acc;
       pos_r = static_cast<float>(pos0.r);
       pos_c = static_cast<float>(pos0.c);
@@ -58,24 +80,172 @@ namespace t8x
     }
   };
   
-  template<typename StrT = std::string>
+  // Use GradT = BakedGradient for O(1) gradient evaluation. Note that a baked Nearest gradient
+  //   may differ from the Gradient it was baked from by up to one LUT bucket near the
+  //   midpoints between stops.
+  template<typename StrT = std::string, template<typename> class GradT = Gradient>
   struct ParticleGradientGroup
   {
-    Gradient<Color> fg_color_gradient;
-    Gradient<Color> bg_color_gradient;
-    Gradient<StrT> string_gradient;
+    GradT<Color> fg_color_gradient;
+    GradT<Color> bg_color_gradient;
+    GradT<StrT> string_gradient;
+  };
+  
+  // Per-cell particle accumulation pass.
+  // Instead of writing every particle to the screen buffer, particles are binned into
+  //   cells (count, youngest age) with add() and then each touched cell is resolved once
+  //   in resolve() to a glyph and colors via lookup tables that are built when the
+  //   gradients / strings are set.
+  // Glyphs are picked by density (count / density_saturation) if density strings are set,
+  //   otherwise by the youngest age in the cell.
+  template<int NR, int NC, typename StrT = std::string>
+  class ParticleSplatter
+  {
+  public:
+    static constexpr int c_lut_size = 64;
+    
+  private:
+    std::array<int, NR*NC> cell_count;
+    std::array<float, NR*NC> cell_youngest_t;
+    std::vector<int> touched_cells;
+    
+    std::array<Color, c_lut_size> fg_lut;
+    std::array<Color, c_lut_size> bg_lut;
+    std::vector<StrT> age_strings;
+    std::vector<StrT> density_strings;
+    int density_saturation = 8;
+    
+    static int to_lut_idx(float t)
+    {
+      return math::clamp(static_cast<int>(t * c_lut_size), 0, c_lut_size - 1);
+    }
+    
+    static int to_str_idx(float t, size_t num)
+    {
+      int str_idx = static_cast<int>(std::round(t*num)) - 1;
+      return math::clamp(str_idx, 0, static_cast<int>(num) - 1);
+    }
+    
+  public:
+    ParticleSplatter()
+    {
+      cell_count.fill(0);
+      cell_youngest_t.fill(1.f);
+      fg_lut.fill(Color16::Default);
+      bg_lut.fill(Color16::Transparent);
+      touched_cells.reserve(NR*NC);
+    }
+    
+    template<typename GradT = Gradient<Color>>
+    void set_fg_gradient(const GradT& fg_gradient)
+    {
+      for (int i = 0; i < c_lut_size; ++i)
+        fg_lut[i] = fg_gradient((i + 0.5f) / c_lut_size);
+    }
+    
+    template<typename GradT = Gradient<Color>>
+    void set_bg_gradient(const GradT& bg_gradient)
+    {
+      for (int i = 0; i < c_lut_size; ++i)
+        bg_lut[i] = bg_gradient((i + 0.5f) / c_lut_size);
+    }
+    
+    void set_fg_color(Color fg_color) { fg_lut.fill(fg_color); }
+    
+    void set_bg_color(Color bg_color) { bg_lut.fill(bg_color); }
+    
+    // Strings indexed by normalized age, same mapping as ParticleHandler::draw().
+    void set_age_strings(const std::vector<StrT>& strings) { age_strings = strings; }
+    
+    // Strings ordered from sparse to dense.
+    void set_density_strings(const std::vector<StrT>& strings, int saturation_count = 8)
+    {
+      density_strings = strings;
+      density_saturation = std::max(1, saturation_count);
+    }
+    
+    void clear()
+    {
+      for (auto idx : touched_cells)
+      {
+        cell_count[idx] = 0;
+        cell_youngest_t[idx] = 1.f;
+      }
+      touched_cells.clear();
+    }
+    
+    // t : normalized age of the particle [0, 1].
+    void add(float pos_r, float pos_c, float t)
+    {
+      auto r = math::roundI(pos_r);
+      auto c = math::roundI(pos_c);
+      if (r < 0 || r >= NR || c < 0 || c >= NC)
+        return;
+      auto idx = r * NC + c;
+      if (cell_count[idx]++ == 0)
+        touched_cells.emplace_back(idx);
+      math::minimize(cell_youngest_t[idx], t);
+    }
+    
+    int get_count(int r, int c) const { return cell_count[r * NC + c]; }
+    
+    float get_youngest_t(int r, int c) const { return cell_youngest_t[r * NC + c]; }
+    
+    float get_density(int r, int c) const
+    {
+      return std::min(1.f, static_cast<float>(get_count(r, c)) / density_saturation);
+    }
+    
+    int num_touched_cells() const { return stlutils::sizeI(touched_cells); }
+    
+    template<typename CharT>
+    void resolve(ScreenHandler<NR, NC, CharT>& sh) const
+    {
+      for (auto idx : touched_cells)
+      {
+        auto r = idx / NC;
+        auto c = idx % NC;
+        auto t = cell_youngest_t[idx];
+        auto lut_idx = to_lut_idx(t);
+        if (!density_strings.empty())
+        {
+          auto density = std::min(1.f, static_cast<float>(cell_count[idx]) / density_saturation);
+          sh.write_buffer(density_strings[to_str_idx(density, density_strings.size())], r, c, fg_lut[lut_idx], bg_lut[lut_idx]);
+        }
+        else if (!age_strings.empty())
+          sh.write_buffer(age_strings[to_str_idx(t, age_strings.size())], r, c, fg_lut[lut_idx], bg_lut[lut_idx]);
+      }
+    }
   };
   
   struct ParticleHandler
   {
     ParticleHandler(size_t N_particles)
-      : particle_stream(N_particles), num_particles(N_particles), num_particles_active(N_particles) {}
+      : particle_stream(N_particles), num_particles(N_particles), num_particles_active(N_particles)
+    {
+      rnd_key.system = t8::RandSystem::Particles;
+      rnd_key.entity = t8::next_rand_entity();
+    }
+    
+    // Makes spawning and gradient selection reproducible, independent of the global rnd state.
+    //   Without it, the first update() takes t8::session_rand_seed.
+    void set_rnd_seed(uint64_t seed, uint32_t entity = 0)
+    {
+      rnd_key.seed = seed;
+      rnd_key.entity = entity;
+      rnd_key.frame = 0;
+      rnd_seeded = true;
+    }
     
     void update(const RC& start_pos, bool trigger,
                 float vel_r, float vel_c, float g,
                 float spread, float life_time, int particle_cluster_size,
                 float dt, float time)
     {
+      if (!rnd_seeded)
+        set_rnd_seed(t8::session_rand_seed, rnd_key.entity);
+      auto rng = rnd_key.stream();
+      rnd_key.frame++;
       int particle_cluster_idx = 0;
       for (auto& particle : particle_stream)
       {
@@ -84,7 +254,7 @@ namespace t8x
         else if (trigger)
         {
           if (!particle.dead)
-            particle.init(time, start_pos, vel_r, vel_c, g, spread, life_time);
+            particle.init(time, start_pos, vel_r, vel_c, g, spread, life_time, rng);
           if (particle_cluster_idx++ >= particle_cluster_size)
             trigger = false;
         }
@@ -99,9 +269,9 @@ namespace t8x
           particle.draw(sh, str, fg_color, bg_color, time);
     }
     
-    template<int NR, int NC, typename CharT, typename StrT = std::string>
+    template<int NR, int NC, typename CharT, typename StrT = std::string, typename GradT = Gradient<Color>>
     void draw(ScreenHandler<NR, NC, CharT>& sh, const std::vector<StrT>& str,
-              const Gradient<Color>& fg_color, const Gradient<Color>& bg_color, float time) const
+              const GradT& fg_color, const GradT& bg_color, float time) const
     {
       for (const auto& particle : particle_stream)
         if (!particle.dead && particle.alive(time))
@@ -113,46 +283,83 @@ namespace t8x
         }
     }
     
-    template<int NR, int NC, typename CharT, typename StrT = std::string>
+    template<int NR, int NC, typename CharT, typename StrT = std::string, typename GradT = Gradient<Color>>
     void draw(ScreenHandler<NR, NC, CharT>& sh, const std::vector<StrT>& str,
-              const std::vector<std::pair<float, std::pair<Gradient<Color>, Gradient<Color>>>>& color_fg_bg_vec,
+              const std::vector<std::pair<float, std::pair<GradT, GradT>>>& color_fg_bg_vec,
               float time) const
     {
+      auto rng = rnd_key.stream(1);
       for (const auto& particle : particle_stream)
         if (!particle.dead && particle.alive(time))
         {
           auto t = (time - particle.time_stamp)/particle.life_time;
           int str_idx = static_cast<int>(std::round(t*str.size())) - 1;
           str_idx = math::clamp(str_idx, 0, static_cast<int>(str.size()) - 1);
-          const auto& col_fg_bg = rnd::rand_select(color_fg_bg_vec);
-          const Gradient<Color>& fg_color = col_fg_bg.first;
-          const Gradient<Color>& bg_color = col_fg_bg.second;
+          const auto& col_fg_bg = rng.select(color_fg_bg_vec);
+          const GradT& fg_color = col_fg_bg.first;
+          const GradT& bg_color = col_fg_bg.second;
           particle.draw(sh, str[str_idx], fg_color(t), bg_color(t), time);
         }
     }
     
-    template<int NR, int NC, typename CharT, typename StrT = std::string>
+    template<int NR, int NC, typename CharT, typename StrT = std::string, template<typename> class GradT = Gradient>
     void draw(ScreenHandler<NR, NC, CharT>& sh,
-              const std::vector<std::pair<float, ParticleGradientGroup<StrT>>>& gradient_groups,
+              const std::vector<std::pair<float, ParticleGradientGroup<StrT, GradT>>>& gradient_groups,
               float time) const
     {
+      auto rng = rnd_key.stream(1);
       for (const auto& particle : particle_stream)
         if (!particle.dead && particle.alive(time))
         {
           auto t = (time - particle.time_stamp)/particle.life_time;
-          const auto& grads = rnd::rand_select(gradient_groups);
-          const Gradient<Color>& fg_grad = grads.fg_color_gradient;
-          const Gradient<Color>& bg_grad = grads.bg_color_gradient;
-          const Gradient<StrT>& str_grad = grads.string_gradient;
+          const auto& grads = rng.select(gradient_groups);
+          const auto& fg_grad = grads.fg_color_gradient;
+          const auto& bg_grad = grads.bg_color_gradient;
+          const auto& str_grad = grads.string_gradient;
           particle.draw(sh, str_grad(t), fg_grad(t), bg_grad(t), time);
         }
     }
     
+    template<int NR, int NC, typename CharT, typename StrT = std::string>
+    void draw(ScreenHandler<NR, NC, CharT>& sh, ParticleSplatter<NR, NC, StrT>& splatter, float time) const
+    {
+      splatter.clear();
+      for (const auto& particle : particle_stream)
+        if (!particle.dead && particle.alive(time))
+          splatter.add(particle.pos_r, particle.pos_c, (time - particle.time_stamp)/particle.life_time);
+      splatter.resolve(sh);
+    }
+    
     void set_num_active_particles(float amount_ratio_active)
     {
-      num_particles_active = static_cast<int>(std::round(static_cast<float>(num_particles) * amount_ratio_active));
-      for (size_t p_idx = num_particles_active; p_idx < num_particles; ++p_idx)
-        particle_stream[p_idx].dead = true;
+      num_particles_active = std::min(num_particles,
+        static_cast<size_t>(std::round(static_cast<float>(num_particles) * std::max(amount_ratio_active, 0.f))));
+      // Also revives the particles below the limit when the ratio goes up again.
+      for (size_t p_idx = 0; p_idx < num_particles; ++p_idx)
+        particle_stream[p_idx].dead = p_idx >= num_particles_active;
+    }
+    
+    void save_state(StateWriter& sw) const
+    {
+      sw.write_vector(particle_stream);
+      sw.write(num_particles_active);
+      sw.write(rnd_key);
+    }
+    
+    // Restoring requires the same number of particles.
+    bool load_state(StateReader& sr)
+    {
+      std::vector<Particle> particles;
+      if (!sr.read_vector(particles) || particles.size() != num_particles)
+      {
+        std::cerr << "ERROR in ParticleHandler::load_state() : Number of particles doesn't match the snapshot." << std::endl;
+        return false;
+      }
+      if (!sr.read(num_particles_active) || !sr.read(rnd_key))
+        return false;
+      rnd_seeded = true;
+      particle_stream = std::move(particles);
+      return true;
     }
     
     std::vector<Particle> particle_stream;
@@ -160,6 +367,270 @@ namespace t8x
     
   private:
     size_t num_particles_active = 0;
+    t8::RandStreamKey rnd_key;
+    bool rnd_seeded = false;
+  };
+  
+  // ///////////////////////////////////////////
+  
+  // Counter-based generator used for spawning particles in batches.
+  // Much cheaper than calling rnd::rand() per particle component.
+  using ParticleRand = t8::RandStream;
+  
+  // Structure-of-arrays particle storage.
+  // Live particles are kept packed in [0, num_alive) and dead particles are
+  //   swap-removed with the last live particle, so the free slots always are [num_alive, capacity).
+  // The integration loop works on contiguous float arrays without branches so
+  //   that it can be auto-vectorized by the compiler.
+  struct ParticleStreamSoA
+  {
+    std::vector<float> pos_r;
+    std::vector<float> pos_c;
+    std::vector<float> vel_r;
+    std::vector<float> vel_c;
+    std::vector<float> g;
+    std::vector<float> time_stamp;
+    std::vector<float> life_time;
+    std::vector<int> owner; // Optional tag, e.g. emitter index.
+    
+    ParticleStreamSoA() = default;
+    ParticleStreamSoA(size_t N_particles) { resize(N_particles); }
+    
+    void resize(size_t N_particles)
+    {
+      pos_r.resize(N_particles);
+      pos_c.resize(N_particles);
+      vel_r.resize(N_particles);
+      vel_c.resize(N_particles);
+      g.resize(N_particles);
+      time_stamp.resize(N_particles);
+      life_time.resize(N_particles);
+      owner.resize(N_particles);
+      math::minimize(num_alive, N_particles);
+      max_alive = N_particles;
+    }
+    
+    size_t capacity() const { return pos_r.size(); }
+    size_t size() const { return num_alive; }
+    bool empty() const { return num_alive == 0; }
+    
+    // Limits the number of live particles. Excess particles are killed.
+    void set_max_alive(size_t num)
+    {
+      max_alive = std::min(num, capacity());
+      math::minimize(num_alive, max_alive);
+    }
+    size_t get_max_alive() const { return max_alive; }
+    
+    void clear() { num_alive = 0; }
+    
+    void kill(size_t idx)
+    {
+      if (idx >= num_alive)
+        return;
+      auto last = --num_alive;
+      if (idx != last)
+      {
+        pos_r[idx] = pos_r[last];
+        pos_c[idx] = pos_c[last];
+        vel_r[idx] = vel_r[last];
+        vel_c[idx] = vel_c[last];
+        g[idx] = g[last];
+        time_stamp[idx] = time_stamp[last];
+        life_time[idx] = life_time[last];
+        owner[idx] = owner[last];
+      }
+    }
+    
+    // Removes all particles whose life time has expired.
+    void cull(float time)
+    {
+      size_t idx = 0;
+      while (idx < num_alive)
+      {
+        if (time - time_stamp[idx] < life_time[idx])
+          idx++;
+        else
+          kill(idx); // Re-test the particle that was swapped into idx.
+      }
+    }
+    
+    void integrate(float dt)
+    {
+      const auto n = num_alive;
+      const float dt_r = dt / pix_ar;
+      float* pr = pos_r.data();
+      float* pc = pos_c.data();
+      const float* vr = vel_r.data();
+      const float* vc = vel_c.data();
+      const float* gg = g.data();
+      for (size_t i = 0; i < n; ++i)
+      {
+        pc[i] += vc[i] * dt;
+        pr[i] += vr[i] * dt_r + gg[i] * dt; // r is pointing down.
+      }
+    }
+    
+    // Returns the number of particles actually spawned.
+    size_t spawn(size_t num, ParticleRand& rng,
+                 float time, const RC& pos0, float vr, float vc, float gravity_acc, float spread, float life_t,
+                 int owner_id = -1)
+    {
+      num = std::min(num, max_alive - std::min(max_alive, num_alive));
+      if (num == 0)
+        return 0;
+      rnd_batch.resize(2*num);
+      rng.fill(rnd_batch.data(), rnd_batch.size());
+      const auto r0 = static_cast<float>(pos0.r);
+      const auto c0 = static_cast<float>(pos0.c);
+      const auto idx0 = num_alive;
+      for (size_t i = 0; i < num; ++i)
+      {
+        auto idx = idx0 + i;
+        pos_r[idx] = r0;
+        pos_c[idx] = c0;
+        vel_r[idx] = vr + spread * (rnd_batch[2*i] - 0.5f);
+        vel_c[idx] = vc + spread * (rnd_batch[2*i + 1] - 0.5f);
+        g[idx] = gravity_acc;
+        time_stamp[idx] = time;
+        life_time[idx] = life_t;
+        owner[idx] = owner_id;
+      }
+      num_alive += num;
+      return num;
+    }
+    
+    // Normalized age in [0, 1].
+    float calc_t(size_t idx, float time) const
+    {
+      return math::clamp((time - time_stamp[idx]) / life_time[idx], 0.f, 1.f);
+    }
+    
+  private:
+    size_t num_alive = 0;
+    size_t max_alive = 0;
+    std::vector<float> rnd_batch;
+  };
+  
+  // Drop-in alternative to ParticleHandler that stores its particles as a ParticleStreamSoA.
+  // Only live particles are visited in update() and draw().
+  struct ParticleHandlerSoA
+  {
+    ParticleHandlerSoA(size_t N_particles)
+      : particle_stream(N_particles), num_particles(N_particles)
+    {
+      rnd_key.system = t8::RandSystem::Particles;
+      rnd_key.entity = t8::next_rand_entity();
+    }
+    
+    // Makes spawning and gradient selection reproducible, independent of the global rnd state.
+    //   Without it, the first update() takes t8::session_rand_seed.
+    void set_rnd_seed(uint64_t seed, uint32_t entity = 0)
+    {
+      rnd_key.seed = seed;
+      rnd_key.entity = entity;
+      rnd_key.frame = 0;
+      rnd_seeded = true;
+    }
+    
+    void update(const RC& start_pos, bool trigger,
+                float vel_r, float vel_c, float g,
+                float spread, float life_time, int particle_cluster_size,
+                float dt, float time)
+    {
+      particle_stream.cull(time);
+      particle_stream.integrate(dt);
+      if (!rnd_seeded)
+        set_rnd_seed(t8::session_rand_seed, rnd_key.entity);
+      auto rng = rnd_key.stream();
+      rnd_key.frame++;
+      // Same spawn count per trigger as ParticleHandler::update().
+      if (trigger && particle_cluster_size >= 0)
+        particle_stream.spawn(static_cast<size_t>(particle_cluster_size) + 1, rng,
+                              time, start_pos, vel_r, vel_c, g, spread, life_time);
+    }
+    
+    template<int NR, int NC, typename CharT, typename StrT = std::string>
+    void draw(ScreenHandler<NR, NC, CharT>& sh, const StrT& str, Color fg_color, Color bg_color, float time) const
+    {
+      const auto& ps = particle_stream;
+      for (size_t idx = 0; idx < ps.size(); ++idx)
+        if (time - ps.time_stamp[idx] < ps.life_time[idx])
+          sh.write_buffer(str, math::roundI(ps.pos_r[idx]), math::roundI(ps.pos_c[idx]), fg_color, bg_color);
+    }
+    
+    template<int NR, int NC, typename CharT, typename StrT = std::string, typename GradT = Gradient<Color>>
+    void draw(ScreenHandler<NR, NC, CharT>& sh, const std::vector<StrT>& str,
+              const GradT& fg_color, const GradT& bg_color, float time) const
+    {
+      const auto& ps = particle_stream;
+      for (size_t idx = 0; idx < ps.size(); ++idx)
+      {
+        auto t = ps.calc_t(idx, time);
+        int str_idx = static_cast<int>(std::round(t*str.size())) - 1;
+        str_idx = math::clamp(str_idx, 0, static_cast<int>(str.size()) - 1);
+        sh.write_buffer(str[str_idx], math::roundI(ps.pos_r[idx]), math::roundI(ps.pos_c[idx]), fg_color(t), bg_color(t));
+      }
+    }
+    
+    template<int NR, int NC, typename CharT, typename StrT = std::string, typename GradT = Gradient<Color>>
+    void draw(ScreenHandler<NR, NC, CharT>& sh, const std::vector<StrT>& str,
+              const std::vector<std::pair<float, std::pair<GradT, GradT>>>& color_fg_bg_vec,
+              float time) const
+    {
+      const auto& ps = particle_stream;
+      auto rng = rnd_key.stream(1);
+      for (size_t idx = 0; idx < ps.size(); ++idx)
+      {
+        auto t = ps.calc_t(idx, time);
+        int str_idx = static_cast<int>(std::round(t*str.size())) - 1;
+        str_idx = math::clamp(str_idx, 0, static_cast<int>(str.size()) - 1);
+        const auto& col_fg_bg = rng.select(color_fg_bg_vec);
+        const GradT& fg_color = col_fg_bg.first;
+        const GradT& bg_color = col_fg_bg.second;
+        sh.write_buffer(str[str_idx], math::roundI(ps.pos_r[idx]), math::roundI(ps.pos_c[idx]), fg_color(t), bg_color(t));
+      }
+    }
+    
+    template<int NR, int NC, typename CharT, typename StrT = std::string, template<typename> class GradT = Gradient>
+    void draw(ScreenHandler<NR, NC, CharT>& sh,
+              const std::vector<std::pair<float, ParticleGradientGroup<StrT, GradT>>>& gradient_groups,
+              float time) const
+    {
+      const auto& ps = particle_stream;
+      auto rng = rnd_key.stream(1);
+      for (size_t idx = 0; idx < ps.size(); ++idx)
+      {
+        auto t = ps.calc_t(idx, time);
+        const auto& grads = rng.select(gradient_groups);
+        sh.write_buffer(grads.string_gradient(t), math::roundI(ps.pos_r[idx]), math::roundI(ps.pos_c[idx]),
+                        grads.fg_color_gradient(t), grads.bg_color_gradient(t));
+      }
+    }
+    
+    template<int NR, int NC, typename CharT, typename StrT = std::string>
+    void draw(ScreenHandler<NR, NC, CharT>& sh, ParticleSplatter<NR, NC, StrT>& splatter, float time) const
+    {
+      const auto& ps = particle_stream;
+      splatter.clear();
+      for (size_t idx = 0; idx < ps.size(); ++idx)
+        splatter.add(ps.pos_r[idx], ps.pos_c[idx], ps.calc_t(idx, time));
+      splatter.resolve(sh);
+    }
+    
+    void set_num_active_particles(float amount_ratio_active)
+    {
+      particle_stream.set_max_alive(static_cast<size_t>(std::round(static_cast<float>(num_particles) * amount_ratio_active)));
+    }
+    
+    size_t num_alive() const { return particle_stream.size(); }
+    
+    ParticleStreamSoA particle_stream;
+    const size_t num_particles = 0;
+    
+  private:
+    t8::RandStreamKey rnd_key;
+    bool rnd_seeded = false;
   };
   
 }
@@ -11,6 +11,7 @@
 #include "DynamicsSystem.h"
 #include <Core/Utils.h>
 #include <unordered_set>
+#include <unordered_map>
 
 using namespace utils::literals;
 
@@ -99,15 +100,16 @@ namespace t8x
       }
     }
     
-    AABB<float> refit()
+    // swept = true: leaves enclose the body over the whole of its last step (used by CCD).
+    AABB<float> refit(bool swept = false)
     {
       aabb.set_empty();
       
       if (rigid_body != nullptr)
-        aabb = rigid_body->get_curr_AABB();
+        aabb = swept ? rigid_body->get_swept_AABB() : rigid_body->get_curr_AABB();
       else
         for (auto& ch : children)
-          aabb.grow(ch->refit());
+          aabb.grow(ch->refit(swept));
         
       return aabb;
     }
@@ -164,6 +166,16 @@ namespace t8x
       BVH_Node* node_B = nullptr;
     };
     
+    // Time of impact for a bullet rigid body. toi is normalized over the last step,
+    //   i.e. 0 = prev position and 1 = curr position (see RigidBody::rewind_to_toi()).
+    struct TOIData
+    {
+      RigidBody* rb_bullet = nullptr;
+      RigidBody* rb_other = nullptr;
+      float toi = 1.f;
+      Vec2 world_pos;
+    };
+    
   private:
     std::unique_ptr<BVH_Node> m_aabb_bvh;
     std::vector<BVH_Node*> m_aabb_bvh_leaves;
@@ -178,8 +190,118 @@ namespace t8x
     };
     
     std::vector<IsectData> isect_world_positions;
+    std::vector<TOIData> toi_data;
+    
+    // Max distance in cells that a ray-marching step may move a bullet relative to the other body.
+    float ccd_max_step_len = 0.5f;
+    
+    bool is_excluded(RigidBody* rb_A, RigidBody* rb_B) const
+    {
+      if (rb_A > rb_B)
+        std::swap(rb_A, rb_B);
+      
+      if (stlutils::contains_if(exclusion_pairs,
+        [rb_A, rb_B](const auto& rbp) { return rbp.first == rb_A && rbp.second == rb_B; }))
+      {
+        return true;
+      }
+      const auto& name_A = rb_A->get_sprite()->get_name();
+      const auto& name_B = rb_B->get_sprite()->get_name();
+      return stlutils::contains_if(exclusion_prefixes,
+        [&name_A, &name_B](const auto& strp)
+        {
+          if (name_A.starts_with(strp.first) && name_B.starts_with(strp.second))
+            return true;
+          if (name_B.starts_with(strp.first) && name_A.starts_with(strp.second))
+            return true;
+          return false;
+        });
+    }
+    
+    // Displacement of the AABB (and thus the collision mask) over the last step.
+    static Vec2 calc_step_displacement(const RigidBody* rb)
+    {
+      auto prev_aabb = rb->get_prev_AABB();
+      auto curr_aabb = rb->get_curr_AABB();
+      return { curr_aabb.r_min() - prev_aabb.r_min(), curr_aabb.c_min() - prev_aabb.c_min() };
+    }
+    
+    // Ray-marches the collision masks of bullet A and body B over [t_enter, t_exit] of the last step
+    //   and returns the first t at which the masks overlap.
+    // The current masks are used throughout the step (animation frames are not interpolated).
+    std::optional<float> march_masks(const RigidBody* rb_A, const RigidBody* rb_B,
+                                     float t_enter, float t_exit, Vec2& world_pos) const
+    {
+      const auto prev_aabb_A = rb_A->get_prev_AABB();
+      const auto prev_aabb_B = rb_B->get_prev_AABB();
+      const auto curr_aabb_A = rb_A->get_curr_AABB();
+      const auto curr_aabb_B = rb_B->get_curr_AABB();
+      const Vec2 p0_A { prev_aabb_A.r_min(), prev_aabb_A.c_min() };
+      const Vec2 p0_B { prev_aabb_B.r_min(), prev_aabb_B.c_min() };
+      const Vec2 d_A = calc_step_displacement(rb_A);
+      const Vec2 d_B = calc_step_displacement(rb_B);
+      const auto height_A = math::roundI(curr_aabb_A.height());
+      const auto width_A = math::roundI(curr_aabb_A.width());
+      const auto height_B = math::roundI(curr_aabb_B.height());
+      const auto width_B = math::roundI(curr_aabb_B.width());
+      const auto& coll_mask_A = rb_A->get_curr_coll_mask();
+      const auto& coll_mask_B = rb_B->get_curr_coll_mask();
+      
+      auto dist = math::length(d_A - d_B) * (t_exit - t_enter);
+      auto num_steps = std::max(1, static_cast<int>(std::ceil(dist / ccd_max_step_len)));
+      for (int step = 0; step <= num_steps; ++step)
+      {
+        auto t = t_enter + (t_exit - t_enter) * static_cast<float>(step) / num_steps;
+        auto rc_A = t8::to_RC_round(p0_A + d_A * t);
+        auto rc_B = t8::to_RC_round(p0_B + d_B * t);
+        auto rmin = std::max(rc_A.r, rc_B.r);
+        auto rmax = std::min(rc_A.r + height_A, rc_B.r + height_B);
+        auto cmin = std::max(rc_A.c, rc_B.c);
+        auto cmax = std::min(rc_A.c + width_A, rc_B.c + width_B);
+        for (int r = rmin; r < rmax; ++r)
+        {
+          for (int c = cmin; c < cmax; ++c)
+          {
+            auto idx_A = (r - rc_A.r) * width_A + (c - rc_A.c);
+            auto idx_B = (r - rc_B.r) * width_B + (c - rc_B.c);
+            if (coll_mask_A[idx_A] && coll_mask_B[idx_B])
+            {
+              // Already in contact at the start of the step. Leave it to the discrete phase.
+              if (t <= 0.f)
+                return std::nullopt;
+              world_pos = { static_cast<float>(r), static_cast<float>(c) };
+              return t;
+            }
+          }
+        }
+      }
+      return std::nullopt;
+    }
         
   public:
+    // Swept AABB vs AABB (slab test) where A moves by d relative to B during t = [0, 1].
+    // Returns false if they never overlap during the step.
+    static bool calc_swept_AABB_interval(const AABB<float>& aabb_A, const AABB<float>& aabb_B, const Vec2& d,
+                                         float& t_enter, float& t_exit)
+    {
+      t_enter = 0.f;
+      t_exit = 1.f;
+      auto f_slab = [&t_enter, &t_exit](float a_min, float a_max, float b_min, float b_max, float d_ax)
+      {
+        if (d_ax == 0.f)
+          return !(a_max < b_min || b_max < a_min);
+        auto t0 = (b_min - a_max) / d_ax;
+        auto t1 = (b_max - a_min) / d_ax;
+        if (t0 > t1)
+          std::swap(t0, t1);
+        math::maximize(t_enter, t0);
+        math::minimize(t_exit, t1);
+        return t_enter <= t_exit;
+      };
+      return f_slab(aabb_A.r_min(), aabb_A.r_max(), aabb_B.r_min(), aabb_B.r_max(), d.r)
+        && f_slab(aabb_A.c_min(), aabb_A.c_max(), aabb_B.c_min(), aabb_B.c_max(), d.c);
+    }
+    
     CollisionHandler()
     {
       m_aabb_bvh = std::make_unique<BVH_Node>();
@@ -190,6 +312,17 @@ namespace t8x
       return isect_world_positions;
     }
     
+    // Earliest time of impact per bullet from the last call to detect_continuous().
+    const std::vector<TOIData>& get_toi_data() const
+    {
+      return toi_data;
+    }
+    
+    void set_ccd_max_step_len(float step_len)
+    {
+      ccd_max_step_len = std::max(0.05f, step_len);
+    }
+    
     void exclude_rigid_body_pairs(RigidBody* rb_A, RigidBody* rb_B)
     {
       if (rb_A > rb_B)
@@ -312,6 +445,7 @@ namespace t8x
     
     void detect_broad_phase(std::unordered_set<std::pair<BVH_Node*, BVH_Node*>, BVHNodePairHash>& proximity_pairs)
     {
+      t8::ProfileScope prof_scope(t8::ProfileZone::CollisionBroadPhase);
       for (auto* leaf : m_aabb_bvh_leaves)
       {
         std::vector<BVH_Node*> overlapping_leaves;
@@ -323,30 +457,8 @@ namespace t8x
           BVH_Node* first = order ? leaf : coll_leaf;
           BVH_Node* second = order ? coll_leaf : leaf;
           
-          auto* rb_A = first->rigid_body;
-          auto* rb_B = second->rigid_body;
-          if (rb_A > rb_B)
-            std::swap(rb_A, rb_B);
-            
-          if (stlutils::contains_if(exclusion_pairs,
-            [rb_A, rb_B](const auto& rbp) { return rbp.first == rb_A && rbp.second == rb_B; }))
-          {
+          if (is_excluded(first->rigid_body, second->rigid_body))
             continue;
-          }
-          const auto& name_A = rb_A->get_sprite()->get_name();
-          const auto& name_B = rb_B->get_sprite()->get_name();
-          if (stlutils::contains_if(exclusion_prefixes,
-            [&name_A, &name_B](const auto& strp)
-            {
-              if (name_A.starts_with(strp.first) && name_B.starts_with(strp.second))
-                return true;
-              if (name_B.starts_with(strp.first) && name_A.starts_with(strp.second))
-                return true;
-              return false;
-            }))
-          {
-            continue;
-          }
           
           proximity_pairs.insert({first, second});
         }
@@ -356,6 +468,7 @@ namespace t8x
     void detect_narrow_phase(const std::unordered_set<std::pair<BVH_Node*, BVH_Node*>, BVHNodePairHash>& proximity_pairs,
                              std::vector<NarrowPhaseCollData>& coll_data)
     {
+      t8::ProfileScope prof_scope(t8::ProfileZone::CollisionNarrowPhase);
       coll_data.reserve(proximity_pairs.size());
       for (const auto& prox_pair : proximity_pairs)
       {
@@ -520,8 +633,87 @@ namespace t8x
       }
     }
     
+    // Continuous collision detection for bullet rigid bodies.
+    // Broad phase: BVH refitted with swept AABBs followed by a swept AABB slab test.
+    // Narrow phase: collision masks are ray-marched along the relative motion.
+    void detect_continuous(bool verbose = false)
+    {
+      toi_data.clear();
+      if (!stlutils::contains_if(m_aabb_bvh_leaves,
+            [](const auto* leaf) { return leaf->rigid_body != nullptr && leaf->rigid_body->is_bullet(); }))
+        return;
+      
+      m_aabb_bvh->refit(true);
+      
+      for (auto* leaf : m_aabb_bvh_leaves)
+      {
+        auto* rb_A = leaf->rigid_body;
+        if (rb_A == nullptr || !rb_A->is_bullet())
+          continue;
+        
+        std::vector<BVH_Node*> overlapping_leaves;
+        m_aabb_bvh->find_overlapping_leaves(leaf, overlapping_leaves);
+        
+        const auto prev_aabb_A = rb_A->get_prev_AABB();
+        const auto d_A = calc_step_displacement(rb_A);
+        
+        TOIData tdata;
+        for (auto* coll_leaf : overlapping_leaves)
+        {
+          auto* rb_B = coll_leaf->rigid_body;
+          if (is_excluded(rb_A, rb_B))
+            continue;
+          const auto d_B = calc_step_displacement(rb_B);
+          float t_enter = 0.f, t_exit = 1.f;
+          if (!calc_swept_AABB_interval(prev_aabb_A, rb_B->get_prev_AABB(), d_A - d_B, t_enter, t_exit))
+            continue;
+          if (t_enter >= tdata.toi)
+            continue;
+          Vec2 world_pos;
+          auto toi = march_masks(rb_A, rb_B, t_enter, std::min(t_exit, tdata.toi), world_pos);
+          if (toi.has_value() && toi.value() < tdata.toi)
+          {
+            tdata.rb_bullet = rb_A;
+            tdata.rb_other = rb_B;
+            tdata.toi = toi.value();
+            tdata.world_pos = world_pos;
+          }
+        }
+        if (tdata.rb_bullet != nullptr)
+          toi_data.emplace_back(tdata);
+      }
+      
+      if (verbose)
+        std::cout << "# ccd impacts = " << toi_data.size() << std::endl;
+    }
+    
+    // Rewinds each bullet and the body it hit to their time of impact so that the discrete
+    //   narrow phase and response sees the contact instead of a tunneled body.
+    // The TOI is found along the relative motion, so both bodies are rewound.
+    //   A body involved in several impacts is rewound once, to its earliest TOI.
+    void update_continuous_response()
+    {
+      std::unordered_map<RigidBody*, float> min_toi;
+      auto f_add = [&min_toi](RigidBody* rb, float toi)
+      {
+        auto [it, inserted] = min_toi.try_emplace(rb, toi);
+        if (!inserted)
+          math::minimize(it->second, toi);
+      };
+      for (const auto& td : toi_data)
+      {
+        f_add(td.rb_bullet, td.toi);
+        f_add(td.rb_other, td.toi);
+      }
+      for (auto [rb, toi] : min_toi)
+        rb->rewind_to_toi(toi);
+    }
+    
     void update(bool verbose = false)
     {
+      detect_continuous(verbose);
+      update_continuous_response();
+      
       std::vector<NarrowPhaseCollData> narrow_phase_collision_data;
       update_detection(narrow_phase_collision_data, verbose);
       
@@ -84,8 +84,31 @@ namespace t8x
       return rigid_bodies_raw;
     }
     
+    // Restoring requires the same rigid bodies, added in the same order.
+    void save_state(StateWriter& sw) const
+    {
+      sw.write(static_cast<uint64_t>(m_rigid_bodies.size()));
+      for (const auto& rb : m_rigid_bodies)
+        rb->save_state(sw);
+    }
+    
+    bool load_state(StateReader& sr)
+    {
+      uint64_t num_rigid_bodies = 0;
+      if (!sr.read(num_rigid_bodies) || num_rigid_bodies != m_rigid_bodies.size())
+      {
+        std::cerr << "ERROR in DynamicsSystem::load_state() : Number of rigid bodies doesn't match the snapshot." << std::endl;
+        return false;
+      }
+      for (auto& rb : m_rigid_bodies)
+        if (!rb->load_state(sr))
+          return false;
+      return true;
+    }
+    
     void update(float time, float dt, int sim_frame)
     {
+      t8::ProfileScope prof_scope(t8::ProfileZone::Physics);
       for (auto& rb : m_rigid_bodies)
         rb->update(time, dt, sim_frame);
     }
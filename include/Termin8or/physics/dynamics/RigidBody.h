@@ -48,6 +48,13 @@ namespace t8x
     std::optional<float> critical_speed_r = std::nullopt;
     std::optional<float> critical_speed_c = std::nullopt;
     
+    // Bullets are swept from prev_cm to curr_cm by CollisionHandler to avoid tunneling.
+    bool bullet = false;
+    Vec2 prev_cm;
+    Vec2 prev_centroid;
+    AABB<float> prev_aabb;
+    int curr_sim_frame = 0;
+    
     AABB<int> curr_sprite_aabb;
     AABB<float> curr_aabb;
     bool_vector curr_inertia_mask, curr_coll_mask;
@@ -147,6 +154,21 @@ namespace t8x
       }
     }
     
+    void update_sprite_pos()
+    {
+      // curr_cm + (orig_pos - orig_cm) + (orig_cm_local - curr_cm_local)
+      auto sprite_pos = curr_cm + cm_to_orig_pos + (curr_cm_local - orig_cm_local);
+      sprite->pos = t8::to_RC_round(sprite_pos);
+    }
+    
+    void update_shape(int sim_frame)
+    {
+      curr_sim_frame = sim_frame;
+      calc_cm_and_I(sim_frame);
+      calc_surface_normals();
+      curr_aabb = curr_sprite_aabb.convert<float>();
+    }
+    
   public:
     RigidBody(Sprite* s, float rb_mass = 1.f,
       std::optional<Vec2> pos = std::nullopt, const Vec2& vel = {}, const Vec2& force = {},
@@ -180,6 +202,9 @@ namespace t8x
       curr_aabb = curr_sprite_aabb.convert<float>();
       curr_centroid = s->calc_curr_centroid(0);
       cm_to_orig_pos = orig_pos - curr_cm;
+      prev_cm = curr_cm;
+      prev_centroid = curr_centroid;
+      prev_aabb = curr_aabb;
       if (auto* vector_sprite = dynamic_cast<VectorSprite*>(sprite); vector_sprite != nullptr)
         curr_ang = math::deg2rad(vector_sprite->get_rotation());
     }
@@ -188,6 +213,10 @@ namespace t8x
     {
       if (sprite != nullptr)
       {
+        prev_cm = curr_cm;
+        prev_centroid = curr_centroid;
+        prev_aabb = curr_aabb;
+        
         if (mass > 0.f && !(enable_sleeping && sleeping))
         {
           curr_acc = curr_force * inv_mass;
@@ -202,9 +231,7 @@ namespace t8x
           curr_ang_vel += curr_ang_acc * dt;
           curr_ang += curr_ang_vel * dt;
           
-          // curr_cm + (orig_pos - orig_cm) + (orig_cm_local - curr_cm_local)
-          auto sprite_pos = curr_cm + cm_to_orig_pos + (curr_cm_local - orig_cm_local);
-          sprite->pos = t8::to_RC_round(sprite_pos);
+          update_sprite_pos();
           if (auto* vector_sprite = dynamic_cast<VectorSprite*>(sprite); vector_sprite != nullptr)
             vector_sprite->set_rotation(math::rad2deg(curr_ang));
           
@@ -220,14 +247,30 @@ namespace t8x
           }
         }
         
-        calc_cm_and_I(sim_frame);
-        calc_surface_normals();
-        curr_aabb = curr_sprite_aabb.convert<float>();
+        update_shape(sim_frame);
       }
     }
     
+    // Moves the body back along its last step so that it ends up at
+    //   prev_cm + toi * (curr_cm - prev_cm). toi = 1 leaves the body untouched.
+    // Rotation is not rewound.
+    void rewind_to_toi(float toi)
+    {
+      if (sprite == nullptr)
+        return;
+      toi = math::clamp(toi, 0.f, 1.f);
+      if (toi == 1.f)
+        return;
+      curr_cm = prev_cm + (curr_cm - prev_cm) * toi;
+      curr_centroid = prev_centroid + (curr_centroid - prev_centroid) * toi;
+      update_sprite_pos();
+      update_shape(curr_sim_frame);
+    }
+    
     Vec2 get_curr_cm() const { return curr_cm; }
     
+    Vec2 get_prev_cm() const { return prev_cm; }
+    
     float get_curr_cm_r() const { return curr_cm.r; }
     
     float get_curr_cm_c() const { return curr_cm.c; }
@@ -244,6 +287,16 @@ namespace t8x
     
     AABB<float> get_curr_AABB() const { return curr_aabb; }
     
+    AABB<float> get_prev_AABB() const { return prev_aabb; }
+    
+    // AABB covering the body over the whole of its last step.
+    AABB<float> get_swept_AABB() const { return prev_aabb.set_union(curr_aabb); }
+    
+    // Bullets get continuous collision detection in CollisionHandler.
+    void set_bullet(bool enable) { bullet = enable; }
+    
+    bool is_bullet() const { return bullet; }
+    
     const bool_vector& get_curr_inertia_mask() const { return curr_inertia_mask; }
     
     const bool_vector& get_curr_coll_mask() const { return curr_coll_mask; }
@@ -369,6 +422,50 @@ namespace t8x
     bool is_sleeping() const { return enable_sleeping && sleeping; }
     
     Sprite* get_sprite() const { return sprite; }
+    
+    // Dynamic state for snapshots. Restore the sprites first, the shape is recalculated from them.
+    void save_state(StateWriter& sw) const
+    {
+      sw.write(curr_cm);
+      sw.write(curr_centroid);
+      sw.write(curr_ang);
+      sw.write(curr_vel);
+      sw.write(curr_acc);
+      sw.write(curr_force);
+      sw.write(curr_ang_vel);
+      sw.write(curr_ang_acc);
+      sw.write(curr_torque);
+      sw.write(prev_cm);
+      sw.write(prev_centroid);
+      sw.write(prev_aabb);
+      sw.write(curr_sim_frame);
+      sw.write(sleeping);
+      sw.write(sleep_timestamp);
+    }
+    
+    bool load_state(StateReader& sr)
+    {
+      sr.read(curr_cm);
+      sr.read(curr_centroid);
+      sr.read(curr_ang);
+      sr.read(curr_vel);
+      sr.read(curr_acc);
+      sr.read(curr_force);
+      sr.read(curr_ang_vel);
+      sr.read(curr_ang_acc);
+      sr.read(curr_torque);
+      sr.read(prev_cm);
+      sr.read(prev_centroid);
+      sr.read(prev_aabb);
+      sr.read(curr_sim_frame);
+      sr.read(sleeping);
+      sr.read(sleep_timestamp);
+      if (!sr.ok())
+        return false;
+      if (sprite != nullptr)
+        update_shape(curr_sim_frame);
+      return true;
+    }
   };
   
   
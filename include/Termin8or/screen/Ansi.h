@@ -9,6 +9,7 @@
 
 #include "Color.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -147,7 +148,9 @@ namespace t8::ansi
     char command = '\0';
   };
   
-  inline bool parse_ansi_csi_sequence(const std::string& str,
+  // Parses the CSI sequence starting at pos in place (no intermediate token strings),
+  //   so the same AnsiCsiSequence object can be reused without reallocating params.
+  inline bool parse_ansi_csi_sequence(std::string_view str,
                                       int& pos,
                                       AnsiCsiSequence& seq)
   {
@@ -155,28 +158,34 @@ namespace t8::ansi
     seq.command = '\0';
     
     int i = pos;
-    int str_len = str::lenI(str);
+    int str_len = static_cast<int>(str.size());
     if (i + 1 >= str_len || str[i] != '\033' || str[i + 1] != '[')
       return false;
     
     i += 2;
-    std::string token;
+    int param = 0;
+    bool has_digits = false;
     
     while (i < str_len)
     {
       char ch = str[i];
       
       if (str::is_digit(ch))
-        token.push_back(ch);
+      {
+        if (param < 100'000'000) // Saturate rather than overflow on garbage input.
+          param = param*10 + (ch - '0');
+        has_digits = true;
+      }
       else if (ch == ';')
       {
-        seq.params.emplace_back(token.empty() ? 0 : std::stoi(token));
-        token.clear();
+        seq.params.emplace_back(param);
+        param = 0;
+        has_digits = false;
       }
       else if ('@' <= ch && ch <= '~') // Final sequence byte found somewhere in this range.
       {
-        if (!token.empty())
-          seq.params.emplace_back(std::stoi(token));
+        if (has_digits)
+          seq.params.emplace_back(param);
         
         seq.command = ch;
         pos = i + 1;
@@ -196,7 +205,7 @@ namespace t8::ansi
   // ESC[31m       -> {31}
   // ESC[31;44m    -> {31, 44}
   // ESC[38;5;123m -> {38, 5, 123}
-  inline bool parse_ansi_sgr_params(const std::string& str,
+  inline bool parse_ansi_sgr_params(std::string_view str,
                                     int& pos,
                                     std::vector<int>& params)
   {
@@ -221,7 +230,7 @@ namespace t8::ansi
   // ESC[nC -> move cursor forward by n visible cells.
   // ESC[D  -> move cursor backward by 1 visible cell.
   // ESC[nD -> move cursor backward by n visible cells.
-  inline bool parse_ansi_cursor_move(const std::string& str,
+  inline bool parse_ansi_cursor_move(std::string_view str,
                                      int& pos,
                                      char& direction,
                                      int& count)
@@ -241,7 +250,7 @@ namespace t8::ansi
     return false;
   }
   
-  inline bool parse_ansi_erase(const std::string& str,
+  inline bool parse_ansi_erase(std::string_view str,
                                int& pos,
                                char& target,
                                int& mode)
@@ -265,7 +274,7 @@ namespace t8::ansi
   // ESC[row;colH -> move cursor to row, col. Coordinates are 1-based.
   // ESC[f       -> same as ESC[H.
   // ESC[row;colf -> same as ESC[row;colH.
-  inline bool parse_ansi_cursor_position(const std::string& str,
+  inline bool parse_ansi_cursor_position(std::string_view str,
                                          int& pos,
                                          int& row,
                                          int& col)
@@ -287,7 +296,7 @@ namespace t8::ansi
   
   // ESC[s -> save cursor position.
   // ESC[u -> restore cursor position.
-  inline bool parse_ansi_cursor_save_restore(const std::string& str,
+  inline bool parse_ansi_cursor_save_restore(std::string_view str,
                                              int& pos,
                                              char& command)
   {
@@ -11,6 +11,9 @@
 #include <Core/StringHelper.h>
 #include <string>
 #include <map>
+#include <array>
+#include <vector>
+#include <cmath>
 #include <iostream>
 
 namespace t8
@@ -751,40 +754,52 @@ namespace t8
     
     if (auto rgb6 = col.try_get_rgb6(); rgb6.has_value())
     {
-      auto [r, g, b] = rgb6.value().to_xterm_float();
-      
-      struct rgb_t { float r, g, b; };
-      
-      static constexpr rgb_t ansi16_table[16] =
+      // Nearest of the 16 colors for each of the 216 rgb6 colors, computed once.
+      static const std::array<Color16, 216> rgb6_to_color16 = []()
       {
-        { 0.0f, 0.0f, 0.0f },   // Black
-        { 0.4f, 0.0f, 0.0f },   // DarkRed
-        { 0.0f, 0.4f, 0.0f },   // DarkGreen
-        { 0.4f, 0.4f, 0.0f },   // DarkYellow
-        { 0.0f, 0.0f, 0.4f },   // DarkBlue
-        { 0.4f, 0.0f, 0.4f },   // DarkMagenta
-        { 0.0f, 0.4f, 0.4f },   // DarkCyan
-        { 0.8f, 0.8f, 0.8f },   // LightGray
-        { 0.4f, 0.4f, 0.4f },   // DarkGray
-        { 1.0f, 0.0f, 0.0f },   // Red
-        { 0.0f, 1.0f, 0.0f },   // Green
-        { 1.0f, 1.0f, 0.0f },   // Yellow
-        { 0.0f, 0.0f, 1.0f },   // Blue
-        { 1.0f, 0.0f, 1.0f },   // Magenta
-        { 0.0f, 1.0f, 1.0f },   // Cyan
-        { 1.0f, 1.0f, 1.0f },   // White
-      };
+        struct rgb_t { float r, g, b; };
+        
+        static constexpr rgb_t ansi16_table[16] =
+        {
+          { 0.0f, 0.0f, 0.0f },   // Black
+          { 0.4f, 0.0f, 0.0f },   // DarkRed
+          { 0.0f, 0.4f, 0.0f },   // DarkGreen
+          { 0.4f, 0.4f, 0.0f },   // DarkYellow
+          { 0.0f, 0.0f, 0.4f },   // DarkBlue
+          { 0.4f, 0.0f, 0.4f },   // DarkMagenta
+          { 0.0f, 0.4f, 0.4f },   // DarkCyan
+          { 0.8f, 0.8f, 0.8f },   // LightGray
+          { 0.4f, 0.4f, 0.4f },   // DarkGray
+          { 1.0f, 0.0f, 0.0f },   // Red
+          { 0.0f, 1.0f, 0.0f },   // Green
+          { 1.0f, 1.0f, 0.0f },   // Yellow
+          { 0.0f, 0.0f, 1.0f },   // Blue
+          { 1.0f, 0.0f, 1.0f },   // Magenta
+          { 0.0f, 1.0f, 1.0f },   // Cyan
+          { 1.0f, 1.0f, 1.0f },   // White
+        };
+        
+        std::array<Color16, 216> table {};
+        for (int rgb6_idx = 0; rgb6_idx < 216; ++rgb6_idx)
+        {
+          RGB6 rgb6_i(static_cast<uint8_t>(rgb6_idx / 36), static_cast<uint8_t>((rgb6_idx / 6) % 6), static_cast<uint8_t>(rgb6_idx % 6));
+          auto [r, g, b] = rgb6_i.to_xterm_float();
+          auto min_dist_sq = math::get_max<float>();
+          int best_color = 0; // Black.
+          for (int color = 0; color < 16; ++color)
+          {
+            auto rgb2 = ansi16_table[color];
+            auto dist_sq = math::distance_squared(r, g, b, rgb2.r, rgb2.g, rgb2.b);
+            if (math::minimize(min_dist_sq, dist_sq))
+              best_color = color;
+          }
+          table[rgb6_idx] = static_cast<Color16>(best_color);
+        }
+        return table;
+      }();
       
-      auto min_dist_sq = math::get_max<float>();
-      int best_color = 0; // Black.
-      for (int color = 0; color < 16; ++color)
-      {
-        auto rgb2 = ansi16_table[color];
-        auto dist_sq = math::distance_squared(r, g, b, rgb2.r, rgb2.g, rgb2.b);
-        if (math::minimize(min_dist_sq, dist_sq))
-          best_color = color;
-      }
-      return static_cast<Color16>(best_color);
+      const auto& rgb6_val = rgb6.value();
+      return rgb6_to_color16[36*rgb6_val.r + 6*rgb6_val.g + rgb6_val.b];
     }
     
     // 24 shades of gray.
@@ -850,6 +865,151 @@ namespace t8
     return colmap;
   }();
   
+  // Nearest regular palette color (indices 0 to 255) in RGB space. Alpha is ignored.
+  Color to_nearest_color(const RGBA& rgba)
+  {
+    Color best_color = Color16::Black;
+    auto min_dist_sq = math::get_max<double>();
+    for (int col_idx = 0; col_idx <= c_max_color_idx; ++col_idx)
+    {
+      auto it = color2rgba.find(Color(col_idx));
+      if (it == color2rgba.end())
+        continue;
+      const auto& rgba0 = it->second;
+      auto dist_sq = math::distance_squared<double>(rgba0.r, rgba0.g, rgba0.b, rgba.r, rgba.g, rgba.b);
+      if (math::minimize(min_dist_sq, dist_sq))
+        best_color = Color(col_idx);
+    }
+    return best_color;
+  }
+  
+  enum class PaletteSubset { Color16, RGB6Gray24, All };
+  // Perceptual : Weighted RGB distance (weights 2, 4, 3), which is closer to how different
+  //   colors look than plain RGB distance while staying cheap.
+  enum class ColorMetric { RGB, Perceptual };
+  
+  // Precomputed RGB -> nearest palette color cube with c_size^3 entries.
+  // Lookups are O(1) instead of a search over the whole palette, at the price of quantizing
+  //   the input to the grid (1/63 per channel, finer than the gray24 spacing).
+  //   Alpha is ignored.
+  class ColorLUT
+  {
+  public:
+    static constexpr int c_size = 64;
+    
+  private:
+    std::vector<uint8_t> m_lut;
+    
+    static int to_grid(double v)
+    {
+      return math::clamp(static_cast<int>(v * (c_size - 1) + 0.5), 0, c_size - 1);
+    }
+    
+  public:
+    ColorLUT(PaletteSubset subset, ColorMetric metric)
+    {
+      const double w[3] = { metric == ColorMetric::Perceptual ? 2. : 1.,
+                            metric == ColorMetric::Perceptual ? 4. : 1.,
+                            metric == ColorMetric::Perceptual ? 3. : 1. };
+      auto f_dist_sq = [&w](const double* p, const RGBA& q)
+      {
+        const double dr = p[0] - q.r, dg = p[1] - q.g, db = p[2] - q.b;
+        return w[0]*dr*dr + w[1]*dg*dg + w[2]*db*db;
+      };
+      
+      std::vector<std::pair<int, RGBA>> color16_rgba;
+      for (int col_idx = 0; col_idx < 16; ++col_idx)
+        color16_rgba.emplace_back(col_idx, color2rgba.at(Color(col_idx)));
+      static constexpr double c_rgb6_levels[6] = { 0., 95/255., 135/255., 175/255., 215/255., 1. };
+      
+      // With fixed channel weights the nearest point of the rgb6 cube is the nearest level
+      //   per channel and the nearest gray is the one closest to the weighted mean,
+      //   so only the 16 colors plus two candidates have to be compared per cell.
+      auto f_nearest_level = [](double v, const double* levels, int num_levels)
+      {
+        int best_idx = 0;
+        for (int l_idx = 1; l_idx < num_levels; ++l_idx)
+          if (std::abs(levels[l_idx] - v) < std::abs(levels[best_idx] - v))
+            best_idx = l_idx;
+        return best_idx;
+      };
+      
+      m_lut.resize(c_size * c_size * c_size);
+      for (int ri = 0; ri < c_size; ++ri)
+        for (int gi = 0; gi < c_size; ++gi)
+          for (int bi = 0; bi < c_size; ++bi)
+          {
+            const double p[3] = { ri / (c_size - 1.), gi / (c_size - 1.), bi / (c_size - 1.) };
+            int best_idx = 0;
+            auto min_dist_sq = math::get_max<double>();
+            auto f_try = [&](int col_idx, const RGBA& rgba)
+            {
+              if (math::minimize(min_dist_sq, f_dist_sq(p, rgba)))
+                best_idx = col_idx;
+            };
+            if (subset != PaletteSubset::RGB6Gray24)
+              for (const auto& [col_idx, rgba] : color16_rgba)
+                f_try(col_idx, rgba);
+            if (subset != PaletteSubset::Color16)
+            {
+              int r6 = f_nearest_level(p[0], c_rgb6_levels, 6);
+              int g6 = f_nearest_level(p[1], c_rgb6_levels, 6);
+              int b6 = f_nearest_level(p[2], c_rgb6_levels, 6);
+              f_try(16 + 36*r6 + 6*g6 + b6, RGBA { c_rgb6_levels[r6], c_rgb6_levels[g6], c_rgb6_levels[b6] });
+              
+              double mean = (w[0]*p[0] + w[1]*p[1] + w[2]*p[2]) / (w[0] + w[1] + w[2]);
+              int gray = math::clamp(static_cast<int>(std::round((mean*255. - 8.) / 10.)), 0, 23);
+              double f = (8 + gray * 10) / 255.;
+              f_try(232 + gray, RGBA { f, f, f });
+            }
+            m_lut[(ri * c_size + gi) * c_size + bi] = static_cast<uint8_t>(best_idx);
+          }
+    }
+    
+    Color lookup(const RGBA& rgba) const
+    {
+      return Color(m_lut[(to_grid(rgba.r) * c_size + to_grid(rgba.g)) * c_size + to_grid(rgba.b)]);
+    }
+    
+    // Shared tables, each one built on first use (thread-safe).
+    static const ColorLUT& get(PaletteSubset subset, ColorMetric metric = ColorMetric::RGB)
+    {
+      switch (metric)
+      {
+        case ColorMetric::RGB: return get_shared<ColorMetric::RGB>(subset);
+        case ColorMetric::Perceptual: return get_shared<ColorMetric::Perceptual>(subset);
+      }
+      return get_shared<ColorMetric::RGB>(subset);
+    }
+    
+  private:
+    template<PaletteSubset S, ColorMetric M>
+    static const ColorLUT& get_shared()
+    {
+      static const ColorLUT lut { S, M };
+      return lut;
+    }
+    
+    template<ColorMetric M>
+    static const ColorLUT& get_shared(PaletteSubset subset)
+    {
+      switch (subset)
+      {
+        case PaletteSubset::Color16: return get_shared<PaletteSubset::Color16, M>();
+        case PaletteSubset::RGB6Gray24: return get_shared<PaletteSubset::RGB6Gray24, M>();
+        case PaletteSubset::All: return get_shared<PaletteSubset::All, M>();
+      }
+      return get_shared<PaletteSubset::All, M>();
+    }
+  };
+  
+  // O(1) approximation of to_nearest_color(), see ColorLUT.
+  inline Color to_nearest_color_lut(const RGBA& rgba, PaletteSubset subset = PaletteSubset::All,
+                                    ColorMetric metric = ColorMetric::RGB)
+  {
+    return ColorLUT::get(subset, metric).lookup(rgba);
+  }
+  
   std::optional<bool> is_bright(Color color, bool perceived_color16 = false)
   {
     if (perceived_color16)
@@ -0,0 +1,290 @@
+//
+//  Compositor.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "ScreenHandler.h"
+#include <array>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+
+namespace t8
+{
+  
+  template<int NR, int NC, typename CharT>
+  class Compositor;
+  
+  // Size independent part of a Viewport, used by the Compositor.
+  template<typename CharT>
+  class ViewportBase
+  {
+    template<int, int, typename>
+    friend class Compositor;
+  
+  protected:
+    RC m_pos { 0, 0 };
+    int m_z = 0;
+    bool m_visible = true;
+    bool m_retain = false;
+    bool m_dirty = true;
+    
+    virtual void clear_surface() = 0;
+  
+  public:
+    virtual ~ViewportBase() = default;
+    
+    virtual int num_rows() const = 0;
+    virtual int num_cols() const = 0;
+    virtual const BufferCell<CharT>& get_cell(int r, int c) const = 0;
+    
+    const RC& get_pos() const { return m_pos; }
+    int get_z() const { return m_z; }
+    bool is_visible() const { return m_visible; }
+    bool is_retained() const { return m_retain; }
+    bool is_dirty() const { return m_dirty; }
+    
+    bool contains(int r, int c) const
+    {
+      return m_pos.r <= r && r < m_pos.r + num_rows() && m_pos.c <= c && c < m_pos.c + num_cols();
+    }
+    
+    // Forces the viewport to be recomposed, e.g. after changing the content through a
+    //   reference kept from an earlier draw() call.
+    void invalidate() { m_dirty = true; }
+  };
+  
+  // A sub-surface of the screen with a ScreenHandler of its own, so that everything that can
+  //   draw to a ScreenHandler (sprites, widgets, text, ...) can draw to a viewport.
+  // A retained viewport keeps its content between frames and is only recomposed after draw()
+  //   or invalidate(). Clear it with draw().clear() before drawing new content, since cells
+  //   that are already written take precedence. Other viewports are cleared by
+  //   Compositor::begin_frame() and recomposed every frame.
+  template<int VR, int VC, typename CharT = char>
+  class Viewport : public ViewportBase<CharT>
+  {
+    ScreenHandler<VR, VC, CharT> m_sh;
+    
+    void clear_surface() override { m_sh.clear(); }
+  
+  public:
+    int num_rows() const override { return VR; }
+    int num_cols() const override { return VC; }
+    const BufferCell<CharT>& get_cell(int r, int c) const override
+    {
+      return m_sh.get_screen_buffer()[VC*r + c];
+    }
+    
+    // For drawing. Marks the viewport as changed.
+    ScreenHandler<VR, VC, CharT>& draw()
+    {
+      this->m_dirty = true;
+      return m_sh;
+    }
+    
+    const ScreenHandler<VR, VC, CharT>& get_screen() const { return m_sh; }
+  };
+  
+  // Composes layered viewports into the screen, e.g. a HUD, a map and a message log.
+  // The composed screen is cached and only the cells covered by changed viewports (or by
+  //   viewports that were moved, hidden, shown or reordered) are recomposed, so static
+  //   (retained) panels don't have to be redrawn every frame.
+  // Viewports are painted in ascending z order. An opaque background hides what is below,
+  //   while a non-space char on a transparent background is drawn on top of what is below.
+  // Typical use per frame : begin_frame(), draw to the viewports, then draw(sh).
+  template<int NR = 30, int NC = 80, typename CharT = char>
+  class Compositor
+  {
+    std::vector<std::unique_ptr<ViewportBase<CharT>>> m_viewports;
+    std::vector<ViewportBase<CharT>*> m_z_order; // Ascending z. Stable for equal z.
+    std::array<BufferCell<CharT>, NR*NC> m_composed;
+    std::array<bool, NR*NC> m_damage;
+    bool m_any_damage = true;
+    int m_num_recomposed_cells = 0;
+    
+    static bool is_transparent(Color col)
+    {
+      return col == Color16::Transparent || col == Color16::Transparent2;
+    }
+    
+    static bool is_empty(const BufferCell<CharT>& cell)
+    {
+      return cell.ch == static_cast<CharT>(' ') && is_transparent(cell.bg);
+    }
+    
+    void damage(const ViewportBase<CharT>* vp)
+    {
+      const int r0 = std::max(0, vp->m_pos.r);
+      const int r1 = std::min(NR, vp->m_pos.r + vp->num_rows());
+      const int c0 = std::max(0, vp->m_pos.c);
+      const int c1 = std::min(NC, vp->m_pos.c + vp->num_cols());
+      for (int r = r0; r < r1; ++r)
+        for (int c = c0; c < c1; ++c)
+          m_damage[NC*r + c] = true;
+      m_any_damage = true;
+    }
+    
+    void sort_z_order()
+    {
+      std::stable_sort(m_z_order.begin(), m_z_order.end(),
+                       [](const auto* vpA, const auto* vpB) { return vpA->m_z < vpB->m_z; });
+    }
+    
+    void recompose_cell(int r, int c)
+    {
+      BufferCell<CharT> dst { static_cast<CharT>(' '), Color16::Default, Color16::Transparent };
+      for (const auto* vp : m_z_order)
+      {
+        if (!vp->m_visible || !vp->contains(r, c))
+          continue;
+        const auto& src = vp->get_cell(r - vp->m_pos.r, c - vp->m_pos.c);
+        if (!is_transparent(src.bg))
+          dst = src;
+        else if (src.ch != static_cast<CharT>(' '))
+        {
+          dst.ch = src.ch;
+          dst.fg = src.fg;
+        }
+      }
+      m_composed[NC*r + c] = dst;
+    }
+  
+  public:
+    Compositor()
+    {
+      m_composed.fill({ static_cast<CharT>(' '), Color16::Default, Color16::Transparent });
+      m_damage.fill(true);
+    }
+    
+    // The compositor owns the viewport. pos is the top left corner on the screen and may be
+    //   partly outside of it.
+    template<int VR, int VC>
+    Viewport<VR, VC, CharT>* add_viewport(const RC& pos, int z = 0, bool retain = false)
+    {
+      auto vp = std::make_unique<Viewport<VR, VC, CharT>>();
+      auto* vp_ptr = vp.get();
+      ViewportBase<CharT>* vp_base = vp_ptr;
+      vp_base->m_pos = pos;
+      vp_base->m_z = z;
+      vp_base->m_retain = retain;
+      vp_base->clear_surface();
+      m_viewports.emplace_back(std::move(vp));
+      m_z_order.emplace_back(vp_base);
+      sort_z_order();
+      damage(vp_base);
+      return vp_ptr;
+    }
+    
+    bool remove_viewport(const ViewportBase<CharT>* vp)
+    {
+      auto it = std::find_if(m_viewports.begin(), m_viewports.end(), [vp](const auto& v) { return v.get() == vp; });
+      if (it == m_viewports.end())
+      {
+        std::cerr << "ERROR in Compositor::remove_viewport() : Unknown viewport." << std::endl;
+        return false;
+      }
+      damage(vp);
+      m_z_order.erase(std::find(m_z_order.begin(), m_z_order.end(), it->get()));
+      m_viewports.erase(it);
+      return true;
+    }
+    
+    void set_position(ViewportBase<CharT>* vp, const RC& pos)
+    {
+      if (vp->m_pos == pos)
+        return;
+      damage(vp);
+      vp->m_pos = pos;
+      damage(vp);
+    }
+    
+    void set_z(ViewportBase<CharT>* vp, int z)
+    {
+      if (vp->m_z == z)
+        return;
+      vp->m_z = z;
+      sort_z_order();
+      damage(vp);
+    }
+    
+    void set_visible(ViewportBase<CharT>* vp, bool visible)
+    {
+      if (vp->m_visible == visible)
+        return;
+      vp->m_visible = visible;
+      damage(vp);
+    }
+    
+    // Clears the non-retained viewports.
+    void begin_frame()
+    {
+      for (auto& vp : m_viewports)
+      {
+        if (!vp->m_retain)
+        {
+          vp->clear_surface();
+          vp->m_dirty = true;
+        }
+      }
+    }
+    
+    // Recomposes the cells of the changed viewports. Called by draw().
+    void compose()
+    {
+      m_num_recomposed_cells = 0;
+      for (auto* vp : m_z_order)
+      {
+        if (vp->m_dirty)
+        {
+          if (vp->m_visible)
+            damage(vp);
+          vp->m_dirty = false;
+        }
+      }
+      if (!m_any_damage)
+        return;
+      for (int r = 0; r < NR; ++r)
+      {
+        for (int c = 0; c < NC; ++c)
+        {
+          const int idx = NC*r + c;
+          if (m_damage[idx])
+          {
+            recompose_cell(r, c);
+            m_damage[idx] = false;
+            m_num_recomposed_cells++;
+          }
+        }
+      }
+      m_any_damage = false;
+    }
+    
+    // Composes and writes the result to sh. Like any other write_buffer(), cells that are
+    //   already drawn in sh take precedence.
+    void draw(ScreenHandler<NR, NC, CharT>& sh)
+    {
+      compose();
+      for (int r = 0; r < NR; ++r)
+      {
+        for (int c = 0; c < NC; ++c)
+        {
+          const auto& cell = m_composed[NC*r + c];
+          if (!is_empty(cell))
+            sh.write_buffer(cell, r, c);
+        }
+      }
+    }
+    
+    const BufferCell<CharT>& get_composed_cell(int r, int c) const { return m_composed[NC*r + c]; }
+    
+    // Number of cells recomposed by the latest compose().
+    int get_num_recomposed_cells() const { return m_num_recomposed_cells; }
+    
+    int num_viewports() const { return stlutils::sizeI(m_viewports); }
+  };
+
+}
@@ -2,6 +2,7 @@
 #include "Text.h"
 #include "Styles.h"
 #include "GlyphString.h"
+#include "ShapedText.h"
 #include "../geom/Rectangle.h"
 #include "../geom/RC.h"
 #include "../drawing/Texture.h"
@@ -24,11 +25,21 @@ namespace t8
   class ScreenHandler;
 }
 
+namespace t8x
+{
+  template<typename CharT>
+  class ScreenResampler;
+}
+
 namespace t8x::screen_scaling
 {
   template<int NRo, int NCo, int NRi, int NCi, typename CharT>
   void resample(const t8::ScreenHandler<NRi, NCi, CharT>& sh_src,
                 t8::ScreenHandler<NRo, NCo, CharT>& sh_dst);
+  template<int NRo, int NCo, int NRi, int NCi, typename CharT>
+  void resample(const t8::ScreenHandler<NRi, NCi, CharT>& sh_src,
+                t8::ScreenHandler<NRo, NCo, CharT>& sh_dst,
+                t8x::ScreenResampler<CharT>& resampler);
 }
 
 namespace t8
@@ -238,6 +249,29 @@ namespace t8
       return write_buffer(ss_vec, pos.r, pos.c);
     }
     
+    // Copies the cells of text that has been shaped up front, see ShapedText.
+    //   Returns the number of columns advanced.
+    int write_buffer(const ShapedText<CharT>& shaped_text, int r, int c)
+    {
+      if (r >= 0 && r < NR)
+      {
+        const auto& cells = shaped_text.get_cells();
+        const auto& cell_cols = shaped_text.get_cell_cols();
+        const int num_cells = static_cast<int>(cells.size());
+        for (int cell_idx = 0; cell_idx < num_cells; ++cell_idx)
+        {
+          const auto& cell = cells[cell_idx];
+          write_buffer_cell(cell.ch, r, c, cell_cols[cell_idx], cell.fg, cell.bg);
+        }
+      }
+      return shaped_text.width();
+    }
+    
+    int write_buffer(const ShapedText<CharT>& shaped_text, const RC& pos)
+    {
+      return write_buffer(shaped_text, pos.r, pos.c);
+    }
+    
     void add_ordered_text(const OrderedText& text)
     {
       ordered_texts.emplace_back(text);
@@ -252,6 +286,14 @@ namespace t8
       ordered_texts.clear();
     }
     
+    // Writes an already resolved cell, e.g. from another ScreenHandler.
+    void write_buffer(const BufferCell<CharT>& cell, int r, int c)
+    {
+      if (r < 0 || r >= NR)
+        return;
+      write_buffer_cell(cell.ch, r, c, 0, cell.fg, cell.bg);
+    }
+    
     void write_buffer(const Glyph& glyph, const RC& pos, const Style& style)
     {
       write_buffer(glyph, pos.r, pos.c, style.fg_color, style.bg_color);
@@ -461,6 +503,7 @@ namespace t8
     
     void diff_buffers(Color clear_bg_color)
     {
+      ProfileScope prof_scope(ProfileZone::ScreenDiff);
       for (int r = 0; r < NR; ++r)
       {
         for (int c = 0; c < NC; ++c)
@@ -772,9 +815,15 @@ namespace t8
       screen_buffer = new_screen_buffer;
     }
     
+    const std::array<BufferCell<CharT>, NR*NC>& get_screen_buffer() const { return screen_buffer; }
+    
     template<int NRo, int NCo, int NRi, int NCi, typename char_t>
     friend void t8x::screen_scaling::resample(const ScreenHandler<NRi, NCi, char_t>& sh_src,
                                               ScreenHandler<NRo, NCo, char_t>& sh_dst);
+    template<int NRo, int NCo, int NRi, int NCi, typename char_t>
+    friend void t8x::screen_scaling::resample(const ScreenHandler<NRi, NCi, char_t>& sh_src,
+                                              ScreenHandler<NRo, NCo, char_t>& sh_dst,
+                                              t8x::ScreenResampler<char_t>& resampler);
   };
   
 }
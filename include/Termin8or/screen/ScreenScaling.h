@@ -8,6 +8,14 @@
 #pragma once
 #include "ScreenHandler.h"
 #include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <cmath>
 
 namespace t8x
 {
@@ -33,7 +41,7 @@ namespace t8x
   char find_closest_val(double shading_value)
   {
     // Character set representing different shades
-    const std::string shading_charset = "$#@&%*+=)(\\/\":^_-,. ";
+    static constexpr std::string_view shading_charset = "$#@&%*+=)(\\/\":^_-,. ";
     double t = shading_value;
     auto index = static_cast<int>((1-t) * (shading_charset.size() - 1));
     return shading_charset[index];
@@ -43,7 +51,7 @@ namespace t8x
   char32_t find_closest_val(double shading_value)
   {
     // Character set representing different shades
-    const std::string shading_charset = "$#@&%*+=)(\\/\":^_-,. ";
+    static constexpr std::string_view shading_charset = "$#@&%*+=)(\\/\":^_-,. ";
     double t = shading_value;
     auto index = static_cast<int>((1-t) * (shading_charset.size() - 1));
     return shading_charset[index];
@@ -52,24 +60,20 @@ namespace t8x
   template<>
   Color find_closest_val(t8::RGBA shading_value)
   {
-    // Character set representing different shades
+    // Nearest opaque palette color from the lookup cube, then Transparent2 (black with zero alpha)
+    //   is picked instead if it is closer when alpha is taken into account.
     auto t = shading_value;
-    auto distance_squared = [&](Color color, const t8::RGBA& rgba1)
+    auto distance_squared = [](const t8::RGBA& rgba0, const t8::RGBA& rgba1)
     {
-      auto it = t8::color2rgba.find(color);
-      if (it != t8::color2rgba.end())
-      {
-        auto rgba0 = it->second;
-        return math::distance_squared<double>(rgba0.r, rgba0.g, rgba0.b, rgba0.a,
-                                              rgba1.r, rgba1.g, rgba1.b, rgba1.a);
-      }
-      return math::get_max<double>();
+      return math::distance_squared<double>(rgba0.r, rgba0.g, rgba0.b, rgba0.a,
+                                            rgba1.r, rgba1.g, rgba1.b, rgba1.a);
     };
-    Color best_color = Color16::Default;
-    auto min_dist_sq = math::get_max<double>();
-    for (int col_idx = t8::c_min_color_idx; col_idx <= t8::c_max_color_idx; ++col_idx)
-      if (math::minimize(min_dist_sq, distance_squared(Color(col_idx), t)))
-        best_color = Color(col_idx);
+    Color best_color = t8::to_nearest_color_lut(t);
+    auto it = t8::color2rgba.find(best_color);
+    if (it == t8::color2rgba.end())
+      return Color16::Transparent2;
+    if (distance_squared(t8::RGBA { 0, 0, 0, 0 }, t) <= distance_squared(it->second, t))
+      return Color16::Transparent2;
     return best_color;
   }
   
@@ -210,6 +214,364 @@ namespace t8x
     }
     return buffer_new;
   }
+  
+  enum class ResampleMode { Bilinear, Nearest, AreaAverage };
+  
+  // Resampler for buffer sizes that are only known at runtime, e.g. when scaling to the
+  //   current terminal size every frame.
+  // Bilinear gives the same result as resample_data() but is separable: the source cells are
+  //   converted to shading and RGBA planes once, then filtered horizontally and vertically.
+  //   The taps of each axis are only recomputed when the sizes, mode or offset change.
+  // Nearest copies the source cells as they are and AreaAverage averages all source cells
+  //   covered by a target cell, which is the smoother choice when downscaling.
+  // Each pass is split into row bands that run on up to num_threads threads. The worker
+  //   threads are started on first use and kept until the resampler is destroyed or the
+  //   number of threads is changed. Small buffers are resampled on the calling thread only.
+  template<typename CharT>
+  class ScreenResampler
+  {
+    // Runs all but the last row band of a pass on persistent worker threads.
+    class BandWorkers
+    {
+      std::vector<std::thread> m_threads;
+      std::mutex m_mutex;
+      std::condition_variable m_cv_start, m_cv_done;
+      std::function<void(int, int)> m_job;
+      std::vector<std::pair<int, int>> m_bands; // Band of worker i.
+      int m_generation = 0;
+      int m_num_pending = 0;
+      bool m_stop = false;
+      
+      void worker_loop(int worker_idx)
+      {
+        int generation = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+          m_cv_start.wait(lock, [&]() { return m_stop || m_generation != generation; });
+          if (m_stop)
+            return;
+          generation = m_generation;
+          if (worker_idx >= stlutils::sizeI(m_bands))
+            continue;
+          auto [r0, r1] = m_bands[worker_idx];
+          lock.unlock();
+          m_job(r0, r1);
+          lock.lock();
+          if (--m_num_pending == 0)
+            m_cv_done.notify_one();
+        }
+      }
+      
+    public:
+      BandWorkers(int num_workers)
+      {
+        for (int worker_idx = 0; worker_idx < num_workers; ++worker_idx)
+          m_threads.emplace_back(&BandWorkers::worker_loop, this, worker_idx);
+      }
+      
+      ~BandWorkers()
+      {
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_stop = true;
+        }
+        m_cv_start.notify_all();
+        for (auto& th : m_threads)
+          th.join();
+      }
+      
+      int num_workers() const { return stlutils::sizeI(m_threads); }
+      
+      // At most num_workers() + 1 bands. The last band runs on the calling thread.
+      template<typename F>
+      void run(const std::vector<std::pair<int, int>>& bands, const F& f)
+      {
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_job = std::cref(f);
+          m_bands.assign(bands.begin(), bands.end() - 1);
+          m_num_pending = stlutils::sizeI(m_bands);
+          m_generation++;
+        }
+        m_cv_start.notify_all();
+        f(bands.back().first, bands.back().second);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv_done.wait(lock, [this]() { return m_num_pending == 0; });
+        m_job = nullptr;
+      }
+    };
+    
+    struct Tap
+    {
+      int src_idx = 0;
+      double weight = 0.;
+    };
+    struct AxisTaps
+    {
+      std::vector<int> start; // Taps of target index i are [start[i], start[i + 1]).
+      std::vector<Tap> taps;
+    };
+    
+    static constexpr int c_min_cells_per_band = 2048;
+    
+    ResampleMode m_mode = ResampleMode::Bilinear;
+    int m_num_threads = 1;
+    std::unique_ptr<BandWorkers> m_workers;
+    std::vector<std::pair<int, int>> m_bands;
+    
+    int m_nri = -1, m_nci = -1, m_nro = -1, m_nco = -1;
+    double m_offs = 0.;
+    AxisTaps m_row_taps, m_col_taps;
+    
+    std::vector<double> m_shading;
+    std::vector<t8::RGBA> m_fg, m_bg;
+    std::vector<double> m_tmp_shading; // After the horizontal pass (nri x nco).
+    std::vector<t8::RGBA> m_tmp_fg, m_tmp_bg;
+    
+    static t8::RGBA to_rgba(Color color)
+    {
+      using RGBATable = std::array<t8::RGBA, t8::c_max_color_idx - t8::c_min_color_idx + 1>;
+      static const RGBATable table = []()
+      {
+        RGBATable tbl;
+        for (int col_idx = t8::c_min_color_idx; col_idx <= t8::c_max_color_idx; ++col_idx)
+          tbl[col_idx - t8::c_min_color_idx] = find_closest_shading_value(Color(col_idx));
+        return tbl;
+      }();
+      auto col_idx = color.get_index();
+      if (col_idx < t8::c_min_color_idx || col_idx > t8::c_max_color_idx)
+        return { 0, 0, 0, 0 };
+      return table[col_idx - t8::c_min_color_idx];
+    }
+    
+    static void add_weighted(t8::RGBA& acc, double w, const t8::RGBA& val)
+    {
+      acc.r += w * val.r;
+      acc.g += w * val.g;
+      acc.b += w * val.b;
+      acc.a += w * val.a;
+    }
+    
+    static void calc_taps(AxisTaps& axis, int num_in, int num_out, double offs, ResampleMode mode)
+    {
+      axis.start.assign(1, 0);
+      axis.taps.clear();
+      // Taps outside of the source contribute zero (a blank, Transparent2 cell), like in resample_data().
+      auto f_add = [&axis, num_in](int src_idx, double weight)
+      {
+        if (0 <= src_idx && src_idx < num_in && weight != 0.)
+          axis.taps.push_back({ src_idx, weight });
+      };
+      const double ratio = num_out > 1 ? static_cast<double>(num_in - 1) / (num_out - 1) : 0.;
+      const double scale = static_cast<double>(num_in) / num_out;
+      for (int out_idx = 0; out_idx < num_out; ++out_idx)
+      {
+        switch (mode)
+        {
+          case ResampleMode::Bilinear:
+          {
+            double pos = out_idx * ratio + offs;
+            int lo = static_cast<int>(pos);
+            f_add(lo, lo + 1 - pos);
+            f_add(lo + 1, pos - lo);
+            break;
+          }
+          case ResampleMode::Nearest:
+            f_add(static_cast<int>(std::floor(out_idx * ratio + offs + 0.5)), 1.);
+            break;
+          case ResampleMode::AreaAverage:
+          {
+            double x0 = out_idx * scale + offs;
+            double x1 = x0 + scale;
+            for (int src_idx = static_cast<int>(std::floor(x0)); src_idx < x1; ++src_idx)
+              f_add(src_idx, (std::min<double>(x1, src_idx + 1) - std::max<double>(x0, src_idx)) / scale);
+            break;
+          }
+        }
+        axis.start.emplace_back(static_cast<int>(axis.taps.size()));
+      }
+    }
+    
+    void update_taps(int nri, int nci, int nro, int nco, double offs)
+    {
+      if (nri == m_nri && nci == m_nci && nro == m_nro && nco == m_nco && offs == m_offs)
+        return;
+      calc_taps(m_row_taps, nri, nro, offs, m_mode);
+      calc_taps(m_col_taps, nci, nco, offs, m_mode);
+      m_nri = nri;
+      m_nci = nci;
+      m_nro = nro;
+      m_nco = nco;
+      m_offs = offs;
+    }
+    
+    // Calls f(r0, r1) for bands of rows [r0, r1), the last band on the calling thread.
+    template<typename F>
+    void for_each_row_band(int num_rows, int num_cols, const F& f)
+    {
+      int num_bands = std::min({ m_num_threads, num_rows, num_rows * num_cols / c_min_cells_per_band });
+      if (num_bands <= 1)
+      {
+        f(0, num_rows);
+        return;
+      }
+      if (m_workers == nullptr)
+        m_workers = std::make_unique<BandWorkers>(m_num_threads - 1);
+      m_bands.clear();
+      int r0 = 0;
+      for (int band_idx = 0; band_idx < num_bands; ++band_idx)
+      {
+        int r1 = num_rows * (band_idx + 1) / num_bands;
+        m_bands.emplace_back(r0, r1);
+        r0 = r1;
+      }
+      m_workers->run(m_bands, f);
+    }
+    
+  public:
+    // num_threads = 0 : Number of hardware threads.
+    ScreenResampler(ResampleMode mode = ResampleMode::Bilinear, int num_threads = 0)
+      : m_mode(mode)
+    {
+      set_num_threads(num_threads);
+    }
+    
+    void set_mode(ResampleMode mode)
+    {
+      if (mode != m_mode)
+      {
+        m_mode = mode;
+        m_nri = -1; // Recompute the taps.
+      }
+    }
+    ResampleMode get_mode() const { return m_mode; }
+    
+    void set_num_threads(int num_threads)
+    {
+      if (num_threads <= 0)
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+      num_threads = std::max(1, num_threads);
+      if (num_threads != m_num_threads)
+      {
+        m_num_threads = num_threads;
+        m_workers.reset();
+      }
+    }
+    int get_num_threads() const { return m_num_threads; }
+    
+    // src : nri x nci cells, dst : nro x nco cells, both row-major.
+    bool resample(const t8::BufferCell<CharT>* src, int nri, int nci,
+                  t8::BufferCell<CharT>* dst, int nro, int nco, double offs = 0.)
+    {
+      if (src == nullptr || dst == nullptr || nri <= 0 || nci <= 0 || nro <= 0 || nco <= 0)
+      {
+        std::cerr << "ERROR in ScreenResampler::resample() : Invalid buffers or buffer sizes.\n";
+        return false;
+      }
+      update_taps(nri, nci, nro, nco, offs);
+      
+      if (m_mode == ResampleMode::Nearest)
+      {
+        const t8::BufferCell<CharT> empty_cell { ' ', Color16::Default, Color16::Transparent };
+        for_each_row_band(nro, nco, [&](int r0, int r1)
+        {
+          for (int r = r0; r < r1; ++r)
+          {
+            int rt = m_row_taps.start[r];
+            bool row_valid = rt < m_row_taps.start[r + 1];
+            for (int c = 0; c < nco; ++c)
+            {
+              int ct = m_col_taps.start[c];
+              bool col_valid = ct < m_col_taps.start[c + 1];
+              dst[r*nco + c] = row_valid && col_valid ?
+                src[m_row_taps.taps[rt].src_idx*nci + m_col_taps.taps[ct].src_idx] : empty_cell;
+            }
+          }
+        });
+        return true;
+      }
+      
+      const int area_i = nri * nci;
+      m_shading.resize(area_i);
+      m_fg.resize(area_i);
+      m_bg.resize(area_i);
+      for_each_row_band(nri, nci, [&](int r0, int r1)
+      {
+        for (int idx = r0 * nci; idx < r1 * nci; ++idx)
+        {
+          const auto& cell = src[idx];
+          m_shading[idx] = find_closest_shading_value(cell.ch);
+          m_fg[idx] = to_rgba(cell.fg);
+          m_bg[idx] = to_rgba(cell.bg);
+        }
+      });
+      
+      m_tmp_shading.resize(nri * nco);
+      m_tmp_fg.resize(nri * nco);
+      m_tmp_bg.resize(nri * nco);
+      for_each_row_band(nri, nco, [&](int r0, int r1)
+      {
+        for (int r = r0; r < r1; ++r)
+          for (int c = 0; c < nco; ++c)
+          {
+            double sh = 0.;
+            t8::RGBA fg { 0, 0, 0, 0 };
+            t8::RGBA bg { 0, 0, 0, 0 };
+            for (int t_idx = m_col_taps.start[c]; t_idx < m_col_taps.start[c + 1]; ++t_idx)
+            {
+              const auto& tap = m_col_taps.taps[t_idx];
+              int src_idx = r*nci + tap.src_idx;
+              sh += tap.weight * m_shading[src_idx];
+              add_weighted(fg, tap.weight, m_fg[src_idx]);
+              add_weighted(bg, tap.weight, m_bg[src_idx]);
+            }
+            m_tmp_shading[r*nco + c] = sh;
+            m_tmp_fg[r*nco + c] = fg;
+            m_tmp_bg[r*nco + c] = bg;
+          }
+      });
+      
+      for_each_row_band(nro, nco, [&](int r0, int r1)
+      {
+        for (int r = r0; r < r1; ++r)
+          for (int c = 0; c < nco; ++c)
+          {
+            double sh = 0.;
+            t8::RGBA fg { 0, 0, 0, 0 };
+            t8::RGBA bg { 0, 0, 0, 0 };
+            for (int t_idx = m_row_taps.start[r]; t_idx < m_row_taps.start[r + 1]; ++t_idx)
+            {
+              const auto& tap = m_row_taps.taps[t_idx];
+              int tmp_idx = tap.src_idx*nco + c;
+              sh += tap.weight * m_tmp_shading[tmp_idx];
+              add_weighted(fg, tap.weight, m_tmp_fg[tmp_idx]);
+              add_weighted(bg, tap.weight, m_tmp_bg[tmp_idx]);
+            }
+            dst[r*nco + c] =
+            {
+              find_closest_val<double, CharT>(clamp(sh)),
+              find_closest_val<t8::RGBA, Color>(clamp(fg)),
+              find_closest_val<t8::RGBA, Color>(clamp(bg))
+            };
+          }
+      });
+      return true;
+    }
+    
+    // Resizes dst to nro x nco.
+    bool resample(const std::vector<t8::BufferCell<CharT>>& src, int nri, int nci,
+                  std::vector<t8::BufferCell<CharT>>& dst, int nro, int nco, double offs = 0.)
+    {
+      if (static_cast<int>(src.size()) != nri * nci)
+      {
+        std::cerr << "ERROR in ScreenResampler::resample() : Source buffer size doesn't match " << nri << " x " << nci << ".\n";
+        return false;
+      }
+      dst.resize(std::max(0, nro * nco));
+      return resample(src.data(), nri, nci, dst.data(), nro, nco, offs);
+    }
+  };
 
 }
 
@@ -225,4 +587,13 @@ namespace t8x::screen_scaling
       t8x::resample_data<CharT, NRi, NCi, NRo, NCo>(sh_src.screen_buffer, 0);
     sh_dst.overwrite_data(new_screen_buffer);
   }
+  
+  // Same as above, but without the stack copy and with the resampler's mode and threads.
+  template<int NRo, int NCo, int NRi, int NCi, typename CharT>
+  void resample(const t8::ScreenHandler<NRi, NCi, CharT>& sh_src,
+                t8::ScreenHandler<NRo, NCo, CharT>& sh_dst,
+                t8x::ScreenResampler<CharT>& resampler)
+  {
+    resampler.resample(sh_src.screen_buffer.data(), NRi, NCi, sh_dst.screen_buffer.data(), NRo, NCo);
+  }
 }
@@ -0,0 +1,196 @@
+//
+//  ShapedText.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "Text.h"
+#include "GlyphString.h"
+#include "StyledString.h"
+#include <string>
+#include <vector>
+#include <variant>
+#include <type_traits>
+
+
+namespace t8
+{
+  
+  // Text that is decoded and resolved to buffer cells once (UTF-8 decoding, single-width
+  //   glyph resolution and ASCII fallback), so that ScreenHandler::write_buffer() only has
+  //   to copy the cells. Meant for HUD text and labels that don't change every frame.
+  // The cells are exactly the ones the corresponding write_buffer() overloads for
+  //   std::string, GlyphString and std::vector<StyledString> would write. They are
+  //   reshaped automatically if the ASCII fallback mode of the terminal changes.
+  template<typename CharT>
+  class ShapedText
+  {
+    static_assert(std::is_same_v<CharT, char> || std::is_same_v<CharT, char32_t>,
+                  "ERROR in ShapedText<CharT> : Unsupported CharT type.");
+    
+    struct Segment
+    {
+      std::variant<std::string, GlyphString> text;
+      Color fg_color = Color16::Default;
+      Color bg_color = Color16::Transparent;
+      int advance = -1; // -1 : Number of columns of the segment.
+    };
+    std::vector<Segment> m_segments;
+    
+    mutable std::vector<BufferCell<CharT>> m_cells;
+    mutable std::vector<int> m_cell_cols; // Column of each cell relative to the start of the text.
+    mutable int m_width = 0;
+    mutable bool m_shaped = false;
+    mutable bool m_shaped_ascii_fallback = false;
+    
+    void add_cell(CharT ch, int col, const Segment& seg) const
+    {
+      m_cells.push_back({ ch, seg.fg_color, seg.bg_color });
+      m_cell_cols.emplace_back(col);
+    }
+    
+    int shape_string(const std::string& str, int col0, const Segment& seg) const
+    {
+      int ci = 0;
+      if constexpr (std::is_same_v<CharT, char>)
+      {
+        for (char ch : str)
+          add_cell(static_cast<char>(normalize_byte(ch)), col0 + ci++, seg);
+      }
+      else
+      {
+        size_t byte_idx = 0;
+        char32_t ch32 = utf8::none;
+        while (utf8::decode_next_utf8_char32(str, ch32, byte_idx))
+          add_cell(term::get_renderable_char32(ch32), col0 + ci++, seg);
+      }
+      return ci;
+    }
+    
+    int shape_glyph_string(const GlyphString& gstr, int col0, const Segment& seg) const
+    {
+      const int num_glyphs = static_cast<int>(gstr.size());
+      for (int gi = 0; gi < num_glyphs; ++gi)
+      {
+        const auto& glyph = gstr[gi];
+        if (glyph.empty())
+          continue;
+        if constexpr (std::is_same_v<CharT, char>)
+        {
+          auto enc = term::encode_single_width_glyph<CharT>(glyph.preferred, glyph.fallback);
+          const int num_bytes = static_cast<int>(enc.size());
+          for (int bi = 0; bi < num_bytes; ++bi)
+            add_cell(static_cast<char>(normalize_byte(enc[bi])), col0 + gi + bi, seg);
+        }
+        else
+          add_cell(normalize_cp(term::resolve_single_width_glyph<CharT>(glyph.preferred, glyph.fallback)),
+                   col0 + gi, seg);
+      }
+      return num_glyphs;
+    }
+    
+    void update() const
+    {
+      if (m_shaped && m_shaped_ascii_fallback == term::force_ascii_fallback)
+        return;
+      
+      m_cells.clear();
+      m_cell_cols.clear();
+      m_width = 0;
+      for (const auto& seg : m_segments)
+      {
+        int num_cols = 0;
+        if (const auto* str = std::get_if<std::string>(&seg.text))
+          num_cols = shape_string(*str, m_width, seg);
+        else
+          num_cols = shape_glyph_string(std::get<GlyphString>(seg.text), m_width, seg);
+        m_width += seg.advance >= 0 ? seg.advance : num_cols;
+      }
+      m_shaped = true;
+      m_shaped_ascii_fallback = term::force_ascii_fallback;
+    }
+  
+  public:
+    ShapedText() = default;
+    ShapedText(const std::string& str, Color fg_color, Color bg_color = Color16::Transparent)
+    {
+      append(str, fg_color, bg_color);
+    }
+    ShapedText(const GlyphString& gstr, Color fg_color, Color bg_color = Color16::Transparent)
+    {
+      append(gstr, fg_color, bg_color);
+    }
+    ShapedText(const std::vector<StyledString>& ss_vec)
+    {
+      for (const auto& ss : ss_vec)
+        append(ss);
+    }
+    
+    void append(const std::string& str, Color fg_color, Color bg_color = Color16::Transparent)
+    {
+      m_segments.push_back({ str, fg_color, bg_color });
+      m_shaped = false;
+    }
+    
+    void append(const GlyphString& gstr, Color fg_color, Color bg_color = Color16::Transparent)
+    {
+      m_segments.push_back({ gstr, fg_color, bg_color });
+      m_shaped = false;
+    }
+    
+    // Advances by ss.width, like ScreenHandler::write_buffer(const std::vector<StyledString>&, ...).
+    void append(const StyledString& ss)
+    {
+      m_segments.push_back({ ss.text, ss.style.fg_color, ss.style.bg_color, ss.width });
+      m_shaped = false;
+    }
+    
+    // Replaces the text, but only invalidates the shaped cells if something changed.
+    //   Returns true if it changed.
+    bool assign(const std::string& str, Color fg_color, Color bg_color = Color16::Transparent)
+    {
+      if (m_segments.size() == 1)
+      {
+        const auto& seg = m_segments[0];
+        const auto* seg_str = std::get_if<std::string>(&seg.text);
+        if (seg_str != nullptr && *seg_str == str && seg.advance == -1
+            && seg.fg_color == fg_color && seg.bg_color == bg_color)
+          return false;
+      }
+      clear();
+      append(str, fg_color, bg_color);
+      return true;
+    }
+    
+    void clear()
+    {
+      m_segments.clear();
+      m_shaped = false;
+    }
+    
+    bool empty() const { return m_segments.empty(); }
+    
+    const std::vector<BufferCell<CharT>>& get_cells() const
+    {
+      update();
+      return m_cells;
+    }
+    
+    const std::vector<int>& get_cell_cols() const
+    {
+      update();
+      return m_cell_cols;
+    }
+    
+    // Number of columns advanced, same as the return value of
+    //   ScreenHandler::write_buffer(const std::vector<StyledString>&, ...) for styled strings.
+    int width() const
+    {
+      update();
+      return m_width;
+    }
+  };
+
+}
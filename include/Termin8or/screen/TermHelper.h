@@ -11,6 +11,7 @@
 #include <Core/Term.h>
 #include <Core/StlUtils.h>
 #include <array>
+#include <atomic>
 
 
 namespace t8
@@ -34,6 +35,7 @@ namespace t8
       }();
     }
     
+    // A cached result of can_render_single_column_cp(), see find_render_cache_entry().
     struct RenderCacheEntry
     {
       char32_t cp = none32;
@@ -585,8 +587,30 @@ namespace t8
         { 0xFB01, 0xFB02 }, // Alphabetic Presentation Forms
       }};
       
-      inline std::array<RenderCacheEntry, 512> render_cache {};
-      inline constexpr size_t mask = render_cache.size() - 1;
+      // 4-way set-associative cache of can_render_single_column_cp(cp, false).
+      // Each entry is a single atomic word packed as (cp << 2) | (renderable << 1) | valid,
+      //   so lookups and inserts are lock-free and can be done from several render threads.
+      //   A racing insert can at worst evict an entry that then has to be recomputed.
+      inline constexpr size_t render_cache_num_ways = 4;
+      inline constexpr size_t render_cache_num_sets = 1024;
+      inline std::array<std::atomic<uint32_t>, render_cache_num_sets * render_cache_num_ways> render_cache {};
+      
+      inline constexpr uint32_t pack_render_cache_entry(char32_t cp, bool renderable)
+      {
+        return (static_cast<uint32_t>(cp) << 2) | (static_cast<uint32_t>(renderable) << 1) | 1u;
+      }
+      
+      inline constexpr uint32_t hash_render_cache_cp(char32_t cp)
+      {
+        uint32_t h = static_cast<uint32_t>(cp) * 0x9E3779B1u;
+        return h ^ (h >> 15);
+      }
+      
+      // Index of the first way of the set of cp.
+      inline constexpr size_t get_render_cache_set_idx(char32_t cp)
+      {
+        return (hash_render_cache_cp(cp) & (render_cache_num_sets - 1)) * render_cache_num_ways;
+      }
     }
 
     // /////////////////////////////////////////////////////////////
@@ -694,26 +718,63 @@ namespace t8
       return may_be_single_column(cp);
     }
     
+    // Thread-safe. Use clear_render_cache() if the terminal mode or locale changes.
     inline bool can_render_single_column_cp_cached(char32_t cp)
     {
-      char32_t h = cp;
-      h ^= h >> 8;
-      h ^= h >> 16;
+      // Renderable on all supported terminals, so skip the cache.
+      if (0x20 <= cp && cp <= 0x7E)
+        return true;
+      // Doesn't fit the packed entries, and is rejected by can_render_single_column_cp() anyway.
+      if (cp > 0x10FFFF)
+        return false;
       
-      size_t idx = static_cast<size_t>(h) & impl::mask;
-      auto& entry = impl::render_cache[idx];
+      const uint32_t h = impl::hash_render_cache_cp(cp);
+      const size_t set_idx = impl::get_render_cache_set_idx(cp);
       
-      if (entry.cp == cp)
-        return entry.renderable != 0;
+      const uint32_t key_yes = impl::pack_render_cache_entry(cp, true);
+      const uint32_t key_no = impl::pack_render_cache_entry(cp, false);
+      size_t victim = impl::render_cache_num_ways;
+      for (size_t way = 0; way < impl::render_cache_num_ways; ++way)
+      {
+        auto entry = impl::render_cache[set_idx + way].load(std::memory_order_relaxed);
+        if (entry == key_yes)
+          return true;
+        if (entry == key_no)
+          return false;
+        if (entry == 0 && victim == impl::render_cache_num_ways)
+          victim = way;
+      }
+      if (victim == impl::render_cache_num_ways)
+        victim = (h >> 20) & (impl::render_cache_num_ways - 1);
       
       bool result = can_render_single_column_cp(cp, false);
       
-      entry.cp = cp;
-      entry.renderable = static_cast<uint8_t>(result);
+      impl::render_cache[set_idx + victim].store(result ? key_yes : key_no, std::memory_order_relaxed);
       
       return result;
     }
     
+    // Returns an entry with cp = none32 if cp isn't cached. Printable ASCII is never cached.
+    inline RenderCacheEntry find_render_cache_entry(char32_t cp)
+    {
+      if (cp > 0x10FFFF)
+        return {};
+      const size_t set_idx = impl::get_render_cache_set_idx(cp);
+      for (size_t way = 0; way < impl::render_cache_num_ways; ++way)
+      {
+        auto entry = impl::render_cache[set_idx + way].load(std::memory_order_relaxed);
+        if ((entry & 1u) != 0 && (entry >> 2) == static_cast<uint32_t>(cp))
+          return { cp, static_cast<uint8_t>((entry >> 1) & 1u) };
+      }
+      return {};
+    }
+    
+    inline void clear_render_cache()
+    {
+      for (auto& entry : impl::render_cache)
+        entry.store(0, std::memory_order_relaxed);
+    }
+    
     inline char32_t get_renderable_char32(char32_t cp)
     {
       return can_render_single_column_cp_cached(cp) ? cp : none32;
@@ -4,6 +4,7 @@
 #include "ScreenCommandsBasic.h"
 #include "Glyph.h"
 #include "../geom/RC.h"
+#include "../sys/Profiler.h"
 #include <Core/System.h>
 #include <Core/Utf8.h>
 #include <Core/Term.h>
@@ -102,6 +103,7 @@ namespace t8
     void init_terminal_mode()
     {
       term::m_term_mode = ::term::init_terminal_mode(65001);
+      term::clear_render_cache(); // Entries cached before this are for another mode.
     }
     
 #ifdef _WIN32
@@ -212,6 +214,7 @@ namespace t8
 #ifdef _WIN32
       if (!term::use_ansi_renderer())
       {
+        ProfileScope prof_scope(ProfileZone::TermWrite);
         HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
         SHORT currentRow = 0;
         
@@ -267,20 +270,24 @@ namespace t8
       
       // ANSI-capable path (all platforms).
       std::string output;
-      output.reserve(text.size() * 8); // Rough estimate.
-      
-      for (const auto& [ch, fg_color, bg_color] : text)
       {
-        const bool is_nl = (ch == static_cast<CharT>('\n'));
-        output += ansi::colors_to_ansi_sgr_string(fg_color, is_nl ? Color16::Default : bg_color);
+        ProfileScope prof_scope(ProfileZone::Encode);
+        output.reserve(text.size() * 8); // Rough estimate.
         
-        if constexpr (std::is_same_v<CharT, char>)
-          output.push_back(static_cast<char>(ch));
-        else if constexpr (std::is_same_v<CharT, char32_t>)
-          output += utf8::encode_char32_utf8(ch);
+        for (const auto& [ch, fg_color, bg_color] : text)
+        {
+          const bool is_nl = (ch == static_cast<CharT>('\n'));
+          output += ansi::colors_to_ansi_sgr_string(fg_color, is_nl ? Color16::Default : bg_color);
+          
+          if constexpr (std::is_same_v<CharT, char>)
+            output.push_back(static_cast<char>(ch));
+          else if constexpr (std::is_same_v<CharT, char32_t>)
+            output += utf8::encode_char32_utf8(ch);
+        }
+        
+        output += "\033[0m";
       }
-      
-      output += "\033[0m";
+      ProfileScope prof_scope(ProfileZone::TermWrite);
       term::emit_text(output);
     }
 
@@ -301,6 +308,7 @@ namespace t8
 #ifdef _WIN32
       if (!term::use_ansi_renderer())
       {
+        ProfileScope prof_scope(ProfileZone::TermWrite);
         HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
         
         for (const auto& chunk : chunk_vec)
@@ -362,24 +370,28 @@ namespace t8
       
       // ANSI-capable path (all platforms).
       std::string output;
-      output.reserve(chunk_vec.size() * 32); // Rough estimate.
-      
-      for (const auto& chunk : chunk_vec)
       {
-        output += get_gotorc_str(chunk.pos.r, chunk.pos.c);
+        ProfileScope prof_scope(ProfileZone::Encode);
+        output.reserve(chunk_vec.size() * 32); // Rough estimate.
         
-        for (const auto& [ch, fg, bg] : chunk.text)
+        for (const auto& chunk : chunk_vec)
         {
-          assert(ch != '\n');
-          output += ansi::colors_to_ansi_sgr_string(fg, bg);
-          if constexpr (std::is_same_v<CharT, char>)
-            output.push_back(static_cast<char>(ch));
-          else if constexpr (std::is_same_v<CharT, char32_t>)
-            output += utf8::encode_char32_utf8(ch);
+          output += get_gotorc_str(chunk.pos.r, chunk.pos.c);
+          
+          for (const auto& [ch, fg, bg] : chunk.text)
+          {
+            assert(ch != '\n');
+            output += ansi::colors_to_ansi_sgr_string(fg, bg);
+            if constexpr (std::is_same_v<CharT, char>)
+              output.push_back(static_cast<char>(ch));
+            else if constexpr (std::is_same_v<CharT, char32_t>)
+              output += utf8::encode_char32_utf8(ch);
+          }
         }
+        
+        output += "\033[0m";
       }
-      
-      output += "\033[0m";
+      ProfileScope prof_scope(ProfileZone::TermWrite);
       term::emit_text(output);
     }
 
@@ -8,8 +8,10 @@
 #pragma once
 #include "../screen/ScreenHandler.h"
 #include "../drawing/TextureFile.h"
+#include "../drawing/AssetPack.h"
 #include "../drawing/Drawing.h"
 #include "../geom/AABB.h"
+#include "../sys/Snapshot.h"
 #include <Core/Vec2.h>
 #include <Core/bool_vector.h>
 #include <map>
@@ -58,6 +60,19 @@ namespace t8x
     virtual bool is_opaque(int sim_frame, const RC& pt) const = 0;
     
     virtual std::vector<RC> get_opaque_points(int sim_frame) const = 0;
+    
+    // Dynamic state for snapshots. The sprite data (frames etc.) is not included.
+    virtual void save_state(StateWriter& sw) const
+    {
+      sw.write(pos);
+      sw.write(layer_id);
+      sw.write(enabled);
+    }
+    
+    virtual bool load_state(StateReader& sr)
+    {
+      return sr.read(pos) && sr.read(layer_id) && sr.read(enabled);
+    }
   };
   
   // /////////////////////////////////////////////////
@@ -219,6 +234,25 @@ namespace t8x
       return true;
     }
     
+    bool load_frame(int anim_frame, const t8::AssetPack& pack, const std::string& texture_entry)
+    {
+      auto* texture = fetch_frame(anim_frame);
+      if (texture == nullptr)
+      {
+        std::cerr << "ERROR in BitmapSprite::load_frame() : Unable to load frame: " << anim_frame << "." << std::endl;
+        return false;
+      }
+      texture->clear();
+      if (!pack.load_texture(texture_entry, *texture))
+        return false;
+      if (texture->size != size)
+      {
+        std::cerr << "ERROR in BitmapSprite::load_frame() : Loaded sprite frame doesn't have the same size as the sprite itself." << std::endl;
+        return false;
+      }
+      return true;
+    }
+    
     bool save_frame(int anim_frame,
                     const std::string& file_path,
                     t8::TextureFileFormat format = t8::TextureFileFormat::Auto,
@@ -1244,6 +1278,23 @@ namespace t8x
       return math::rad2deg(rot_rad);
     }
     
+    virtual void save_state(StateWriter& sw) const override
+    {
+      Sprite::save_state(sw);
+      sw.write(rot_rad);
+      sw.write(r_scale_pre);
+      sw.write(c_scale_pre);
+      sw.write(r_scale_post);
+      sw.write(c_scale_post);
+    }
+    
+    virtual bool load_state(StateReader& sr) override
+    {
+      return Sprite::load_state(sr) && sr.read(rot_rad)
+        && sr.read(r_scale_pre) && sr.read(c_scale_pre)
+        && sr.read(r_scale_post) && sr.read(c_scale_post);
+    }
+    
     // Applied before rotation.
     void set_rc_scale_pre(float r_s, float c_s)
     {
@@ -1493,6 +1544,29 @@ namespace t8x
       return static_cast<BitmapSprite*>(m_sprites[sprite_name].get());
     }
     
+    // Creates a bitmap sprite with size, layer and all frames taken from a sprite entry of the pack.
+    // The sprite gets the name of the entry unless sprite_name is given.
+    BitmapSprite* create_bitmap_sprite(const t8::AssetPack& pack, const std::string& sprite_entry,
+                                       const std::string& sprite_name = "")
+    {
+      t8::AssetSpriteDef sprite_def;
+      if (!pack.load_sprite_def(sprite_entry, sprite_def))
+        return nullptr;
+      const auto& name = sprite_name.empty() ? sprite_entry : sprite_name;
+      auto* sprite = create_bitmap_sprite(name);
+      sprite->init(sprite_def.size.r, sprite_def.size.c);
+      sprite->layer_id = sprite_def.layer_id;
+      for (int anim_frame = 0; anim_frame < stlutils::sizeI(sprite_def.frames); ++anim_frame)
+      {
+        if (!sprite->load_frame(anim_frame, pack, sprite_def.frames[anim_frame]))
+        {
+          remove_sprite(name);
+          return nullptr;
+        }
+      }
+      return sprite;
+    }
+    
     VectorSprite* create_vector_sprite(const std::string& sprite_name)
     {
       m_sprites[sprite_name] = std::make_unique<VectorSprite>(sprite_name);
@@ -1579,9 +1653,46 @@ namespace t8x
       m_sprites.clear();
     }
     
+    // Saves the dynamic state of all sprites. Restoring requires the same set of sprites.
+    void save_state(StateWriter& sw) const
+    {
+      sw.write(static_cast<uint64_t>(m_sprites.size()));
+      for (const auto& [sprite_name, sprite] : m_sprites)
+      {
+        sw.write_string(sprite_name);
+        sprite->save_state(sw);
+      }
+    }
+    
+    bool load_state(StateReader& sr)
+    {
+      uint64_t num_sprites = 0;
+      if (!sr.read(num_sprites) || num_sprites != m_sprites.size())
+      {
+        std::cerr << "ERROR in SpriteHandler::load_state() : Number of sprites doesn't match the snapshot." << std::endl;
+        return false;
+      }
+      std::string sprite_name;
+      for (uint64_t s_idx = 0; s_idx < num_sprites; ++s_idx)
+      {
+        if (!sr.read_string(sprite_name))
+          return false;
+        auto it = m_sprites.find(sprite_name);
+        if (it == m_sprites.end())
+        {
+          std::cerr << "ERROR in SpriteHandler::load_state() : Unknown sprite \"" << sprite_name << "\" in snapshot." << std::endl;
+          return false;
+        }
+        if (!it->second->load_state(sr))
+          return false;
+      }
+      return true;
+    }
+    
     template<int NR, int NC, typename CharT>
     void draw(ScreenHandler<NR, NC, CharT>& sh, int sim_frame) const
     {
+      t8::ProfileScope prof_scope(t8::ProfileZone::SpriteDraw);
       render(sim_frame, [&sh](Sprite* sprite, int sim_frame)
       {
         if (auto* bitmap_sprite = dynamic_cast<BitmapSprite*>(sprite); bitmap_sprite != nullptr)
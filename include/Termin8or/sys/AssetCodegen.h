@@ -0,0 +1,290 @@
+//
+//  AssetCodegen.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "../drawing/TextureFile.h"
+#include "../title/ASCII_Fonts.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+
+namespace t8x
+{
+  
+  // Generates a C++ header that holds textures and fonts as constexpr tables.
+  // Textures become t8::TextureView objects over static arrays (use TextureView::to_texture()
+  //   for a mutable copy) and the fonts become EmbeddedFont tables plus a load_font_data()
+  //   function, so nothing is read from disk or parsed at startup.
+  // Normally run at build time by Tools/embed_assets.cpp through the CMake function
+  //   termin8or_embed_assets() in cmake/Termin8orEmbedAssets.cmake.
+  class AssetCodegen
+  {
+    struct TextureItem
+    {
+      std::string name;
+      t8::Texture tex;
+    };
+    std::vector<TextureItem> m_textures;
+    FontDataColl m_font_data;
+    
+    static bool is_identifier(const std::string& name)
+    {
+      if (name.empty() || str::is_digit(name[0]))
+        return false;
+      return std::all_of(name.begin(), name.end(),
+                         [](char ch) { return ch == '_' || str::is_digit(ch) || ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z'); });
+    }
+    
+    static std::string to_cpp_string_literal(const std::string& str)
+    {
+      std::ostringstream oss;
+      oss << '"';
+      for (char ch : str)
+      {
+        auto b = static_cast<unsigned char>(ch);
+        if (ch == '"' || ch == '\\')
+          oss << '\\' << ch;
+        else if (0x20 <= b && b <= 0x7E)
+          oss << ch;
+        else // Always three octal digits, so the next char can't be swallowed by the escape.
+          oss << '\\' << std::oct << std::setw(3) << std::setfill('0') << static_cast<int>(b) << std::dec;
+      }
+      oss << '"';
+      return oss.str();
+    }
+    
+    static int to_byte(char ch) { return static_cast<unsigned char>(ch); }
+    
+    static void write_array(std::ostream& os, const std::string& type, const std::string& name,
+                            const std::vector<int64_t>& values)
+    {
+      os << "  inline constexpr " << type << " " << name << "[] =\n  {";
+      if (values.empty())
+        os << "\n    0, // Zero-sized arrays aren't allowed.";
+      const int num_values = stlutils::sizeI(values);
+      for (int v_idx = 0; v_idx < num_values; ++v_idx)
+      {
+        if (v_idx % 16 == 0)
+          os << "\n    ";
+        os << values[v_idx] << ", ";
+      }
+      os << "\n  };\n";
+    }
+    
+    static void write_texture(std::ostream& os, const TextureItem& item)
+    {
+      const auto& tex = item.tex;
+      std::vector<int64_t> preferred, fallback, fg, bg, mat;
+      for (int idx = 0; idx < tex.area; ++idx)
+      {
+        preferred.emplace_back(static_cast<uint32_t>(tex.glyphs[idx].preferred));
+        fallback.emplace_back(to_byte(tex.glyphs[idx].fallback));
+        fg.emplace_back(tex.fg_colors[idx].get_index());
+        bg.emplace_back(tex.bg_colors[idx].get_index());
+        mat.emplace_back(tex.materials_raw[idx]);
+      }
+      const auto& n = item.name;
+      os << "  // Texture \"" << n << "\" (" << tex.size.r << " x " << tex.size.c << ").\n";
+      write_array(os, "uint32_t", n + "_glyphs_preferred", preferred);
+      write_array(os, "uint8_t", n + "_glyphs_fallback", fallback);
+      write_array(os, "int16_t", n + "_fg_colors", fg);
+      write_array(os, "int16_t", n + "_bg_colors", bg);
+      write_array(os, "uint8_t", n + "_materials_raw", mat);
+      os << "  inline const t8::TextureView " << n << "\n  {\n"
+         << "    " << tex.ver << ", t8::RC { " << tex.size.r << ", " << tex.size.c << " }, " << tex.area << ",\n"
+         << "    " << n << "_glyphs_preferred, " << n << "_fg_colors, " << n << "_bg_colors,\n"
+         << "    " << n << "_glyphs_fallback, " << n << "_materials_raw\n"
+         << "  };\n\n";
+    }
+    
+    static std::string get_font_name(Font font)
+    {
+      switch (font)
+      {
+        case Font::Larry3D: return "Larry3D";
+        case Font::SMSlant: return "SMSlant";
+        case Font::Avatar: return "Avatar";
+      }
+      return "";
+    }
+    
+    static void write_font(std::ostream& os, const std::string& name, const FontData& font_data)
+    {
+      std::ostringstream oss_pieces, oss_chars;
+      int num_pieces = 0;
+      int num_chars = 0;
+      auto f_add_char = [&](int ch_prev, char ch, const FontChar& font_char)
+      {
+        oss_chars << "    { " << ch_prev << ", " << to_byte(ch) << ", " << font_char.width << ", "
+                  << num_pieces << ", " << font_char.font_pieces.size() << " },\n";
+        for (const auto& piece : font_char.font_pieces)
+        {
+          oss_pieces << "    { " << to_cpp_string_literal(piece.part) << ", " << piece.r << ", " << piece.c << ", "
+                     << to_cpp_string_literal(piece.fg) << ", " << to_cpp_string_literal(piece.bg) << ", "
+                     << piece.prio << " },\n";
+          ++num_pieces;
+        }
+        ++num_chars;
+      };
+      for (const auto& [ch, font_char] : font_data.font_chars)
+        f_add_char(-1, ch, font_char);
+      for (const auto& [chars, font_char] : font_data.font_chars_by_prev_char)
+        f_add_char(to_byte(chars.first), chars.second, font_char);
+      
+      auto f_write_table = [&os, &name](const char* type, const char* suffix, int num, const std::string& rows)
+      {
+        if (num == 0)
+          return;
+        os << "  inline constexpr t8x::" << type << " " << name << suffix << "[] =\n  {\n" << rows << "  };\n";
+      };
+      f_write_table("EmbeddedFontPiece", "_pieces", num_pieces, oss_pieces.str());
+      f_write_table("EmbeddedFontChar", "_chars", num_chars, oss_chars.str());
+      
+      std::ostringstream oss_kernings;
+      for (const auto& [chars, kerning] : font_data.kernings)
+        oss_kernings << "    { " << to_byte(chars.first) << ", " << to_byte(chars.second) << ", " << kerning << " },\n";
+      f_write_table("EmbeddedFontKerning", "_kernings", stlutils::sizeI(font_data.kernings), oss_kernings.str());
+      
+      std::ostringstream oss_orderings;
+      for (const auto& [chars, prios] : font_data.orderings)
+        oss_orderings << "    { " << to_byte(chars.first) << ", " << to_byte(chars.second) << ", "
+                      << prios.first << ", " << prios.second << " },\n";
+      f_write_table("EmbeddedFontOrdering", "_orderings", stlutils::sizeI(font_data.orderings), oss_orderings.str());
+      
+      auto f_span = [&name](int num, const char* suffix) { return num == 0 ? std::string("{}") : name + suffix; };
+      os << "  inline constexpr t8x::EmbeddedFont " << name << "\n  {\n"
+         << "    " << f_span(num_chars, "_chars") << ", " << f_span(num_pieces, "_pieces") << ",\n"
+         << "    " << f_span(stlutils::sizeI(font_data.kernings), "_kernings") << ", "
+         << f_span(stlutils::sizeI(font_data.orderings), "_orderings") << ",\n"
+         << "    " << (font_data.treat_lower_case_as_upper_case ? "true" : "false") << "\n"
+         << "  };\n\n";
+    }
+  
+  public:
+    bool add_texture(const std::string& name, const t8::Texture& tex)
+    {
+      if (!is_identifier(name))
+      {
+        std::cerr << "ERROR in AssetCodegen::add_texture() : Texture name \"" << name << "\" is not a valid C++ identifier.\n";
+        return false;
+      }
+      if (stlutils::contains_if(m_textures, [&name](const auto& item) { return item.name == name; }))
+      {
+        std::cerr << "ERROR in AssetCodegen::add_texture() : Duplicate texture name \"" << name << "\".\n";
+        return false;
+      }
+      m_textures.push_back({ name, tex });
+      m_textures.back().tex.ver = tex.ver; // Not copied by Texture's copy constructor.
+      return true;
+    }
+    
+    // Any format supported by TextureFile::load().
+    bool add_texture_file(const std::string& name, const std::string& file_path, bool verbose = false)
+    {
+      t8::Texture tex;
+      if (!t8::TextureFile::load(tex, file_path, verbose))
+      {
+        std::cerr << "ERROR in AssetCodegen::add_texture_file() : Unable to load texture \"" << file_path << "\".\n";
+        return false;
+      }
+      return add_texture(name, tex);
+    }
+    
+    void add_font_data(const FontDataColl& font_data)
+    {
+      for (const auto& [font, data] : font_data)
+        m_font_data[font] = data;
+    }
+    
+    // Same folder as for t8x::load_font_data().
+    bool add_font_data_dir(const std::string& path_to_font_data)
+    {
+      auto font_data = load_font_data(path_to_font_data);
+      if (font_data.empty())
+      {
+        std::cerr << "ERROR in AssetCodegen::add_font_data_dir() : No font data found in \"" << path_to_font_data << "\".\n";
+        return false;
+      }
+      add_font_data(font_data);
+      return true;
+    }
+    
+    int num_textures() const { return stlutils::sizeI(m_textures); }
+    int num_fonts() const { return stlutils::sizeI(m_font_data); }
+    
+    void write(std::ostream& os, const std::string& ns = "t8_assets") const
+    {
+      os << "// Generated by Termin8or AssetCodegen. Do not edit.\n\n"
+         << "#pragma once\n"
+         << "#include <Termin8or/drawing/texture_file/TextureFileBin.h>\n";
+      if (!m_font_data.empty())
+        os << "#include <Termin8or/title/ASCII_Fonts.h>\n";
+      os << "#include <cstdint>\n\n\n"
+         << "namespace " << ns << "\n{\n\n";
+      
+      for (const auto& item : m_textures)
+        write_texture(os, item);
+      
+      if (!m_font_data.empty())
+      {
+        for (const auto& [font, font_data] : m_font_data)
+          write_font(os, "font_" + str::to_lower(get_font_name(font)), font_data);
+        
+        os << "  // Drop-in replacement for t8x::load_font_data(path_to_font_data).\n"
+           << "  inline t8x::FontDataColl load_font_data()\n  {\n"
+           << "    t8x::FontDataColl font_data;\n";
+        for (const auto& [font, font_data] : m_font_data)
+        {
+          const auto font_name = get_font_name(font);
+          os << "    font_data[t8x::Font::" << font_name << "] = t8x::make_font_data(font_"
+             << str::to_lower(font_name) << ");\n";
+        }
+        os << "    return font_data;\n  }\n\n";
+      }
+      
+      os << "}\n";
+    }
+    
+    // Leaves an up-to-date header untouched so that its dependents aren't rebuilt.
+    bool write(const std::string& header_path, const std::string& ns = "t8_assets") const
+    {
+      if (!is_identifier(ns))
+      {
+        std::cerr << "ERROR in AssetCodegen::write() : Namespace \"" << ns << "\" is not a valid C++ identifier.\n";
+        return false;
+      }
+      
+      std::ostringstream oss;
+      write(oss, ns);
+      const auto code = oss.str();
+      
+      {
+        std::ifstream fin(header_path, std::ios::binary);
+        if (fin.is_open())
+        {
+          std::string old_code((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+          if (old_code == code)
+            return true;
+        }
+      }
+      
+      std::ofstream fout(header_path, std::ios::binary);
+      if (!fout.is_open())
+      {
+        std::cerr << "ERROR in AssetCodegen::write() : Unable to open \"" << header_path << "\" for writing.\n";
+        return false;
+      }
+      fout << code;
+      return fout.good();
+    }
+  };
+
+}
@@ -0,0 +1,198 @@
+//
+//  AssetLoader.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include "../drawing/TextureFile.h"
+#include "../title/ASCII_Fonts.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <queue>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <memory>
+#include <chrono>
+
+
+namespace t8x
+{
+  
+  // Parses assets on a pool of worker threads.
+  // Each load returns a std::shared_future that holds std::nullopt if the load failed.
+  // Jobs with higher priority are started first (e.g. title screen assets), jobs with the same
+  //   priority are started in submission order.
+  // The results must be moved into sprites etc. on the main thread, e.g. via
+  //   BitmapSprite::set_frame(), once is_ready() returns true.
+  class AsyncAssetLoader
+  {
+    struct Job
+    {
+      int priority = 0;
+      uint64_t seq = 0;
+      std::function<void()> work;
+    };
+    struct JobCompare
+    {
+      bool operator()(const Job& jA, const Job& jB) const
+      {
+        if (jA.priority != jB.priority)
+          return jA.priority < jB.priority;
+        return jA.seq > jB.seq;
+      }
+    };
+    
+    std::priority_queue<Job, std::vector<Job>, JobCompare> m_queue;
+    std::vector<std::thread> m_workers;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv_job;
+    std::condition_variable m_cv_idle;
+    bool m_stop = false;
+    uint64_t m_seq = 0;
+    int m_num_running = 0;
+    
+    std::atomic<int> m_num_submitted = 0;
+    std::atomic<int> m_num_finished = 0;
+    std::atomic<int> m_num_failed = 0;
+    
+    void worker_loop()
+    {
+      while (true)
+      {
+        Job job;
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_cv_job.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+          if (m_stop)
+            return;
+          job = m_queue.top();
+          m_queue.pop();
+          m_num_running++;
+        }
+        job.work();
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_num_running--;
+        }
+        m_cv_idle.notify_all();
+      }
+    }
+  
+  public:
+    // num_workers = 0 : one less than the number of hardware threads (at least one).
+    AsyncAssetLoader(int num_workers = 0)
+    {
+      if (num_workers <= 0)
+        num_workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+      for (int w_idx = 0; w_idx < num_workers; ++w_idx)
+        m_workers.emplace_back(&AsyncAssetLoader::worker_loop, this);
+    }
+    
+    // Jobs that haven't started yet are dropped. Their futures will throw std::future_error (broken promise).
+    ~AsyncAssetLoader()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        while (!m_queue.empty())
+          m_queue.pop();
+      }
+      m_cv_job.notify_all();
+      for (auto& worker : m_workers)
+        if (worker.joinable())
+          worker.join();
+    }
+    
+    AsyncAssetLoader(const AsyncAssetLoader&) = delete;
+    AsyncAssetLoader& operator=(const AsyncAssetLoader&) = delete;
+    
+    template<typename T>
+    std::shared_future<std::optional<T>> submit(std::function<std::optional<T>()> load_func, int priority = 0)
+    {
+      auto promise = std::make_shared<std::promise<std::optional<T>>>();
+      auto future = promise->get_future().share();
+      m_num_submitted++;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push({ priority, m_seq++, [this, promise, load_func]()
+        {
+          std::optional<T> result;
+          try
+          {
+            result = load_func();
+          }
+          catch (const std::exception& e)
+          {
+            std::cerr << "ERROR in AsyncAssetLoader : " << e.what() << '\n';
+          }
+          catch (...)
+          {
+            std::cerr << "ERROR in AsyncAssetLoader : Unknown exception.\n";
+          }
+          if (!result.has_value())
+            m_num_failed++;
+          m_num_finished++;
+          promise->set_value(std::move(result));
+        } });
+      }
+      m_cv_job.notify_one();
+      return future;
+    }
+    
+    std::shared_future<std::optional<t8::Texture>> load_texture(const std::string& file_path, int priority = 0,
+                                                                t8::TextureFileFormat format = t8::TextureFileFormat::Auto)
+    {
+      return submit<t8::Texture>([file_path, format]() -> std::optional<t8::Texture>
+      {
+        t8::Texture tex;
+        if (!t8::TextureFile::load(tex, file_path, format, false))
+          return std::nullopt;
+        return tex;
+      }, priority);
+    }
+    
+    std::shared_future<std::optional<FontDataColl>> load_font_data(const std::string& path_to_font_data, int priority = 0)
+    {
+      return submit<FontDataColl>([path_to_font_data]() -> std::optional<FontDataColl>
+      {
+        auto font_data = t8x::load_font_data(path_to_font_data);
+        if (font_data.empty())
+          return std::nullopt;
+        return font_data;
+      }, priority);
+    }
+    
+    template<typename T>
+    static bool is_ready(const std::shared_future<T>& future)
+    {
+      return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+    
+    int num_workers() const { return static_cast<int>(m_workers.size()); }
+    int num_submitted() const { return m_num_submitted; }
+    int num_finished() const { return m_num_finished; }
+    int num_failed() const { return m_num_failed; }
+    int num_pending() const { return m_num_submitted - m_num_finished; }
+    bool is_done() const { return num_pending() == 0; }
+    
+    // Fraction of the submitted jobs that have finished, in [0, 1].
+    float get_progress() const
+    {
+      int num_sub = m_num_submitted;
+      return num_sub == 0 ? 1.f : static_cast<float>(m_num_finished) / num_sub;
+    }
+    
+    // Blocks until all submitted jobs have finished.
+    void wait_all()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv_idle.wait(lock, [this] { return m_queue.empty() && m_num_running == 0; });
+    }
+  };
+
+}
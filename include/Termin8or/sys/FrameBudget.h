@@ -0,0 +1,224 @@
+//
+//  FrameBudget.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+
+namespace t8x
+{
+  
+  struct FrameBudgetParams
+  {
+    float budget_ms = 0.f; // 0 : 1000 / real_fps (see GameEngine).
+    // Degrade one step after this many consecutive frames over budget.
+    int degrade_after_frames = 3;
+    // Restore one step after this many consecutive frames where the smoothed frame time is
+    //   below restore_below_ratio of the budget.
+    int restore_after_frames = 60;
+    float restore_below_ratio = 0.7f;
+    // Frames to wait after an adjustment before degrading again, so that it has time to take effect.
+    int cooldown_frames = 10;
+    float smoothing = 0.2f; // Weight of the latest frame time in the smoothed frame time.
+  };
+  
+  struct BudgetAdjustment
+  {
+    int frame = 0;
+    int knob_idx = -1;
+    std::string knob_name;
+    int prev_level = 0;
+    int level = 0;
+    float frame_ms = 0.f; // Smoothed frame time at the adjustment.
+    float budget_ms = 0.f;
+  };
+  
+  // Keeps the frame time within a budget by trading quality for time.
+  // Quality knobs (e.g. particle counts, CCD steps or the redraw policy) are registered with
+  //   a priority and a number of levels, where level 0 is full quality. When frames run over
+  //   budget, the knob with the lowest priority that isn't already at its lowest quality is
+  //   degraded one level. When there is headroom again, the knobs are restored one level at
+  //   a time in the opposite order.
+  class FrameBudgetGovernor
+  {
+    struct Knob
+    {
+      std::string name;
+      int num_levels = 2;
+      int priority = 0;
+      int level = 0;
+      std::function<void(int)> apply;
+    };
+    std::vector<Knob> m_knobs;
+    std::vector<int> m_knob_order; // Knob indices by ascending priority.
+    FrameBudgetParams m_params;
+    float m_budget_ms = 0.f;
+    float m_smoothed_ms = 0.f;
+    int m_num_over = 0;
+    int m_num_under = 0;
+    int m_cooldown = 0;
+    int m_num_degrades = 0;
+    int m_num_restores = 0;
+    std::deque<BudgetAdjustment> m_history;
+    static constexpr size_t c_max_history = 64;
+    std::function<void(const BudgetAdjustment&)> m_on_adjust;
+    
+    void change_level(int knob_idx, int level, int frame)
+    {
+      auto& knob = m_knobs[knob_idx];
+      BudgetAdjustment adj { frame, knob_idx, knob.name, knob.level, level, m_smoothed_ms, m_budget_ms };
+      knob.level = level;
+      knob.apply(level);
+      if (m_history.size() == c_max_history)
+        m_history.pop_front();
+      m_history.emplace_back(adj);
+      if (m_on_adjust)
+        m_on_adjust(adj);
+    }
+    
+    bool degrade(int frame)
+    {
+      for (int knob_idx : m_knob_order)
+      {
+        const auto& knob = m_knobs[knob_idx];
+        if (knob.level + 1 < knob.num_levels)
+        {
+          change_level(knob_idx, knob.level + 1, frame);
+          m_num_degrades++;
+          return true;
+        }
+      }
+      return false;
+    }
+    
+    bool restore(int frame)
+    {
+      for (auto it = m_knob_order.rbegin(); it != m_knob_order.rend(); ++it)
+      {
+        if (m_knobs[*it].level > 0)
+        {
+          change_level(*it, m_knobs[*it].level - 1, frame);
+          m_num_restores++;
+          return true;
+        }
+      }
+      return false;
+    }
+  
+  public:
+    FrameBudgetGovernor(const FrameBudgetParams& params = {})
+      : m_params(params)
+      , m_budget_ms(params.budget_ms)
+    {}
+    
+    void set_params(const FrameBudgetParams& params)
+    {
+      m_params = params;
+      m_budget_ms = params.budget_ms;
+    }
+    const FrameBudgetParams& get_params() const { return m_params; }
+    
+    void set_budget_ms(float budget_ms) { m_budget_ms = budget_ms; }
+    float get_budget_ms() const { return m_budget_ms; }
+    
+    // apply(level) is called on every change of the level, with level in [0, num_levels).
+    //   Knobs with equal priority are degraded in the order they were added.
+    //   Returns the index of the knob.
+    int add_knob(const std::string& name, int num_levels, std::function<void(int)> apply, int priority = 0)
+    {
+      if (num_levels < 2 || !apply)
+      {
+        std::cerr << "ERROR in FrameBudgetGovernor::add_knob() : Knob \"" << name << "\" needs at least two levels and an apply function." << std::endl;
+        return -1;
+      }
+      const int knob_idx = static_cast<int>(m_knobs.size());
+      m_knobs.push_back({ name, num_levels, priority, 0, std::move(apply) });
+      m_knob_order.emplace_back(knob_idx);
+      std::stable_sort(m_knob_order.begin(), m_knob_order.end(),
+                       [this](int kA, int kB) { return m_knobs[kA].priority < m_knobs[kB].priority; });
+      return knob_idx;
+    }
+    
+    void set_adjustment_callback(std::function<void(const BudgetAdjustment&)> on_adjust)
+    {
+      m_on_adjust = std::move(on_adjust);
+    }
+    
+    // Call once per frame with the time spent on the frame (excluding the wait for the next frame).
+    //   Returns true if a knob was adjusted.
+    bool report_frame_time_ms(float frame_ms, int frame)
+    {
+      if (m_budget_ms <= 0.f)
+        return false;
+      m_smoothed_ms = m_smoothed_ms <= 0.f ? frame_ms : m_smoothed_ms + (frame_ms - m_smoothed_ms) * m_params.smoothing;
+      
+      if (frame_ms > m_budget_ms)
+      {
+        m_num_over++;
+        m_num_under = 0;
+      }
+      else if (m_smoothed_ms < m_params.restore_below_ratio * m_budget_ms)
+      {
+        m_num_under++;
+        m_num_over = 0;
+      }
+      else
+        m_num_over = m_num_under = 0;
+      
+      if (m_cooldown > 0)
+      {
+        m_cooldown--;
+        return false;
+      }
+      if (m_num_over >= m_params.degrade_after_frames)
+      {
+        m_num_over = 0;
+        if (degrade(frame))
+        {
+          m_cooldown = m_params.cooldown_frames;
+          return true;
+        }
+      }
+      else if (m_num_under >= m_params.restore_after_frames)
+      {
+        m_num_under = 0;
+        if (restore(frame))
+        {
+          m_cooldown = m_params.cooldown_frames;
+          return true;
+        }
+      }
+      return false;
+    }
+    
+    // Restores all knobs to full quality.
+    void reset(int frame = 0)
+    {
+      for (int knob_idx = 0; knob_idx < static_cast<int>(m_knobs.size()); ++knob_idx)
+        if (m_knobs[knob_idx].level > 0)
+          change_level(knob_idx, 0, frame);
+      m_smoothed_ms = 0.f;
+      m_num_over = m_num_under = m_cooldown = 0;
+    }
+    
+    int num_knobs() const { return static_cast<int>(m_knobs.size()); }
+    int get_level(int knob_idx) const { return m_knobs[knob_idx].level; }
+    const std::string& get_knob_name(int knob_idx) const { return m_knobs[knob_idx].name; }
+    
+    float get_smoothed_frame_ms() const { return m_smoothed_ms; }
+    int num_degrades() const { return m_num_degrades; }
+    int num_restores() const { return m_num_restores; }
+    // The latest adjustments, oldest first.
+    const std::deque<BudgetAdjustment>& get_history() const { return m_history; }
+  };
+
+}
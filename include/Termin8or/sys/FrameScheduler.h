@@ -0,0 +1,203 @@
+//
+//  FrameScheduler.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#if defined(__linux__)
+#include <time.h>
+#include <cerrno>
+#endif
+
+
+namespace t8x
+{
+  
+  struct FrameSchedulerParams
+  {
+    // Sleeps until spin_margin before the deadline and busy-waits the rest of the way, since
+    //   the OS may wake a sleeping thread a few ms late.
+    std::chrono::microseconds spin_margin { 2000 };
+    // Learns the actual oversleep of the OS and shrinks or grows spin_margin to match it.
+    bool adaptive_spin_margin = true;
+    // Linux : Sleeps with clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME), which doesn't
+    //   accumulate the rounding of relative sleeps.
+    bool use_abs_time_sleep = true;
+    // If a frame overruns by more than this many frame periods, the schedule restarts from now
+    //   instead of rushing through the missed frames.
+    int max_frames_behind = 2;
+    // Number of frames the jitter statistics are based on.
+    int num_stats_frames = 600;
+  };
+  
+  struct FrameJitterStats
+  {
+    // Wake-up time relative to the deadline of the frame, in microseconds.
+    float avg_us = 0.f;
+    float p50_us = 0.f;
+    float p99_us = 0.f;
+    float max_us = 0.f;
+    int num_frames = 0;
+    int num_overruns = 0; // Frames whose work alone took longer than the frame period.
+    int num_resyncs = 0; // Times the schedule was restarted, see FrameSchedulerParams::max_frames_behind.
+  };
+  
+  // Paces a loop at a fixed rate against absolute deadlines on std::chrono::steady_clock.
+  // The next deadline is the previous deadline plus one period, so a late frame doesn't push
+  //   the following frames back (no drift). Waiting is a sleep followed by a short spin.
+  class FrameScheduler
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+  
+  private:
+    FrameSchedulerParams m_params;
+    Clock::duration m_period = std::chrono::milliseconds(100);
+    Clock::time_point m_deadline;
+    Clock::duration m_spin_margin;
+    Clock::duration m_oversleep {};
+    bool m_started = false;
+    
+    std::vector<float> m_lateness_us; // Ring buffer.
+    int m_num_samples = 0;
+    int m_num_overruns = 0;
+    int m_num_resyncs = 0;
+    
+    void sleep_until(Clock::time_point t)
+    {
+#if defined(__linux__)
+      // libstdc++ and libc++ both implement steady_clock with CLOCK_MONOTONIC.
+      if (m_params.use_abs_time_sleep)
+      {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+        ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {}
+        return;
+      }
+#endif
+      std::this_thread::sleep_until(t);
+    }
+    
+    void add_sample(Clock::duration lateness)
+    {
+      const int capacity = std::max(1, m_params.num_stats_frames);
+      if (static_cast<int>(m_lateness_us.size()) < capacity)
+        m_lateness_us.emplace_back(0.f);
+      m_lateness_us[m_num_samples % static_cast<int>(m_lateness_us.size())] =
+        std::chrono::duration<float, std::micro>(lateness).count();
+      m_num_samples++;
+    }
+  
+  public:
+    FrameScheduler(const FrameSchedulerParams& params = {})
+      : m_params(params)
+      , m_spin_margin(params.spin_margin)
+    {}
+    
+    void set_params(const FrameSchedulerParams& params)
+    {
+      m_params = params;
+      m_spin_margin = params.spin_margin;
+    }
+    
+    // May be called every frame, e.g. when GameEngine::set_real_fps() has changed the rate.
+    void set_fps(float fps)
+    {
+      m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(fps, 1e-3f)));
+    }
+    
+    // The first frame is due one period from now.
+    void start(float fps)
+    {
+      set_fps(fps);
+      m_deadline = Clock::now() + m_period;
+      m_started = true;
+    }
+    
+    // Call after the work of a frame. Blocks until the deadline of the frame and then moves
+    //   the deadline one period ahead.
+    void wait_for_next_frame()
+    {
+      if (!m_started)
+        start(static_cast<float>(1.0 / std::chrono::duration<double>(m_period).count()));
+      
+      auto now = Clock::now();
+      if (now > m_deadline)
+        m_num_overruns++;
+      else
+      {
+        const auto sleep_target = m_deadline - m_spin_margin;
+        if (now < sleep_target)
+        {
+          sleep_until(sleep_target);
+          now = Clock::now();
+          if (m_params.adaptive_spin_margin)
+          {
+            // Tracks the worst recent oversleep, decaying slowly, and keeps some slack on top of it.
+            const auto oversleep = std::max<Clock::duration>(now - sleep_target, Clock::duration::zero());
+            m_oversleep = std::max(oversleep, m_oversleep - m_oversleep / 64);
+            m_spin_margin = std::clamp<Clock::duration>(m_oversleep + m_oversleep / 2,
+                                                        std::chrono::microseconds(100),
+                                                        std::chrono::microseconds(4000));
+          }
+        }
+        while (now < m_deadline)
+        {
+          std::this_thread::yield();
+          now = Clock::now();
+        }
+      }
+      add_sample(now - m_deadline);
+      
+      m_deadline += m_period;
+      if (now - m_deadline > m_period * m_params.max_frames_behind)
+      {
+        m_deadline = now + m_period;
+        m_num_resyncs++;
+      }
+    }
+    
+    // Runs update_func once per frame until it returns false.
+    template<typename Func>
+    void run_loop(float fps, Func update_func)
+    {
+      start(fps);
+      while (update_func())
+        wait_for_next_frame();
+    }
+    
+    Clock::time_point get_next_deadline() const { return m_deadline; }
+    Clock::duration get_spin_margin() const { return m_spin_margin; }
+    
+    FrameJitterStats get_jitter_stats() const
+    {
+      FrameJitterStats stats;
+      stats.num_frames = std::min(m_num_samples, static_cast<int>(m_lateness_us.size()));
+      stats.num_overruns = m_num_overruns;
+      stats.num_resyncs = m_num_resyncs;
+      if (stats.num_frames == 0)
+        return stats;
+      auto samples = m_lateness_us;
+      samples.resize(stats.num_frames);
+      std::sort(samples.begin(), samples.end());
+      float sum = 0.f;
+      for (auto us : samples)
+        sum += us;
+      stats.avg_us = sum / static_cast<float>(stats.num_frames);
+      stats.p50_us = samples[(stats.num_frames - 1) / 2];
+      stats.p99_us = samples[std::min(stats.num_frames - 1, (stats.num_frames * 99) / 100)];
+      stats.max_us = samples.back();
+      return stats;
+    }
+  };
+
+}
@@ -7,6 +7,12 @@
 
 #pragma once
 #include "Logging.h"
+#include "RandStream.h"
+#include "Snapshot.h"
+#include "Profiler.h"
+#include "FrameBudget.h"
+#include "FrameScheduler.h"
+#include "AssetLoader.h"
 #include "../input/Keyboard.h"
 #include "../screen/ScreenCommands.h"
 #include "../screen/ScreenUtils.h"
@@ -76,12 +82,49 @@ namespace t8x
     
     LogMode log_mode = LogMode::None;
     std::string log_filename = "rec.txt";
+    LogFormat log_format = LogFormat::Text; // Used for recording, replay detects the format.
+    // With LogMode::Replay : Runs the replay headless (no keyboard, no terminal output) and as fast
+    //   as possible instead of at real_fps, e.g. for regression runs. get_real_time_s() then
+    //   advances by 1 / real_fps per frame.
+    bool replay_fast_forward = false;
+    // With LogMode::Replay : Fast-forwards (without output) to this frame before the replay is shown.
+    int replay_start_frame = 0;
+    
+    // Takes a snapshot (see GameEngine::save_state()) every snapshot_interval_frames frames into a
+    //   ring of snapshot_capacity snapshots. 0 : Off.
+    // The interval doesn't affect the game, so record and replay may use different intervals.
+    int snapshot_interval_frames = 0;
+    int snapshot_capacity = 64;
     
     bool suppress_tty_output = false;
     bool suppress_tty_input = false;
+    bool enable_input_thread = false; // Reads the keyboard on a separate thread, see t8::InputReader.
+    bool enable_kitty_keyboard = false; // Exact held keys on terminals with key release events, see t8::KeyStateTracker.
+    t8::KeyHoldTiming key_hold_timing;
     
     bool enable_benchmark = false;
+    // Times the engine phases of each frame (see t8::Profiler). The statistics are shown as an
+    //   overlay if show_profiler_overlay is set and the frames are written as a Chrome trace
+    //   on exit if profiler_trace_path is set.
+    bool enable_profiler = false;
+    int profiler_num_frames = 300;
+    bool show_profiler_overlay = false;
+    t8::Style profiler_overlay_style { t8::Color16::White, t8::Color16::DarkBlue };
+    std::string profiler_trace_path;
     t8::DrawPolicy draw_policy = t8::DrawPolicy::MEASURE_SELECT;
+    
+    // Lowers the quality when frames take longer than the frame budget and raises it again when
+    //   there is headroom, see FrameBudgetGovernor. The engine registers the redraw policy and the
+    //   animation rate, games add e.g. add_particle_budget_knob() and add_ccd_budget_knob().
+    //   Knobs that affect the simulation are only used with LogMode::None, since recordings
+    //   must replay identically. Not used in headless replays.
+    bool enable_frame_budget = false;
+    FrameBudgetParams frame_budget_params;
+    
+    // Paces the frames against absolute deadlines with a sleep-then-spin wait (see FrameScheduler)
+    //   instead of Delay::update_loop(). Gives less jitter at the cost of a short busy-wait per frame.
+    bool enable_frame_scheduler = false;
+    FrameSchedulerParams frame_scheduler_params;
     t8::AsciiFallbackPolicy ascii_fallback_policy = t8::AsciiFallbackPolicy::SYSTEM_CONTROLLED;
   };
   
@@ -109,6 +152,8 @@ namespace t8x
     
     unsigned int curr_rnd_seed = 0;
     
+    std::unique_ptr<AsyncAssetLoader> asset_loader;
+    
     // Simulation delay.
     int sim_delay = 50'000; // 100'000 (10 FPS) // 60'000 (16.67 FPS);
     // Real-time FPS.
@@ -144,6 +189,16 @@ namespace t8x
     
     OneShot trg_update_halted, trg_update_resumed;
     
+    FrameBudgetGovernor budget_governor;
+    t8::DrawPolicy curr_draw_policy = t8::DrawPolicy::MEASURE_SELECT;
+    int anim_rate_divisor = 1;
+    
+    FrameScheduler frame_scheduler;
+    
+    SnapshotRing snapshots;
+    int seek_target_frame = -1;
+    bool fast_forwarding = false;
+    
     bool handle_hiscores(const HiScoreItem& curr_hsi)
     {
       const int c_max_num_hiscores = 20;
@@ -208,6 +263,7 @@ namespace t8x
     
     t8::KeyPressDataPair kpdp;
     std::unique_ptr<t8::StreamKeyboard> keyboard;
+    t8x::FrameInput frame_input; // Held keys and events of the frame, logged and replayed with kpdp.
     
     bool exit_requested = false;
     int requested_exit_code = EXIT_SUCCESS;
@@ -216,9 +272,34 @@ namespace t8x
     void set_curr_rnd_seed(unsigned int new_seed)
     {
       curr_rnd_seed = new_seed;
+      t8::session_rand_seed = curr_rnd_seed;
       rnd::srand(curr_rnd_seed);
     }
     
+    // Stream keyed by (current seed, system, entity, current frame).
+    // Unlike the global rnd state, the values don't depend on what other systems have drawn,
+    //   so they are reproduced on replay regardless of update order.
+    t8::RandStream get_rand_stream(t8::RandSystem system, uint32_t entity = 0) const
+    {
+      return { curr_rnd_seed, system, entity, static_cast<uint32_t>(frame_ctr) };
+    }
+    
+    // All key, mouse and paste events of the current frame, oldest first.
+    //   kpdp.transient is the first key press among them. Recorded and replayed like kpdp.
+    const std::vector<t8::KeyEvent>& get_key_events() const { return frame_input.events; }
+    
+    // Frame rate independent held key state, e.g. for movement. Recorded and replayed like kpdp.
+    bool is_key_down(char ch) const
+    {
+      const int idx = t8::KeyStateTracker::key_index(ch);
+      return idx >= 0 && frame_input.held_keys.test(idx);
+    }
+    bool is_key_down(t8::SpecialKey key) const
+    {
+      const int idx = t8::KeyStateTracker::key_index(key);
+      return idx >= 0 && frame_input.held_keys.test(idx);
+    }
+    
     int& ref_score() { return score; }
     
     double get_real_time_s() const { return real_time_s; }
@@ -270,6 +351,10 @@ namespace t8x
     
     // Callbacks
     virtual void update() = 0;
+    // Opt-in snapshot hooks for the game state, e.g. a DynamicsSystem, a SpriteHandler and
+    //   ParticleHandlers. Must read back exactly what was written.
+    virtual void on_save_state(StateWriter& /*sw*/) const {}
+    virtual bool on_load_state(StateReader& /*sr*/) { return true; }
     virtual void draw_title() {}
     virtual void draw_instructions() {}
     virtual void on_quit() {}
@@ -288,6 +373,7 @@ namespace t8x
     virtual void on_enter_hiscores() {}
     virtual void on_enter_paused() {}
     virtual void on_exit_paused() {}
+    virtual void on_budget_adjustment(const BudgetAdjustment& /*adj*/) {}
     
   public:
     GameEngine(std::string_view exe_full_path,
@@ -295,6 +381,10 @@ namespace t8x
       : path_to_exe(exe_full_path)
       , m_params(params)
       , anim_ctr_data(1)
+      , budget_governor(params.frame_budget_params)
+      , curr_draw_policy(params.draw_policy)
+      , frame_scheduler(params.frame_scheduler_params)
+      , snapshots(params.snapshot_capacity)
     {
       std::tie(exe_path, exe_file) = folder::split_file_path(std::string(path_to_exe));
       show_title = params.enable_title_screen;
@@ -317,10 +407,30 @@ namespace t8x
       if (!exit_requested)
       {
         // RT-Loop
-        t8::clear_screen();
+        if (!is_headless())
+          t8::clear_screen();
         on_enter_game_loop();
-        auto update_func = std::bind(&GameEngine::engine_update, this);
-        Delay::update_loop(real_fps, update_func);
+        if (is_headless())
+        {
+          while (engine_update())
+          {}
+        }
+        else if (m_params.enable_frame_scheduler)
+        {
+          // Reads real_fps every frame, so set_real_fps() takes effect right away.
+          frame_scheduler.run_loop(real_fps, [this]()
+          {
+            if (!engine_update())
+              return false;
+            frame_scheduler.set_fps(real_fps);
+            return true;
+          });
+        }
+        else
+        {
+          auto update_func = std::bind(&GameEngine::engine_update, this);
+          Delay::update_loop(real_fps, update_func);
+        }
         on_exit_game_loop();
       }
       
@@ -331,8 +441,6 @@ namespace t8x
     float get_real_fps() const { return real_fps; }
     void set_real_fps(float fps_val)
     {
-      if (keyboard != nullptr)
-        keyboard->set_held_buffer_size_from_fps(fps_val);
       anim_ctr_data[0].anim_count_per_frame_count = math::roundI(fps_val / 5);
       real_fps = fps_val;
     }
@@ -353,9 +461,127 @@ namespace t8x
       requested_exit_code = exit_code;
     }
     
+    // Background loader (created on first use) so that generate_data() can submit
+    //   assets and return while e.g. the title screen is displayed.
+    AsyncAssetLoader& get_asset_loader()
+    {
+      if (asset_loader == nullptr)
+        asset_loader = std::make_unique<AsyncAssetLoader>();
+      return *asset_loader;
+    }
+    float get_asset_load_progress() const
+    {
+      return asset_loader == nullptr ? 1.f : asset_loader->get_progress();
+    }
+    
     void set_screen_bg_color_default(Color bg_color) { m_params.screen_bg_color_default = bg_color; }
     void set_screen_empty_fg_color(Color fg_color) { m_params.empty_fg_color = fg_color; }
     
+    bool is_headless() const
+    {
+      return m_params.log_mode == LogMode::Replay && m_params.replay_fast_forward;
+    }
+    
+    // Engine counters and state flags, followed by on_save_state().
+    void save_state(StateWriter& sw) const
+    {
+      sw.write(frame_ctr);
+      sw.write(frame_ctr_measure);
+      sw.write(sim_time_s);
+      sw.write_vector(anim_ctr_data);
+      sw.write(curr_rnd_seed);
+      sw.write(score);
+      sw.write(paused);
+      sw.write(show_title);
+      sw.write(show_instructions);
+      sw.write(show_quit_confirm);
+      sw.write(show_game_over);
+      sw.write(show_you_won);
+      sw.write(show_input_hiscore);
+      sw.write(show_hiscores);
+      sw.write(quit_confirm_button);
+      sw.write(game_over_timer);
+      sw.write(you_won_timer);
+      sw.write(timestamp_game_over);
+      sw.write(timestamp_you_won);
+      on_save_state(sw);
+    }
+    
+    bool load_state(StateReader& sr)
+    {
+      sr.read(frame_ctr);
+      sr.read(frame_ctr_measure);
+      sr.read(sim_time_s);
+      sr.read_vector(anim_ctr_data);
+      sr.read(curr_rnd_seed);
+      t8::session_rand_seed = curr_rnd_seed;
+      sr.read(score);
+      sr.read(paused);
+      sr.read(show_title);
+      sr.read(show_instructions);
+      sr.read(show_quit_confirm);
+      sr.read(show_game_over);
+      sr.read(show_you_won);
+      sr.read(show_input_hiscore);
+      sr.read(show_hiscores);
+      sr.read(quit_confirm_button);
+      sr.read(game_over_timer);
+      sr.read(you_won_timer);
+      sr.read(timestamp_game_over);
+      sr.read(timestamp_you_won);
+      if (!sr.ok() || !on_load_state(sr))
+      {
+        std::cerr << "ERROR in GameEngine::load_state() : Unable to restore the snapshot." << std::endl;
+        return false;
+      }
+      return true;
+    }
+    
+    const SnapshotRing& get_snapshots() const { return snapshots; }
+    
+    // Degradable quality for GameEngineParams::enable_frame_budget. Lower priorities are
+    //   degraded first. Returns the knob index, or -1 if the knob affects the simulation
+    //   and the game is being recorded or replayed (the knob is then not used).
+    int add_budget_knob(const std::string& name, int num_levels, std::function<void(int)> apply, int priority = 0,
+                        bool affects_simulation = true)
+    {
+      if (affects_simulation && m_params.log_mode != LogMode::None)
+        return -1;
+      return budget_governor.add_knob(name, num_levels, std::move(apply), priority);
+    }
+    
+    // Particle count of a ParticleHandler or ParticleHandlerSoA : 100 %, 75 %, 50 % and 25 %.
+    template<typename ParticleHandlerT>
+    int add_particle_budget_knob(ParticleHandlerT& particle_handler, int priority = 0)
+    {
+      return add_budget_knob("particles", 4, [&particle_handler](int level)
+      {
+        particle_handler.set_num_active_particles(1.f - 0.25f * static_cast<float>(level));
+      }, priority);
+    }
+    
+    // Number of CCD sub-steps of a CollisionHandler, by doubling its max step length per level.
+    template<typename CollisionHandlerT>
+    int add_ccd_budget_knob(CollisionHandlerT& coll_handler, float ccd_max_step_len = 0.5f, int priority = 10)
+    {
+      return add_budget_knob("ccd_steps", 3, [&coll_handler, ccd_max_step_len](int level)
+      {
+        coll_handler.set_ccd_max_step_len(ccd_max_step_len * static_cast<float>(1 << level));
+      }, priority);
+    }
+    
+    const FrameBudgetGovernor& get_budget_governor() const { return budget_governor; }
+    
+    // Wake-up jitter of the frames, see GameEngineParams::enable_frame_scheduler.
+    FrameJitterStats get_frame_jitter_stats() const { return frame_scheduler.get_jitter_stats(); }
+    
+    // Replay only : Jumps to frame at the start of the next frame. Backwards by restoring the
+    //   closest snapshot before it, then (and forwards) by simulating without output.
+    void request_seek_to_frame(int frame)
+    {
+      seek_target_frame = std::max(0, frame);
+    }
+    
   private:
     void finish()
     {
@@ -363,8 +589,20 @@ namespace t8x
       if (m_params.enable_benchmark && initialized_benchmark)
         dur_s = 1e-3f * benchmark::toc(tictoc_game_engine);
         
+      t8x::finish_logging(m_params.log_mode);
+      
+      if (m_params.enable_profiler)
+      {
+        t8::profiler.end_frame();
+        if (!m_params.profiler_trace_path.empty())
+          t8::profiler.write_chrome_trace(m_params.profiler_trace_path);
+        t8::profiler.set_enabled(false);
+      }
+      
       if (initialized_keyboard)
         keyboard.reset();
+      
+      asset_loader.reset();
 
       if (initialized_screen)
         t8::end_screen(sh);
@@ -390,22 +628,31 @@ namespace t8x
       if (exit_requested)
         return;
       
-      if (!m_params.suppress_tty_input)
+      if (!m_params.suppress_tty_input && !is_headless())
       {
-        keyboard = std::make_unique<t8::StreamKeyboard>();
+        keyboard = std::make_unique<t8::StreamKeyboard>(m_params.key_hold_timing);
         if (!keyboard->is_raw_mode_enabled())
         {
           request_exit(EXIT_FAILURE);
           return;
         }
-        keyboard->set_held_buffer_size_from_fps(real_fps);
+        if (m_params.enable_kitty_keyboard)
+          keyboard->enable_kitty_keyboard(true);
+        if (m_params.enable_input_thread && !keyboard->start_input_thread())
+        {
+          request_exit(EXIT_FAILURE);
+          return;
+        }
         initialized_keyboard = true;
       }
       
-      t8::begin_screen(sh);
-      initialized_screen = true;
+      if (!is_headless())
+      {
+        t8::begin_screen(sh);
+        initialized_screen = true;
+      }
       
-      if (m_params.enable_terminal_window_resize)
+      if (m_params.enable_terminal_window_resize && !is_headless())
       {
         std::tie(term_win_rows, term_win_cols) = t8::get_terminal_window_size();
         int new_rows = term_win_rows;
@@ -420,11 +667,33 @@ namespace t8x
       
       curr_rnd_seed = rnd::srand_time();
       
-      if (!t8x::setup_logging(m_params.log_mode, get_exe_folder(), m_params.log_filename, curr_rnd_seed))
+      if (!t8x::setup_logging(m_params.log_mode, get_exe_folder(), m_params.log_filename, curr_rnd_seed,
+                              m_params.log_format))
       {
         request_exit(EXIT_FAILURE);
         return;
       }
+      t8::session_rand_seed = curr_rnd_seed;
+      
+      if (m_params.log_mode == LogMode::Replay && m_params.replay_start_frame > 0)
+        request_seek_to_frame(m_params.replay_start_frame);
+      
+      if (m_params.enable_frame_budget)
+      {
+        if (m_params.draw_policy != t8::DrawPolicy::PARTIAL)
+          add_budget_knob("redraw_policy", 2, [this](int level)
+          {
+            curr_draw_policy = level == 0 ? m_params.draw_policy : t8::DrawPolicy::PARTIAL;
+          }, 20, false);
+        add_budget_knob("anim_rate", 3, [this](int level) { anim_rate_divisor = 1 << level; }, 30);
+        budget_governor.set_adjustment_callback([this](const BudgetAdjustment& adj) { on_budget_adjustment(adj); });
+      }
+      
+      if (m_params.enable_profiler)
+      {
+        t8::profiler.set_num_frames(m_params.profiler_num_frames);
+        t8::profiler.set_enabled(true);
+      }
       
       if (m_params.enable_benchmark)
       {
@@ -438,12 +707,97 @@ namespace t8x
     
     virtual void generate_data() = 0;
     
+    void run_update()
+    {
+      t8::ProfileScope prof_scope(t8::ProfileZone::Update);
+      update();
+    }
+    
+    void draw_profiler_overlay()
+    {
+      const auto lines = t8::profiler.get_overlay_lines();
+      const int num_lines = std::min(stlutils::sizeI(lines), NR);
+      for (int r = 0; r < num_lines; ++r)
+        sh.write_buffer(lines[r], r, 0, m_params.profiler_overlay_style);
+    }
+    
+    void reseed_rnd_for_frame()
+    {
+      rnd::srand(static_cast<unsigned int>(t8::make_rand_key(curr_rnd_seed, t8::RandSystem::Default, 0,
+                                                             static_cast<uint32_t>(frame_ctr))));
+    }
+    
+    bool seek_to_frame(int frame)
+    {
+      if (m_params.log_mode != LogMode::Replay)
+      {
+        std::cerr << "ERROR in GameEngine::seek_to_frame() : Only supported in replay mode." << std::endl;
+        return false;
+      }
+      if (frame < frame_ctr)
+      {
+        int snapshot_frame = 0;
+        std::vector<uint8_t> state;
+        if (!snapshots.find(frame, snapshot_frame, state))
+        {
+          std::cerr << "ERROR in GameEngine::seek_to_frame() : No snapshot at or before frame " << frame << "." << std::endl;
+          return false;
+        }
+        StateReader sr(state);
+        if (!load_state(sr))
+          return false;
+        if (!t8x::seek_log_stream(m_params.log_mode, frame_ctr))
+          return false;
+      }
+      fast_forwarding = true;
+      while (frame_ctr < frame && engine_update())
+      {}
+      fast_forwarding = false;
+      return !exit_requested;
+    }
+    
     bool engine_update()
     {
       if (exit_requested)
         return false;
       
-      if (time_inited.was_triggered())
+      if (seek_target_frame >= 0)
+      {
+        int target_frame = seek_target_frame;
+        seek_target_frame = -1;
+        if (!seek_to_frame(target_frame))
+        {
+          request_exit(EXIT_FAILURE);
+          return false;
+        }
+        if (t8x::log_finished)
+          return false;
+      }
+      
+      // The global rnd state can't be saved, so when recording or replaying it is reseeded from
+      //   the seed and the frame number every frame. A seek can then resume from any snapshot.
+      if (m_params.log_mode != LogMode::None)
+        reseed_rnd_for_frame();
+      
+      // Snapshots newer than frame_ctr are still valid after a seek in a replay.
+      if (m_params.snapshot_interval_frames > 0 && frame_ctr % m_params.snapshot_interval_frames == 0
+          && snapshots.newest_frame() < frame_ctr)
+      {
+        StateWriter sw;
+        save_state(sw);
+        snapshots.push(frame_ctr, sw.release());
+      }
+      
+      t8::profiler.begin_frame(frame_ctr);
+      const auto frame_work_start = std::chrono::steady_clock::now();
+      
+      if (is_headless() || fast_forwarding)
+      {
+        real_last_time_s = real_time_s;
+        real_time_s = frame_ctr / static_cast<double>(real_fps);
+        real_dt_s = real_time_s - real_last_time_s;
+      }
+      else if (time_inited.was_triggered())
       {
         auto curr_time = std::chrono::steady_clock::now();
         std::chrono::duration<double> elapsed_seconds = curr_time - real_start_time_s;
@@ -452,11 +806,17 @@ namespace t8x
         real_dt_s = real_time_s - real_last_time_s;
       }
       
-      if (!m_params.suppress_tty_output)
+      const bool tty_output = !m_params.suppress_tty_output && !is_headless() && !fast_forwarding;
+      if (tty_output)
         t8::return_cursor();
       sh.clear();
       
-      if (!t8x::update_log_stream(m_params.log_mode, kpdp, keyboard.get(), get_frame_count()))
+      bool log_ok = false;
+      {
+        t8::ProfileScope prof_scope(t8::ProfileZone::Input);
+        log_ok = t8x::update_log_stream(m_params.log_mode, kpdp, keyboard.get(), get_frame_count(), &frame_input);
+      }
+      if (!log_ok)
       {
         request_exit(EXIT_FAILURE);
         return false;
@@ -554,7 +914,7 @@ namespace t8x
             }
           }
           
-          update();
+          run_update();
           
           if (m_params.enable_hiscores && key == ' ' &&
               (real_time_s - timestamp_game_over > c_min_time_game_over))
@@ -583,7 +943,7 @@ namespace t8x
             }
           }
           
-          update();
+          run_update();
           
           if (m_params.enable_hiscores && key == ' ' &&
               (real_time_s - timestamp_you_won > c_min_time_you_won))
@@ -630,21 +990,34 @@ namespace t8x
           draw_paused(sh, anim_ctr_data[0].anim_ctr, m_params.pause_info_style);
         }
         else
-          update();
+          run_update();
       }
       
-      if (!m_params.suppress_tty_output)
+      if (m_params.show_profiler_overlay && t8::profiler.is_enabled())
+        draw_profiler_overlay();
+      
+      if (tty_output)
       {
-        sh.print_screen_buffer(bg_color, m_params.empty_fg_color, m_params.draw_policy);
+        sh.print_screen_buffer(bg_color, m_params.empty_fg_color, curr_draw_policy);
         //sh.print_screen_buffer_chars();
         //sh.print_screen_buffer_fg_colors();
         //sh.print_screen_buffer_bg_colors();
       }
       
+      t8::profiler.end_frame();
+      
+      if (m_params.enable_frame_budget && !is_headless() && !fast_forwarding)
+      {
+        budget_governor.set_budget_ms(m_params.frame_budget_params.budget_ms > 0.f ?
+                                      m_params.frame_budget_params.budget_ms : 1e3f / real_fps);
+        std::chrono::duration<float, std::milli> frame_work_ms = std::chrono::steady_clock::now() - frame_work_start;
+        budget_governor.report_frame_time_ms(frame_work_ms.count(), frame_ctr);
+      }
+      
       ///
       
       frame_ctr++;
-      if (frame_ctr % anim_ctr_data[0].anim_count_per_frame_count == 0)
+      if (frame_ctr % (anim_ctr_data[0].anim_count_per_frame_count * anim_rate_divisor) == 0)
         anim_ctr_data[0].anim_ctr++;
       
       if (!show_title && !show_instructions && !show_quit_confirm && !show_input_hiscore && !show_hiscores && !paused)
@@ -658,7 +1031,7 @@ namespace t8x
         frame_ctr_measure++;
         
         for (size_t ad_idx = 0; ad_idx < anim_ctr_data.size(); ++ad_idx)
-          if (frame_ctr_measure % anim_ctr_data[ad_idx].anim_count_per_frame_count == 0)
+          if (frame_ctr_measure % (anim_ctr_data[ad_idx].anim_count_per_frame_count * anim_rate_divisor) == 0)
             anim_ctr_data[ad_idx].anim_ctr++;
         
         sim_time_s += sim_dt_s;
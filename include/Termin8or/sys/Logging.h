@@ -10,19 +10,462 @@
 #include <Core/FolderHelper.h>
 #include <Core/Rand.h>
 #include <fstream>
+#include <sstream>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <cstdint>
 
 enum class LogMode { None, Record, Replay };
+// Replay auto-detects the format.
+enum class LogFormat { Text, Binary };
 
 namespace t8x
 {
+  
+  // Input of a frame besides the KeyPressDataPair : The held keys (see KeyStateTracker) and all
+  //   key, mouse and paste events of the frame (see StreamKeyboard::get_frame_events()).
+  //   The held keys are logged as the keys that went down or up since the previous frame.
+  //   Replayed events get the time of the replayed frame.
+  struct FrameInput
+  {
+    t8::KeyStateTracker::KeyBits held_keys;
+    std::vector<t8::KeyEvent> events;
+  };
+  
+  // Compact binary key log : A header (magic, version, varint seed) followed by one record per
+  //   frame that had any input, each being a varint frame delta and one byte per key
+  //   (transient, held). Version 2 shifts the frame delta up one bit, and when that bit is set
+  //   the FrameInput follows : the changed held keys as varint (key index << 1 | down) and the events.
+  //   Recording ends with an end-of-log record that holds the number of frames.
+  //   Frames without a record replay as SpecialKey::None.
+  namespace replay_bin
+  {
+    inline constexpr char c_magic[4] = { 'T', '8', 'R', 'P' };
+    inline constexpr uint8_t c_version = 2;
+    inline constexpr uint8_t c_code_end = 0xFF;
+    inline constexpr int c_num_char_codes = 128;
+    
+    // 0 : No key, 1-127 : ASCII char, 128+ : SpecialKey.
+    inline uint8_t encode_key(const t8::KeyPressData& kpd)
+    {
+      auto key = t8::get_special_key(kpd);
+      if (key != t8::SpecialKey::None)
+        return static_cast<uint8_t>(c_num_char_codes + static_cast<int>(key));
+      auto ch = static_cast<unsigned char>(t8::get_char_key(kpd));
+      return ch < c_num_char_codes ? ch : 0;
+    }
+    
+    inline t8::KeyPressData decode_key(uint8_t code)
+    {
+      if (0 < code && code < c_num_char_codes)
+        return static_cast<char>(code);
+      if (code > c_num_char_codes)
+        return static_cast<t8::SpecialKey>(code - c_num_char_codes);
+      return t8::SpecialKey::None;
+    }
+    
+    inline void write_varint(std::string& buf, uint64_t val)
+    {
+      while (val >= 0x80)
+      {
+        buf += static_cast<char>((val & 0x7F) | 0x80);
+        val >>= 7;
+      }
+      buf += static_cast<char>(val);
+    }
+    
+    inline bool read_varint(const std::vector<uint8_t>& data, size_t& pos, uint64_t& val)
+    {
+      val = 0;
+      for (int shift = 0; pos < data.size() && shift < 64; shift += 7)
+      {
+        auto b = data[pos++];
+        val |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+          return true;
+      }
+      return false;
+    }
+    
+    inline void write_event(std::string& buf, const t8::KeyEvent& event)
+    {
+      buf += static_cast<char>(event.type);
+      write_varint(buf, static_cast<uint64_t>(t8::KeyStateTracker::key_index(event.key) + 1));
+      buf += static_cast<char>(event.modifiers);
+      buf += static_cast<char>(event.action);
+      buf += static_cast<char>(event.mouse.button);
+      buf += static_cast<char>(event.mouse.action);
+      write_varint(buf, static_cast<uint64_t>(std::max(0, event.mouse.r)));
+      write_varint(buf, static_cast<uint64_t>(std::max(0, event.mouse.c)));
+      write_varint(buf, event.paste_text.size());
+      buf += event.paste_text;
+    }
+    
+    inline bool read_event(const std::vector<uint8_t>& data, size_t& pos, t8::KeyEvent& event)
+    {
+      uint64_t key_code = 0, r = 0, c = 0, len = 0;
+      if (pos >= data.size())
+        return false;
+      event.type = static_cast<t8::KeyEventType>(data[pos++]);
+      if (!read_varint(data, pos, key_code) || pos + 4 > data.size())
+        return false;
+      event.key = t8::KeyStateTracker::key_at_index(static_cast<int>(key_code) - 1);
+      event.modifiers = data[pos++];
+      event.action = static_cast<t8::KeyAction>(data[pos++]);
+      event.mouse.button = static_cast<t8::MouseButton>(data[pos++]);
+      event.mouse.action = static_cast<t8::MouseAction>(data[pos++]);
+      if (!read_varint(data, pos, r) || !read_varint(data, pos, c) || !read_varint(data, pos, len)
+          || len > data.size() - pos)
+        return false;
+      event.mouse.r = static_cast<int>(r);
+      event.mouse.c = static_cast<int>(c);
+      event.paste_text.assign(data.begin() + static_cast<std::ptrdiff_t>(pos),
+                              data.begin() + static_cast<std::ptrdiff_t>(pos + len));
+      pos += len;
+      return true;
+    }
+  }
+  
+  // The FrameInput in text logs : Optional tokens after the keys of a frame line, "+<key index>"
+  //   and "-<key index>" for the held keys that changed, and one "E<fields>" token per event with
+  //   comma separated fields and the paste text in hex. Older logs simply lack these tokens.
+  namespace replay_text
+  {
+    inline std::string encode_event(const t8::KeyEvent& event)
+    {
+      static constexpr char c_hex[] = "0123456789abcdef";
+      std::string token = "E" + std::to_string(static_cast<int>(event.type))
+        + ',' + std::to_string(t8::KeyStateTracker::key_index(event.key))
+        + ',' + std::to_string(event.modifiers)
+        + ',' + std::to_string(static_cast<int>(event.action))
+        + ',' + std::to_string(static_cast<int>(event.mouse.button))
+        + ',' + std::to_string(static_cast<int>(event.mouse.action))
+        + ',' + std::to_string(event.mouse.r)
+        + ',' + std::to_string(event.mouse.c) + ',';
+      for (unsigned char ch : event.paste_text)
+      {
+        token += c_hex[ch >> 4];
+        token += c_hex[ch & 0xF];
+      }
+      return token;
+    }
+    
+    inline bool decode_event(const std::string& token, t8::KeyEvent& event)
+    {
+      if (token.empty() || token[0] != 'E')
+        return false;
+      std::istringstream iss(token.substr(1));
+      int fields[8] {};
+      char sep = 0;
+      for (int f_idx = 0; f_idx < 8; ++f_idx)
+        if (!(iss >> fields[f_idx] >> sep) || sep != ',')
+          return false;
+      event.type = static_cast<t8::KeyEventType>(fields[0]);
+      event.key = t8::KeyStateTracker::key_at_index(fields[1]);
+      event.modifiers = static_cast<uint8_t>(fields[2]);
+      event.action = static_cast<t8::KeyAction>(fields[3]);
+      event.mouse.button = static_cast<t8::MouseButton>(fields[4]);
+      event.mouse.action = static_cast<t8::MouseAction>(fields[5]);
+      event.mouse.r = fields[6];
+      event.mouse.c = fields[7];
+      std::string hex;
+      iss >> hex;
+      if (hex.size() % 2 != 0)
+        return false;
+      event.paste_text.clear();
+      for (size_t i = 0; i < hex.size(); i += 2)
+        event.paste_text += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+      return true;
+    }
+    
+    // Writes the tokens of frame_input, prev_held_keys are the held keys of the previous frame.
+    inline void write_frame_input(std::ostream& os, const FrameInput& frame_input,
+                                  t8::KeyStateTracker::KeyBits& prev_held_keys)
+    {
+      const auto changed = frame_input.held_keys ^ prev_held_keys;
+      for (int idx = 0; changed.any() && idx < t8::KeyStateTracker::c_num_keys; ++idx)
+        if (changed.test(idx))
+          os << ' ' << (frame_input.held_keys.test(idx) ? '+' : '-') << idx;
+      for (const auto& event : frame_input.events)
+        os << ' ' << encode_event(event);
+      prev_held_keys = frame_input.held_keys;
+    }
+    
+    // Reads the tokens that remain in iss. held_keys are updated from the held keys of the previous frame.
+    inline bool read_frame_input(std::istream& iss, t8::KeyStateTracker::KeyBits& held_keys,
+                                 std::vector<t8::KeyEvent>* events)
+    {
+      if (events != nullptr)
+        events->clear();
+      std::string token;
+      while (iss >> token)
+      {
+        if (token.size() > 1 && (token[0] == '+' || token[0] == '-'))
+        {
+          int idx = std::atoi(token.c_str() + 1);
+          if (idx < 0 || idx >= t8::KeyStateTracker::c_num_keys)
+            return false;
+          held_keys.set(idx, token[0] == '+');
+        }
+        else if (token[0] == 'E')
+        {
+          t8::KeyEvent event;
+          if (!decode_event(token, event))
+            return false;
+          event.time = t8::KeyEventClock::now();
+          if (events != nullptr)
+            events->emplace_back(event);
+        }
+      }
+      return true;
+    }
+  }
+  
+  // Buffers the records in memory and writes them in large chunks.
+  class BinaryLogWriter
+  {
+    static constexpr size_t c_flush_size = 1 << 16;
+    
+    std::ofstream m_file;
+    std::string m_buf;
+    int m_last_record_frame = 0;
+    int m_num_frames = 0;
+    t8::KeyStateTracker::KeyBits m_held_keys;
+    
+    void flush()
+    {
+      m_file.write(m_buf.data(), static_cast<std::streamsize>(m_buf.size()));
+      m_buf.clear();
+    }
+  
+  public:
+    ~BinaryLogWriter()
+    {
+      close();
+    }
+    
+    bool open(const std::string& file_path, unsigned int rnd_seed)
+    {
+      close();
+      m_file.open(file_path, std::ios::out | std::ios::trunc | std::ios::binary);
+      if (!m_file.is_open())
+      {
+        std::cerr << "ERROR in BinaryLogWriter::open() : Unable to open \"" << file_path << "\" for writing." << std::endl;
+        return false;
+      }
+      m_buf.assign(replay_bin::c_magic, sizeof(replay_bin::c_magic));
+      m_buf += static_cast<char>(replay_bin::c_version);
+      replay_bin::write_varint(m_buf, rnd_seed);
+      m_last_record_frame = 0;
+      m_num_frames = 0;
+      m_held_keys.reset();
+      return true;
+    }
+    
+    bool is_open() const { return m_file.is_open(); }
+    
+    // Call once per frame, in frame order.
+    void write_frame(int frame_count, const t8::KeyPressDataPair& kpdp, const FrameInput* frame_input = nullptr)
+    {
+      m_num_frames = frame_count + 1;
+      const auto code_transient = replay_bin::encode_key(kpdp.transient);
+      const auto code_held = replay_bin::encode_key(kpdp.held);
+      t8::KeyStateTracker::KeyBits changed;
+      if (frame_input != nullptr)
+        changed = frame_input->held_keys ^ m_held_keys;
+      const bool has_events = frame_input != nullptr && !frame_input->events.empty();
+      const bool has_input = changed.any() || has_events;
+      if (code_transient == 0 && code_held == 0 && !has_input)
+        return;
+      replay_bin::write_varint(m_buf, static_cast<uint64_t>(frame_count - m_last_record_frame) << 1 | (has_input ? 1 : 0));
+      m_buf += static_cast<char>(code_transient);
+      m_buf += static_cast<char>(code_held);
+      if (has_input)
+      {
+        replay_bin::write_varint(m_buf, changed.count());
+        for (int idx = 0; idx < t8::KeyStateTracker::c_num_keys; ++idx)
+          if (changed.test(idx))
+            replay_bin::write_varint(m_buf, static_cast<uint64_t>(idx) << 1 | (frame_input->held_keys.test(idx) ? 1 : 0));
+        replay_bin::write_varint(m_buf, frame_input->events.size());
+        for (const auto& event : frame_input->events)
+          replay_bin::write_event(m_buf, event);
+        m_held_keys = frame_input->held_keys;
+      }
+      m_last_record_frame = frame_count;
+      if (m_buf.size() >= c_flush_size)
+        flush();
+    }
+    
+    // Writes the end-of-log record.
+    void close()
+    {
+      if (!m_file.is_open())
+        return;
+      replay_bin::write_varint(m_buf, static_cast<uint64_t>(m_num_frames - m_last_record_frame) << 1);
+      m_buf += static_cast<char>(replay_bin::c_code_end);
+      flush();
+      m_file.close();
+    }
+  };
+  
+  // Reads the whole log into memory up front.
+  class BinaryLogReader
+  {
+    std::vector<uint8_t> m_data;
+    size_t m_pos = 0;
+    size_t m_header_size = 0;
+    uint8_t m_version = replay_bin::c_version;
+    int m_next_frame = 0;
+    uint8_t m_next_code_transient = replay_bin::c_code_end;
+    uint8_t m_next_code_held = 0;
+    std::vector<uint64_t> m_next_held_changes;
+    std::vector<t8::KeyEvent> m_next_events;
+    t8::KeyStateTracker::KeyBits m_held_keys;
+    
+    bool read_frame_input()
+    {
+      uint64_t num_changes = 0, num_events = 0;
+      if (!replay_bin::read_varint(m_data, m_pos, num_changes) || num_changes > t8::KeyStateTracker::c_num_keys)
+        return false;
+      m_next_held_changes.resize(num_changes);
+      for (auto& change : m_next_held_changes)
+        if (!replay_bin::read_varint(m_data, m_pos, change) || (change >> 1) >= t8::KeyStateTracker::c_num_keys)
+          return false;
+      if (!replay_bin::read_varint(m_data, m_pos, num_events) || num_events > m_data.size() - m_pos)
+        return false;
+      m_next_events.resize(num_events);
+      for (auto& event : m_next_events)
+        if (!replay_bin::read_event(m_data, m_pos, event))
+          return false;
+      return true;
+    }
+    
+    void read_record()
+    {
+      m_next_held_changes.clear();
+      m_next_events.clear();
+      uint64_t delta = 0;
+      if (!replay_bin::read_varint(m_data, m_pos, delta) || m_pos >= m_data.size())
+      {
+        // Truncated log (e.g. the recording app crashed) : Ends after the last complete record.
+        m_next_frame++;
+        m_next_code_transient = replay_bin::c_code_end;
+        return;
+      }
+      const bool has_input = m_version >= 2 && (delta & 1) != 0;
+      if (m_version >= 2)
+        delta >>= 1;
+      m_next_frame += static_cast<int>(delta);
+      m_next_code_transient = m_data[m_pos++];
+      if (m_next_code_transient == replay_bin::c_code_end)
+        return;
+      m_next_code_held = m_pos < m_data.size() ? m_data[m_pos++] : 0;
+      if (has_input && !read_frame_input())
+      {
+        m_next_held_changes.clear();
+        m_next_events.clear();
+        m_next_code_transient = replay_bin::c_code_end;
+      }
+    }
+    
+    void apply_held_changes()
+    {
+      for (auto change : m_next_held_changes)
+        m_held_keys.set(static_cast<size_t>(change >> 1), (change & 1) != 0);
+    }
+  
+  public:
+    static bool is_binary_log(const std::string& file_path)
+    {
+      std::ifstream fin(file_path, std::ios::binary);
+      char magic[sizeof(replay_bin::c_magic)] {};
+      return fin.read(magic, sizeof(magic)) && std::equal(std::begin(magic), std::end(magic), replay_bin::c_magic);
+    }
+    
+    bool open(const std::string& file_path, unsigned int& rnd_seed)
+    {
+      m_data.clear();
+      std::ifstream fin(file_path, std::ios::binary);
+      if (!fin.is_open())
+      {
+        std::cerr << "ERROR in BinaryLogReader::open() : Unable to open \"" << file_path << "\"." << std::endl;
+        return false;
+      }
+      m_data.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+      m_pos = sizeof(replay_bin::c_magic);
+      uint64_t seed = 0;
+      if (m_data.size() <= m_pos || !std::equal(std::begin(replay_bin::c_magic), std::end(replay_bin::c_magic), m_data.begin())
+          || (m_version = m_data[m_pos++]) < 1 || m_version > replay_bin::c_version
+          || !replay_bin::read_varint(m_data, m_pos, seed))
+      {
+        std::cerr << "ERROR in BinaryLogReader::open() : Invalid or unsupported log file \"" << file_path << "\"." << std::endl;
+        return false;
+      }
+      rnd_seed = static_cast<unsigned int>(seed);
+      m_header_size = m_pos;
+      m_next_frame = 0;
+      m_held_keys.reset();
+      read_record();
+      return true;
+    }
+    
+    // The next read_frame() call will be for frame_count. The held keys are replayed up to it.
+    void seek(int frame_count)
+    {
+      m_pos = m_header_size;
+      m_next_frame = 0;
+      m_held_keys.reset();
+      read_record();
+      while (m_next_frame < frame_count && m_next_code_transient != replay_bin::c_code_end)
+      {
+        apply_held_changes();
+        read_record();
+      }
+    }
+    
+    // Call once per frame, in frame order. Returns false once all recorded frames have been read.
+    bool read_frame(int frame_count, t8::KeyPressDataPair& kpdp, FrameInput* frame_input = nullptr)
+    {
+      if (frame_input != nullptr)
+        frame_input->events.clear();
+      if (frame_count >= m_next_frame && m_next_code_transient == replay_bin::c_code_end)
+        return false;
+      if (frame_count == m_next_frame)
+      {
+        kpdp.transient = replay_bin::decode_key(m_next_code_transient);
+        kpdp.held = replay_bin::decode_key(m_next_code_held);
+        apply_held_changes();
+        if (frame_input != nullptr)
+        {
+          frame_input->events.swap(m_next_events);
+          for (auto& event : frame_input->events)
+            event.time = t8::KeyEventClock::now();
+        }
+        read_record();
+      }
+      else
+        kpdp.transient = kpdp.held = t8::SpecialKey::None;
+      if (frame_input != nullptr)
+        frame_input->held_keys = m_held_keys;
+      return true;
+    }
+  };
+  
   std::ofstream rec_file;
   std::ifstream rep_file;
+  inline BinaryLogWriter bin_rec_file;
+  inline BinaryLogReader bin_rep_file;
+  inline t8::KeyStateTracker::KeyBits rec_held_keys, rep_held_keys; // Text logs.
+  inline LogFormat curr_log_format = LogFormat::Text;
   bool log_finished = false;
   
-  bool setup_logging(LogMode log_mode, const std::string& log_path, const std::string& log_filename, unsigned int& curr_rnd_seed)
+  bool setup_logging(LogMode log_mode, const std::string& log_path, const std::string& log_filename, unsigned int& curr_rnd_seed,
+                     LogFormat log_format = LogFormat::Text)
   {
     std::string log_filepath;
     log_filepath = folder::join_file_path({ log_path, log_filename });
+    curr_log_format = log_format;
   
     switch (log_mode)
     {
@@ -30,10 +473,23 @@ namespace t8x
         break;
       case LogMode::Record:
         folder::delete_file(log_filename);
+        if (log_format == LogFormat::Binary)
+          return bin_rec_file.open(log_filepath, curr_rnd_seed);
         rec_file = std::ofstream { log_filepath, std::ios::out | std::ios::trunc };
         rec_file << curr_rnd_seed << '\n';
+        rec_held_keys.reset();
         break;
       case LogMode::Replay:
+        if (BinaryLogReader::is_binary_log(log_filepath))
+        {
+          curr_log_format = LogFormat::Binary;
+          if (!bin_rep_file.open(log_filepath, curr_rnd_seed))
+            return false;
+          rnd::srand(curr_rnd_seed);
+          break;
+        }
+        curr_log_format = LogFormat::Text;
+        rep_held_keys.reset();
         rep_file = std::ifstream { log_filepath, std::ios::in };
         if (!rep_file.is_open())
         {
@@ -53,9 +509,17 @@ namespace t8x
     return true;
   }
   
-  bool update_log_stream(LogMode log_mode, t8::KeyPressDataPair& kpdp, t8::StreamKeyboard* keyboard, const int frame_count)
+  // frame_input (optional) gets the held keys and the events of the frame, from the keyboard
+  //   or from the replayed log. When recording, they are logged along with kpdp.
+  bool update_log_stream(LogMode log_mode, t8::KeyPressDataPair& kpdp, t8::StreamKeyboard* keyboard, const int frame_count,
+                         FrameInput* frame_input = nullptr)
   {
-    if (log_mode == LogMode::Replay)
+    if (log_mode == LogMode::Replay && curr_log_format == LogFormat::Binary)
+    {
+      if (!bin_rep_file.read_frame(frame_count, kpdp, frame_input))
+        log_finished = true;
+    }
+    else if (log_mode == LogMode::Replay)
     {
       std::string line;
       if (std::getline(rep_file, line))
@@ -84,14 +548,33 @@ namespace t8x
           kpdp.held = ' ';
         else if (log_key_held.size() > 1)
           kpdp.held = t8::string_to_special_key(log_key_held);
+        
+        if (!replay_text::read_frame_input(iss, rep_held_keys, frame_input != nullptr ? &frame_input->events : nullptr))
+        {
+          std::cerr << "REPLAY ERROR : Invalid input in frame number " << frame_count << ". Exiting!" << std::endl;
+          return false;
+        }
+        if (frame_input != nullptr)
+          frame_input->held_keys = rep_held_keys;
       }
       else
+      {
         log_finished = true;
+        if (frame_input != nullptr)
+          frame_input->events.clear();
+      }
     }
     else if (keyboard != nullptr)
     {
       kpdp = keyboard->readKey();
-      if (log_mode == LogMode::Record)
+      if (frame_input != nullptr)
+      {
+        frame_input->held_keys = keyboard->get_key_state().get_held_keys();
+        frame_input->events = keyboard->get_frame_events();
+      }
+      if (log_mode == LogMode::Record && curr_log_format == LogFormat::Binary)
+        bin_rec_file.write_frame(frame_count, kpdp, frame_input);
+      else if (log_mode == LogMode::Record)
       {
         rec_file << std::to_string(frame_count) << ' ';
         
@@ -125,10 +608,59 @@ namespace t8x
             rec_file << "--";
         }
         
+        if (frame_input != nullptr)
+          replay_text::write_frame_input(rec_file, *frame_input, rec_held_keys);
+        
         rec_file << '\n';
         rec_file.flush();
       }
     }
+    else if (frame_input != nullptr)
+    {
+      frame_input->held_keys.reset();
+      frame_input->events.clear();
+    }
     return true;
   }
+  
+  // Continues a replay from frame_count, e.g. after restoring a snapshot.
+  bool seek_log_stream(LogMode log_mode, int frame_count)
+  {
+    if (log_mode != LogMode::Replay)
+    {
+      std::cerr << "ERROR in seek_log_stream() : Only supported for LogMode::Replay." << std::endl;
+      return false;
+    }
+    log_finished = false;
+    if (curr_log_format == LogFormat::Binary)
+    {
+      bin_rep_file.seek(frame_count);
+      return true;
+    }
+    // Text log : Skip the seed line and frame_count frame lines, replaying the held keys.
+    rep_file.clear();
+    rep_file.seekg(0);
+    rep_held_keys.reset();
+    std::string line;
+    for (int line_idx = 0; line_idx <= frame_count; ++line_idx)
+    {
+      if (!std::getline(rep_file, line))
+        break;
+      if (line_idx > 0)
+      {
+        std::istringstream iss(line);
+        std::string token;
+        iss >> token >> token >> token; // Frame number and keys.
+        replay_text::read_frame_input(iss, rep_held_keys, nullptr);
+      }
+    }
+    return true;
+  }
+  
+  // Writes what is left of the recording.
+  void finish_logging(LogMode log_mode)
+  {
+    if (log_mode == LogMode::Record && curr_log_format == LogFormat::Binary)
+      bin_rec_file.close();
+  }
 }
@@ -0,0 +1,305 @@
+//
+//  Profiler.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include <array>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+
+
+namespace t8
+{
+  
+  enum class ProfileZone
+  {
+    Input,
+    Update,
+    SpriteDraw,
+    Physics,
+    CollisionBroadPhase,
+    CollisionNarrowPhase,
+    ScreenDiff,
+    Encode,
+    TermWrite,
+    NUM_ZONES
+  };
+  constexpr int c_num_profile_zones = static_cast<int>(ProfileZone::NUM_ZONES);
+  
+  inline const char* get_profile_zone_name(ProfileZone zone)
+  {
+    switch (zone)
+    {
+      case ProfileZone::Input: return "Input";
+      case ProfileZone::Update: return "Update";
+      case ProfileZone::SpriteDraw: return "SpriteDraw";
+      case ProfileZone::Physics: return "Physics";
+      case ProfileZone::CollisionBroadPhase: return "CollBroad";
+      case ProfileZone::CollisionNarrowPhase: return "CollNarrow";
+      case ProfileZone::ScreenDiff: return "ScreenDiff";
+      case ProfileZone::Encode: return "Encode";
+      case ProfileZone::TermWrite: return "TermWrite";
+      default: return "?";
+    }
+  }
+  
+  struct ProfileStats
+  {
+    float avg_ms = 0.f;
+    float p50_ms = 0.f;
+    float p95_ms = 0.f;
+    float p99_ms = 0.f;
+    float max_ms = 0.f;
+    // Frames where the time exceeded spike_factor times the median (see Profiler::set_spike_factor()).
+    int num_spikes = 0;
+  };
+  
+  // Per-frame timing of the engine phases (ProfileZone), kept for the last N frames.
+  // Zones are timed with ProfileScope and only from the main thread. Nested zones are also
+  //   counted in the enclosing zone, e.g. SpriteDraw and Physics typically run within Update.
+  // Disabled by default, in which case a ProfileScope costs one branch.
+  class Profiler
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+  
+  private:
+    struct TraceEvent
+    {
+      ProfileZone zone = ProfileZone::Update;
+      int64_t start_us = 0;
+      int64_t dur_us = 0;
+    };
+    
+    struct FrameRecord
+    {
+      int frame = 0;
+      int64_t start_us = 0;
+      float frame_ms = 0.f;
+      std::array<float, c_num_profile_zones> zone_ms {};
+      std::vector<TraceEvent> events;
+    };
+    
+    std::vector<FrameRecord> m_frames; // Ring buffer.
+    int m_capacity = 300;
+    int m_num_recorded = 0;
+    FrameRecord m_curr;
+    bool m_enabled = false;
+    bool m_in_frame = false;
+    float m_spike_factor = 2.f;
+    Clock::time_point m_epoch = Clock::now();
+    Clock::time_point m_frame_start;
+    
+    int64_t to_us(Clock::time_point t) const
+    {
+      return std::chrono::duration_cast<std::chrono::microseconds>(t - m_epoch).count();
+    }
+    
+    template<typename Func>
+    ProfileStats calc_stats(Func get_ms) const
+    {
+      ProfileStats stats;
+      const int N = num_frames();
+      if (N == 0)
+        return stats;
+      std::vector<float> samples;
+      samples.reserve(N);
+      for (int i = 0; i < N; ++i)
+        samples.emplace_back(get_ms(m_frames[i]));
+      std::sort(samples.begin(), samples.end());
+      auto f_percentile = [&samples, N](float p)
+      {
+        int idx = static_cast<int>(p * static_cast<float>(N) + 0.999f) - 1;
+        return samples[std::clamp(idx, 0, N - 1)];
+      };
+      float sum = 0.f;
+      for (auto ms : samples)
+        sum += ms;
+      stats.avg_ms = sum / static_cast<float>(N);
+      stats.p50_ms = f_percentile(0.50f);
+      stats.p95_ms = f_percentile(0.95f);
+      stats.p99_ms = f_percentile(0.99f);
+      stats.max_ms = samples.back();
+      const float spike_ms = m_spike_factor * stats.p50_ms;
+      stats.num_spikes = static_cast<int>(samples.end() - std::upper_bound(samples.begin(), samples.end(), spike_ms));
+      if (stats.p50_ms <= 0.f)
+        stats.num_spikes = 0;
+      return stats;
+    }
+  
+  public:
+    Profiler(int num_frames = 300)
+      : m_capacity(std::max(1, num_frames))
+    {}
+    
+    void set_enabled(bool enable)
+    {
+      m_enabled = enable;
+      m_in_frame = false;
+    }
+    bool is_enabled() const { return m_enabled; }
+    
+    // Number of frames the statistics and the trace are based on. Clears the recorded frames.
+    void set_num_frames(int num_frames)
+    {
+      m_capacity = std::max(1, num_frames);
+      clear();
+    }
+    
+    void set_spike_factor(float factor) { m_spike_factor = factor; }
+    
+    void begin_frame(int frame)
+    {
+      if (!m_enabled)
+        return;
+      if (m_in_frame)
+        end_frame();
+      m_frame_start = Clock::now();
+      m_curr.frame = frame;
+      m_curr.start_us = to_us(m_frame_start);
+      m_curr.zone_ms.fill(0.f);
+      m_curr.events.clear();
+      m_in_frame = true;
+    }
+    
+    void end_frame()
+    {
+      if (!m_enabled || !m_in_frame)
+        return;
+      m_curr.frame_ms = std::chrono::duration<float, std::milli>(Clock::now() - m_frame_start).count();
+      if (static_cast<int>(m_frames.size()) < m_capacity)
+        m_frames.emplace_back();
+      // Swapping keeps the capacity of the event vectors around.
+      std::swap(m_frames[m_num_recorded % m_capacity], m_curr);
+      m_num_recorded++;
+      m_in_frame = false;
+    }
+    
+    // Zones outside of begin_frame() / end_frame() are ignored.
+    void add_zone(ProfileZone zone, Clock::time_point start, Clock::time_point end)
+    {
+      if (!m_enabled || !m_in_frame)
+        return;
+      const auto start_us = to_us(start);
+      const auto dur_us = to_us(end) - start_us;
+      m_curr.zone_ms[static_cast<int>(zone)] += std::chrono::duration<float, std::milli>(end - start).count();
+      m_curr.events.push_back({ zone, start_us, dur_us });
+    }
+    
+    int num_frames() const { return std::min(m_num_recorded, m_capacity); }
+    
+    ProfileStats get_frame_stats() const
+    {
+      return calc_stats([](const FrameRecord& fr) { return fr.frame_ms; });
+    }
+    
+    ProfileStats get_zone_stats(ProfileZone zone) const
+    {
+      const int zone_idx = static_cast<int>(zone);
+      return calc_stats([zone_idx](const FrameRecord& fr) { return fr.zone_ms[zone_idx]; });
+    }
+    
+    // One line per zone (and one for the whole frame) with the p50/p95/p99/max times in ms,
+    //   e.g. for an overlay drawn with ScreenHandler::write_buffer().
+    std::vector<std::string> get_overlay_lines() const
+    {
+      std::vector<std::string> lines;
+      char buf[80];
+      std::snprintf(buf, sizeof(buf), "%-10s %6s %6s %6s %6s %4s", "ms", "p50", "p95", "p99", "max", "spk");
+      lines.emplace_back(buf);
+      auto f_add = [&](const char* name, const ProfileStats& stats)
+      {
+        std::snprintf(buf, sizeof(buf), "%-10s %6.2f %6.2f %6.2f %6.2f %4d", name,
+                      stats.p50_ms, stats.p95_ms, stats.p99_ms, stats.max_ms, stats.num_spikes);
+        lines.emplace_back(buf);
+      };
+      for (int zone_idx = 0; zone_idx < c_num_profile_zones; ++zone_idx)
+      {
+        const auto zone = static_cast<ProfileZone>(zone_idx);
+        f_add(get_profile_zone_name(zone), get_zone_stats(zone));
+      }
+      f_add("Frame", get_frame_stats());
+      return lines;
+    }
+    
+    // Writes the recorded frames in the Chrome trace event format, which can be opened in
+    //   chrome://tracing or in Perfetto (ui.perfetto.dev).
+    bool write_chrome_trace(const std::string& file_path) const
+    {
+      std::ofstream fout(file_path);
+      if (!fout.is_open())
+      {
+        std::cerr << "ERROR in Profiler::write_chrome_trace() : Unable to open \"" << file_path << "\" for writing." << std::endl;
+        return false;
+      }
+      fout << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      bool first = true;
+      auto f_event = [&](const char* name, int64_t start_us, int64_t dur_us, int frame)
+      {
+        fout << (first ? "\n" : ",\n");
+        fout << "{\"name\":\"" << name << "\",\"cat\":\"t8\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+             << ",\"ts\":" << start_us << ",\"dur\":" << dur_us
+             << ",\"args\":{\"frame\":" << frame << "}}";
+        first = false;
+      };
+      const int N = num_frames();
+      const int oldest_idx = m_num_recorded > m_capacity ? m_num_recorded % m_capacity : 0;
+      for (int i = 0; i < N; ++i)
+      {
+        const auto& fr = m_frames[(oldest_idx + i) % m_capacity];
+        f_event("Frame", fr.start_us, static_cast<int64_t>(fr.frame_ms * 1e3f), fr.frame);
+        for (const auto& ev : fr.events)
+          f_event(get_profile_zone_name(ev.zone), ev.start_us, ev.dur_us, fr.frame);
+      }
+      fout << "\n]}\n";
+      return fout.good();
+    }
+    
+    void clear()
+    {
+      m_frames.clear();
+      m_num_recorded = 0;
+      m_in_frame = false;
+    }
+  };
+  
+  inline Profiler profiler;
+  
+  // Times the enclosing scope as zone.
+  class ProfileScope
+  {
+    Profiler& m_profiler;
+    ProfileZone m_zone;
+    Profiler::Clock::time_point m_start;
+    bool m_active = false;
+  
+  public:
+    ProfileScope(ProfileZone zone, Profiler& prof = profiler)
+      : m_profiler(prof)
+      , m_zone(zone)
+      , m_active(prof.is_enabled())
+    {
+      if (m_active)
+        m_start = Profiler::Clock::now();
+    }
+    
+    ~ProfileScope()
+    {
+      if (m_active)
+        m_profiler.add_zone(m_zone, m_start, Profiler::Clock::now());
+    }
+    
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+  };
+
+}
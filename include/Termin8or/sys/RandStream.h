@@ -0,0 +1,173 @@
+//
+//  RandStream.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <atomic>
+#include <assert.h>
+
+namespace t8
+{
+
+  // Counter-based random number streams.
+  // A stream is identified by a key derived from (seed, system, entity, frame) and the
+  //   n:th value of a stream is a pure function of (key, n) (SplitMix64 finalizer).
+  // This means that the values drawn for e.g. one emitter during one frame don't depend
+  //   on how many values other systems drew before it or in which order, so replays stay
+  //   reproducible when the update order changes or work is spread over several threads.
+
+  enum class RandSystem : uint32_t
+  {
+    Default,
+    Particles,
+    Physics,
+    GameLogic,
+    User = 64, // First id free for game specific systems.
+  };
+
+  constexpr uint64_t c_rand_golden_gamma = 0x9E3779B97F4A7C15ull;
+
+  constexpr uint64_t splitmix64_mix(uint64_t z)
+  {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  constexpr uint64_t make_rand_key(uint64_t seed, RandSystem system, uint32_t entity, uint32_t frame)
+  {
+    auto key = splitmix64_mix(seed + c_rand_golden_gamma);
+    key = splitmix64_mix(key ^ ((static_cast<uint64_t>(system) << 32) | entity));
+    key = splitmix64_mix(key ^ (static_cast<uint64_t>(frame) * c_rand_golden_gamma));
+    return key;
+  }
+
+  class RandStream
+  {
+    uint64_t key = 0;
+    uint64_t counter = 0;
+
+    static float to_float(uint64_t val)
+    {
+      return static_cast<float>(val >> 40) * (1.f / 16777216.f); // 24 bits => [0, 1).
+    }
+
+  public:
+    RandStream(uint64_t seed = 0)
+    {
+      set_seed(seed);
+    }
+    RandStream(uint64_t seed, RandSystem system, uint32_t entity, uint32_t frame)
+    {
+      set_key(seed, system, entity, frame);
+    }
+
+    void set_seed(uint64_t seed)
+    {
+      set_key(seed, RandSystem::Default, 0, 0);
+    }
+
+    void set_key(uint64_t seed, RandSystem system, uint32_t entity, uint32_t frame)
+    {
+      key = make_rand_key(seed, system, entity, frame);
+      counter = 0;
+    }
+
+    uint64_t get_key() const { return key; }
+    uint64_t get_counter() const { return counter; }
+    void set_counter(uint64_t ctr) { counter = ctr; }
+
+    // The value at position ctr of the stream with the given key.
+    static constexpr uint64_t at(uint64_t key, uint64_t ctr)
+    {
+      return splitmix64_mix(key + (ctr + 1) * c_rand_golden_gamma);
+    }
+
+    uint64_t next_u64() { return at(key, counter++); }
+    uint32_t next_u32() { return static_cast<uint32_t>(next_u64() >> 32); }
+
+    // Uniform in [0, 1).
+    float next_float() { return to_float(next_u64()); }
+
+    // Uniform in [start, end).
+    float next_float(float start, float end) { return start + (end - start)*next_float(); }
+
+    // Uniform in [start, end].
+    int next_int(int start, int end)
+    {
+      assert(start <= end);
+      auto range = static_cast<uint64_t>(static_cast<int64_t>(end) - start + 1);
+      return static_cast<int>(start + static_cast<int64_t>(next_u64() % range));
+    }
+
+    // The iterations are independent of each other, so the loop can be vectorized.
+    void fill(float* dst, size_t num)
+    {
+      const auto ctr0 = counter;
+      for (size_t i = 0; i < num; ++i)
+        dst[i] = to_float(at(key, ctr0 + i));
+      counter += num;
+    }
+
+    // Weighted pick, same semantics as rnd::rand_select() for weighted vectors.
+    template<typename T>
+    const T& select(const std::vector<std::pair<float, T>>& weighted_vec)
+    {
+      assert(!weighted_vec.empty());
+      float weight_sum = 0.f;
+      for (const auto& wp : weighted_vec)
+        weight_sum += wp.first;
+      auto r = next_float() * weight_sum;
+      for (const auto& wp : weighted_vec)
+      {
+        if (r < wp.first)
+          return wp.second;
+        r -= wp.first;
+      }
+      return weighted_vec.back().second;
+    }
+
+    // Independent child stream, e.g. one per entity or per worker.
+    RandStream split(uint32_t sub_id) const
+    {
+      RandStream child;
+      child.key = splitmix64_mix(key ^ splitmix64_mix(static_cast<uint64_t>(sub_id) + c_rand_golden_gamma));
+      return child;
+    }
+  };
+
+  // Seed of the running session. GameEngine sets it to its (recorded or replayed) seed.
+  //   Subsystems that aren't given a seed of their own (e.g. ParticleHandler) take it on their
+  //   first update, so that they follow the session seed without drawing from the global rnd.
+  inline uint64_t session_rand_seed = 0;
+  
+  // Entity ids for such subsystems, in order of creation.
+  inline uint32_t next_rand_entity()
+  {
+    static std::atomic<uint32_t> s_next_entity = 0;
+    return s_next_entity++;
+  }
+  
+  // Identifies the streams of one entity of a subsystem. frame is typically bumped once per update.
+  struct RandStreamKey
+  {
+    uint64_t seed = 0;
+    RandSystem system = RandSystem::Default;
+    uint32_t entity = 0;
+    uint32_t frame = 0;
+
+    RandStream stream(uint32_t sub_id = 0) const
+    {
+      RandStream rs { seed, system, entity, frame };
+      return sub_id == 0 ? rs : rs.split(sub_id);
+    }
+  };
+
+}
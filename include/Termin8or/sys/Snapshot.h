@@ -0,0 +1,302 @@
+//
+//  Snapshot.h
+//  Termin8or
+//
+//  Created by Rasmus Anthin on 2026-10-19.
+//
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+#include <iostream>
+
+
+namespace t8x
+{
+  
+  // Appends the state of e.g. the engine, a DynamicsSystem or a SpriteHandler to a byte buffer.
+  // Only meant for in-memory snapshots within the same build, so values are stored as raw bytes.
+  class StateWriter
+  {
+    std::vector<uint8_t> m_data;
+  
+  public:
+    template<typename T>
+    void write(const T& val)
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "ERROR in StateWriter::write() : T must be trivially copyable.");
+      const auto* bytes = reinterpret_cast<const uint8_t*>(&val);
+      m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+    }
+    
+    template<typename T>
+    void write_vector(const std::vector<T>& vec)
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "ERROR in StateWriter::write_vector() : T must be trivially copyable.");
+      write(static_cast<uint64_t>(vec.size()));
+      const auto* bytes = reinterpret_cast<const uint8_t*>(vec.data());
+      m_data.insert(m_data.end(), bytes, bytes + vec.size() * sizeof(T));
+    }
+    
+    void write_string(const std::string& str)
+    {
+      write(static_cast<uint64_t>(str.size()));
+      m_data.insert(m_data.end(), str.begin(), str.end());
+    }
+    
+    const std::vector<uint8_t>& data() const { return m_data; }
+    std::vector<uint8_t> release() { return std::move(m_data); }
+    void clear() { m_data.clear(); }
+  };
+  
+  // Counterpart of StateWriter. Reads fail (and keep failing) once the data runs out.
+  class StateReader
+  {
+    const std::vector<uint8_t>& m_data;
+    size_t m_pos = 0;
+    bool m_ok = true;
+    
+    bool take(void* dst, size_t num_bytes)
+    {
+      if (!m_ok || m_data.size() - m_pos < num_bytes)
+      {
+        m_ok = false;
+        return false;
+      }
+      if (num_bytes > 0)
+        std::memcpy(dst, m_data.data() + m_pos, num_bytes);
+      m_pos += num_bytes;
+      return true;
+    }
+  
+  public:
+    StateReader(const std::vector<uint8_t>& data)
+      : m_data(data)
+    {}
+    
+    template<typename T>
+    bool read(T& val)
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "ERROR in StateReader::read() : T must be trivially copyable.");
+      return take(&val, sizeof(T));
+    }
+    
+    template<typename T>
+    bool read_vector(std::vector<T>& vec)
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "ERROR in StateReader::read_vector() : T must be trivially copyable.");
+      uint64_t size = 0;
+      if (!read(size) || (m_data.size() - m_pos) / sizeof(T) < size)
+        return m_ok = false;
+      vec.resize(static_cast<size_t>(size));
+      return take(vec.data(), vec.size() * sizeof(T));
+    }
+    
+    bool read_string(std::string& str)
+    {
+      uint64_t size = 0;
+      if (!read(size) || m_data.size() - m_pos < size)
+        return m_ok = false;
+      str.assign(m_data.begin() + m_pos, m_data.begin() + m_pos + static_cast<size_t>(size));
+      m_pos += static_cast<size_t>(size);
+      return true;
+    }
+    
+    bool ok() const { return m_ok; }
+    bool at_end() const { return m_pos == m_data.size(); }
+  };
+  
+  namespace snapshot
+  {
+    inline void write_varint(std::vector<uint8_t>& buf, uint64_t val)
+    {
+      while (val >= 0x80)
+      {
+        buf.emplace_back(static_cast<uint8_t>((val & 0x7F) | 0x80));
+        val >>= 7;
+      }
+      buf.emplace_back(static_cast<uint8_t>(val));
+    }
+    
+    inline bool read_varint(const std::vector<uint8_t>& buf, size_t& pos, uint64_t& val)
+    {
+      val = 0;
+      for (int shift = 0; pos < buf.size() && shift < 64; shift += 7)
+      {
+        auto b = buf[pos++];
+        val |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+          return true;
+      }
+      return false;
+    }
+    
+    // XORs state with ref (zero padded) and run-length encodes the result as
+    //   [varint size] { [varint num equal bytes] [varint num literals] [literals] }.
+    // Most of the state doesn't change between two snapshots, so this is mostly zero runs.
+    inline std::vector<uint8_t> encode_delta(const std::vector<uint8_t>& state, const std::vector<uint8_t>& ref)
+    {
+      std::vector<uint8_t> delta;
+      write_varint(delta, state.size());
+      auto f_xor = [&](size_t idx) -> uint8_t
+      {
+        return state[idx] ^ (idx < ref.size() ? ref[idx] : 0);
+      };
+      const size_t N = state.size();
+      size_t idx = 0;
+      while (idx < N)
+      {
+        size_t idx_lit = idx;
+        while (idx_lit < N && f_xor(idx_lit) == 0)
+          idx_lit++;
+        // A literal run ends where at least 4 unchanged bytes follow.
+        size_t idx_end = idx_lit;
+        size_t num_zeros = 0;
+        while (idx_end < N && num_zeros < 4)
+        {
+          num_zeros = f_xor(idx_end) == 0 ? num_zeros + 1 : 0;
+          idx_end++;
+        }
+        if (num_zeros >= 4)
+          idx_end -= num_zeros;
+        write_varint(delta, idx_lit - idx);
+        write_varint(delta, idx_end - idx_lit);
+        for (size_t i = idx_lit; i < idx_end; ++i)
+          delta.emplace_back(f_xor(i));
+        idx = idx_end;
+      }
+      return delta;
+    }
+    
+    inline bool decode_delta(const std::vector<uint8_t>& delta, const std::vector<uint8_t>& ref,
+                             std::vector<uint8_t>& state)
+    {
+      size_t pos = 0;
+      uint64_t size = 0;
+      if (!read_varint(delta, pos, size))
+        return false;
+      state.assign(static_cast<size_t>(size), 0);
+      for (size_t idx = 0; idx < state.size() && idx < ref.size(); ++idx)
+        state[idx] = ref[idx];
+      size_t idx = 0;
+      while (pos < delta.size())
+      {
+        uint64_t num_equal = 0, num_lit = 0;
+        if (!read_varint(delta, pos, num_equal) || !read_varint(delta, pos, num_lit))
+          return false;
+        idx += static_cast<size_t>(num_equal);
+        if (idx + num_lit > state.size() || pos + num_lit > delta.size())
+          return false;
+        for (uint64_t i = 0; i < num_lit; ++i)
+          state[idx++] ^= delta[pos++];
+      }
+      return true;
+    }
+  }
+  
+  // Ring buffer of periodic state snapshots (see GameEngine::save_state()).
+  // Every keyframe_interval:th snapshot is stored in full (a keyframe) and the ones in between
+  //   are stored as deltas against the latest keyframe, so restoring never needs more than
+  //   one keyframe and one delta.
+  class SnapshotRing
+  {
+    struct Entry
+    {
+      int frame = 0;
+      bool keyframe = false;
+      std::vector<uint8_t> data;
+    };
+    std::deque<Entry> m_entries;
+    int m_capacity = 64;
+    int m_keyframe_interval = 8;
+    
+    const Entry* find_keyframe(size_t entry_idx) const
+    {
+      for (size_t i = entry_idx + 1; i-- > 0;)
+        if (m_entries[i].keyframe)
+          return &m_entries[i];
+      return nullptr;
+    }
+  
+  public:
+    SnapshotRing(int capacity = 64, int keyframe_interval = 8)
+      : m_capacity(std::max(1, capacity))
+      , m_keyframe_interval(std::max(1, keyframe_interval))
+    {}
+    
+    // Snapshots at or after frame are dropped first, e.g. after a rewind.
+    void push(int frame, std::vector<uint8_t> state)
+    {
+      while (!m_entries.empty() && m_entries.back().frame >= frame)
+        m_entries.pop_back();
+      int num_since_keyframe = 0;
+      for (auto it = m_entries.rbegin(); it != m_entries.rend() && !it->keyframe; ++it)
+        num_since_keyframe++;
+      
+      Entry entry;
+      entry.frame = frame;
+      const auto* keyframe = m_entries.empty() ? nullptr : find_keyframe(m_entries.size() - 1);
+      if (keyframe == nullptr || num_since_keyframe + 1 >= m_keyframe_interval)
+      {
+        entry.keyframe = true;
+        entry.data = std::move(state);
+      }
+      else
+        entry.data = snapshot::encode_delta(state, keyframe->data);
+      m_entries.emplace_back(std::move(entry));
+      
+      // Deltas can't outlive their keyframe.
+      while (static_cast<int>(m_entries.size()) > m_capacity)
+      {
+        m_entries.pop_front();
+        while (!m_entries.empty() && !m_entries.front().keyframe)
+          m_entries.pop_front();
+      }
+    }
+    
+    // Restores the latest snapshot taken at or before frame. Returns false if there is none.
+    bool find(int frame, int& snapshot_frame, std::vector<uint8_t>& state) const
+    {
+      for (size_t i = m_entries.size(); i-- > 0;)
+      {
+        const auto& entry = m_entries[i];
+        if (entry.frame > frame)
+          continue;
+        snapshot_frame = entry.frame;
+        if (entry.keyframe)
+        {
+          state = entry.data;
+          return true;
+        }
+        const auto* keyframe = find_keyframe(i);
+        if (keyframe == nullptr || !snapshot::decode_delta(entry.data, keyframe->data, state))
+        {
+          std::cerr << "ERROR in SnapshotRing::find() : Corrupt snapshot at frame " << entry.frame << "." << std::endl;
+          return false;
+        }
+        return true;
+      }
+      return false;
+    }
+    
+    int num_snapshots() const { return static_cast<int>(m_entries.size()); }
+    int oldest_frame() const { return m_entries.empty() ? -1 : m_entries.front().frame; }
+    int newest_frame() const { return m_entries.empty() ? -1 : m_entries.back().frame; }
+    
+    size_t num_bytes() const
+    {
+      size_t num = 0;
+      for (const auto& entry : m_entries)
+        num += entry.data.size();
+      return num;
+    }
+    
+    void clear() { m_entries.clear(); }
+  };
+
+}
@@ -15,6 +15,11 @@
 #include <map>
 #include <vector>
 #include <filesystem>
+#include <span>
+#include <array>
+#include <tuple>
+#include <limits>
+#include <algorithm>
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -75,6 +80,79 @@ namespace t8x
   };
 
   using FontDataColl = std::map<Font, FontData>;
+  
+  // Font data in static storage, e.g. generated by AssetCodegen (see AssetCodegen.h).
+  // Chars are stored as byte values [0, 255] in ints so that the tables don't depend on the signedness of char.
+  struct EmbeddedFontPiece
+  {
+    const char* part = "";
+    int r = 0;
+    int c = 0;
+    const char* fg = "";
+    const char* bg = "";
+    int prio = 0;
+  };
+  
+  struct EmbeddedFontChar
+  {
+    int ch_prev = -1; // -1 : not a contextual glyph.
+    int ch = -1;
+    int width = -1;
+    int piece_start = 0;
+    int num_pieces = 0;
+  };
+  
+  struct EmbeddedFontKerning
+  {
+    int ch0 = -1;
+    int ch1 = -1;
+    int kerning = 0;
+  };
+  
+  struct EmbeddedFontOrdering
+  {
+    int ch0 = -1;
+    int ch1 = -1;
+    int prio0 = 0;
+    int prio1 = 0;
+  };
+  
+  struct EmbeddedFont
+  {
+    std::span<const EmbeddedFontChar> chars;
+    std::span<const EmbeddedFontPiece> pieces;
+    std::span<const EmbeddedFontKerning> kernings;
+    std::span<const EmbeddedFontOrdering> orderings;
+    bool treat_lower_case_as_upper_case = false;
+  };
+  
+  // No file I/O and no text parsing, just copies the tables into a FontData.
+  inline FontData make_font_data(const EmbeddedFont& embedded_font)
+  {
+    FontData font_data;
+    const int num_pieces = static_cast<int>(embedded_font.pieces.size());
+    for (const auto& efc : embedded_font.chars)
+    {
+      FontChar font_char;
+      font_char.width = efc.width;
+      for (int p_idx = efc.piece_start; p_idx < efc.piece_start + efc.num_pieces && p_idx < num_pieces; ++p_idx)
+      {
+        const auto& ep = embedded_font.pieces[p_idx];
+        font_char.font_pieces.push_back({ ep.part, ep.r, ep.c, ep.fg, ep.bg, ep.prio });
+      }
+      auto ch = static_cast<char>(efc.ch);
+      if (efc.ch_prev == -1)
+        font_data.font_chars[ch] = std::move(font_char);
+      else
+        font_data.font_chars_by_prev_char[{ static_cast<char>(efc.ch_prev), ch }] = std::move(font_char);
+    }
+    for (const auto& ek : embedded_font.kernings)
+      font_data.kernings[{ static_cast<char>(ek.ch0), static_cast<char>(ek.ch1) }] = ek.kerning;
+    for (const auto& eo : embedded_font.orderings)
+      font_data.orderings[{ static_cast<char>(eo.ch0), static_cast<char>(eo.ch1) }] = { eo.prio0, eo.prio1 };
+    font_data.treat_lower_case_as_upper_case = embedded_font.treat_lower_case_as_upper_case;
+    return font_data;
+  }
 
   Color get_fg_color(const std::string& col_type, const ColorScheme& colors)
   {
@@ -555,5 +633,334 @@ namespace t8x
     }
     return -1;
   }
+  
+  // FontData is convenient to load and edit but draw_text() with FontData does several
+  //   map lookups per char and sorts the text on every call. A CompiledFont keeps the
+  //   same data in direct tables indexed by char, and a TextLayoutCache keeps the laid
+  //   out pieces of each (font, text) so that banners redrawn every frame are just blitted.
+  
+  // Color role of a font piece, resolved once instead of comparing strings at every draw.
+  enum class FontColorType : uint8_t
+  {
+    T,
+    T2,
+    I,
+    SH,
+    SV,
+    DI,
+    DSH,
+    DSV,
+  };
+  
+  inline FontColorType parse_font_color_type(const std::string& col_type)
+  {
+    static const std::map<std::string, FontColorType> types
+    {
+      { "T", FontColorType::T }, { "T2", FontColorType::T2 }, { "I", FontColorType::I },
+      { "SH", FontColorType::SH }, { "SV", FontColorType::SV }, { "DI", FontColorType::DI },
+      { "DSH", FontColorType::DSH }, { "DSV", FontColorType::DSV },
+    };
+    auto it = types.find(col_type);
+    return it != types.end() ? it->second : FontColorType::T;
+  }
+  
+  inline Color get_fg_color(FontColorType col_type, const ColorScheme& colors)
+  {
+    switch (col_type)
+    {
+      case FontColorType::T: return Color16::Transparent;
+      case FontColorType::T2: return Color16::Transparent2;
+      case FontColorType::I: return colors.internal.fg_color;
+      case FontColorType::SH: return colors.side_h.fg_color;
+      case FontColorType::SV: return colors.side_v.fg_color;
+      case FontColorType::DI: return colors.dot_internal.fg_color;
+      case FontColorType::DSH: return colors.dot_side_h.fg_color;
+      case FontColorType::DSV: return colors.dot_side_v.fg_color;
+    }
+    return Color16::Transparent;
+  }
+  
+  inline Color get_bg_color(FontColorType col_type, const ColorScheme& colors)
+  {
+    switch (col_type)
+    {
+      case FontColorType::T: return Color16::Transparent;
+      case FontColorType::T2: return Color16::Transparent2;
+      case FontColorType::I: return colors.internal.bg_color;
+      case FontColorType::SH: return colors.side_h.bg_color;
+      case FontColorType::SV: return colors.side_v.bg_color;
+      case FontColorType::DI: return colors.dot_internal.bg_color;
+      case FontColorType::DSH: return colors.dot_side_h.bg_color;
+      case FontColorType::DSV: return colors.dot_side_v.bg_color;
+    }
+    return Color16::Transparent;
+  }
+  
+  // Table over ordered char pairs. Only the first chars that occur get a dense row of 256
+  //   entries, so a lookup is two array indexings and the tables stay small.
+  template<typename T>
+  class FontPairTable
+  {
+    std::array<int16_t, 256> m_row_idx;
+    std::vector<std::array<T, 256>> m_rows;
+    T m_none {};
+    
+    static int to_idx(char ch) { return static_cast<unsigned char>(ch); }
+    
+  public:
+    FontPairTable(T none = {})
+      : m_none(none)
+    {
+      m_row_idx.fill(-1);
+    }
+    
+    void set(char ch0, char ch1, T val)
+    {
+      auto& row_idx = m_row_idx[to_idx(ch0)];
+      if (row_idx == -1)
+      {
+        row_idx = static_cast<int16_t>(m_rows.size());
+        m_rows.emplace_back().fill(m_none);
+      }
+      m_rows[row_idx][to_idx(ch1)] = val;
+    }
+    
+    const T& get(char ch0, char ch1) const
+    {
+      auto row_idx = m_row_idx[to_idx(ch0)];
+      return row_idx == -1 ? m_none : m_rows[row_idx][to_idx(ch1)];
+    }
+  };
+  
+  struct CompiledFontPiece
+  {
+    std::string part;
+    int r = 0;
+    int c = 0;
+    FontColorType fg = FontColorType::T;
+    FontColorType bg = FontColorType::T;
+    int prio = 0;
+  };
+  
+  struct CompiledFontChar
+  {
+    int piece_start = 0;
+    int num_pieces = 0;
+    int width = -1;
+  };
+  
+  // Pieces relative to the top left corner of the text.
+  struct TextLayoutPiece
+  {
+    std::string part;
+    int r = 0;
+    int c = 0;
+    FontColorType fg = FontColorType::T;
+    FontColorType bg = FontColorType::T;
+    int priority = 0;
+  };
+  
+  // pieces are sorted in drawing order (descending priority).
+  struct TextLayout
+  {
+    std::vector<TextLayoutPiece> pieces;
+    int width = 0;
+  };
+  
+  class CompiledFont
+  {
+  public:
+    static constexpr int c_no_kerning = std::numeric_limits<int>::min();
+    
+  private:
+    std::vector<CompiledFontPiece> m_pieces;
+    std::vector<CompiledFontChar> m_chars;
+    std::array<int16_t, 256> m_char_idx;
+    FontPairTable<int16_t> m_char_by_prev_char_idx { -1 }; // { ch_prev, ch_curr }.
+    FontPairTable<int> m_kernings { c_no_kerning };
+    FontPairTable<int> m_ordering_diffs { 0 };
+    bool m_treat_lower_case_as_upper_case = false;
+    
+    int16_t add_char(const FontChar& font_char)
+    {
+      CompiledFontChar cfc;
+      cfc.piece_start = stlutils::sizeI(m_pieces);
+      cfc.num_pieces = stlutils::sizeI(font_char.font_pieces);
+      cfc.width = font_char.width;
+      for (const auto& piece : font_char.font_pieces)
+      {
+        m_pieces.push_back({ piece.part, piece.r, piece.c,
+          parse_font_color_type(piece.fg), parse_font_color_type(piece.bg),
+          piece.prio });
+      }
+      m_chars.emplace_back(cfc);
+      return static_cast<int16_t>(m_chars.size() - 1);
+    }
+    
+  public:
+    CompiledFont()
+    {
+      m_char_idx.fill(-1);
+    }
+    
+    explicit CompiledFont(const FontData& font_data)
+    {
+      m_char_idx.fill(-1);
+      for (const auto& [ch, font_char] : font_data.font_chars)
+        m_char_idx[static_cast<unsigned char>(ch)] = add_char(font_char);
+      for (const auto& [chars, font_char] : font_data.font_chars_by_prev_char)
+        m_char_by_prev_char_idx.set(chars.first, chars.second, add_char(font_char));
+      for (const auto& [chars, kerning] : font_data.kernings)
+        m_kernings.set(chars.first, chars.second, kerning);
+      for (const auto& [chars, prios] : font_data.orderings)
+        m_ordering_diffs.set(chars.first, chars.second, prios.second - prios.first);
+      m_treat_lower_case_as_upper_case = font_data.treat_lower_case_as_upper_case;
+    }
+    
+    // Contextual glyphs take precedence. nullptr if the char isn't part of the font.
+    const CompiledFontChar* find_char(char ch_prev, char ch_curr) const
+    {
+      auto idx = m_char_by_prev_char_idx.get(ch_prev, ch_curr);
+      if (idx == -1)
+        idx = m_char_idx[static_cast<unsigned char>(ch_curr)];
+      return idx == -1 ? nullptr : &m_chars[idx];
+    }
+    
+    // c_no_kerning if there is no kerning for the pair.
+    int get_kerning(char ch_curr, char ch_next) const { return m_kernings.get(ch_curr, ch_next); }
+    
+    int get_ordering_diff(char ch_prev, char ch_curr) const { return m_ordering_diffs.get(ch_prev, ch_curr); }
+    
+    const CompiledFontPiece& get_piece(int piece_idx) const { return m_pieces[piece_idx]; }
+    
+    bool treat_lower_case_as_upper_case() const { return m_treat_lower_case_as_upper_case; }
+    
+    // Same placement, width and priorities as draw_text() / calc_text_width() with FontData.
+    void layout_text(const std::string& text, const std::vector<int>& custom_kerning,
+                     TextLayout& layout) const
+    {
+      layout.pieces.clear();
+      layout.width = 0;
+      
+      auto f_case = [this](char ch) { return m_treat_lower_case_as_upper_case ? str::to_upper(ch) : ch; };
+      
+      const int num_chars = stlutils::sizeI(text);
+      const int num_custom_kernings = stlutils::sizeI(custom_kerning);
+      int curr_prio = 0;
+      for (int ch_idx = 0; ch_idx < num_chars; ++ch_idx)
+      {
+        char ch_prev = f_case(ch_idx - 1 >= 0 ? text[ch_idx - 1] : -1);
+        char ch_curr = f_case(text[ch_idx]);
+        char ch_next = f_case(ch_idx + 1 < num_chars ? text[ch_idx + 1] : -1);
+        
+        if (ch_idx > 0)
+          curr_prio += get_ordering_diff(ch_prev, ch_curr);
+        
+        const auto* curr_char = find_char(ch_prev, ch_curr);
+        if (curr_char == nullptr)
+        {
+          std::cerr << "Warning: Unrecognized character '" << ch_curr << "'" << std::endl;
+          continue;
+        }
+        
+        for (int p_idx = 0; p_idx < curr_char->num_pieces; ++p_idx)
+        {
+          const auto& piece = m_pieces[curr_char->piece_start + p_idx];
+          layout.pieces.push_back({ piece.part, piece.r, layout.width + piece.c,
+            piece.fg, piece.bg, curr_prio + piece.prio });
+        }
+        
+        int kerning = 0;
+        if (ch_next != -1)
+        {
+          auto k = get_kerning(ch_curr, ch_next);
+          if (k != c_no_kerning)
+            kerning = k + (ch_idx < num_custom_kernings ? custom_kerning[ch_idx] : 0);
+        }
+        layout.width += curr_char->width + kerning;
+      }
+      
+      std::stable_sort(layout.pieces.begin(), layout.pieces.end(),
+                       [](const auto& pA, const auto& pB) { return pA.priority > pB.priority; });
+    }
+  };
+  
+  using CompiledFontColl = std::map<Font, CompiledFont>;
+  
+  inline CompiledFontColl compile_font_data(const FontDataColl& font_data)
+  {
+    CompiledFontColl compiled_fonts;
+    for (const auto& [font, data] : font_data)
+      compiled_fonts.emplace(font, CompiledFont { data });
+    return compiled_fonts;
+  }
+  
+  // (r, c) : top left corner of text.
+  // Unlike draw_text() with FontData, the pieces are written directly in their precomputed
+  //   order, so texts queued with ScreenHandler::add_ordered_text() are not flushed.
+  template<int NR, int NC, typename CharT>
+  void draw_text_layout(ScreenHandler<NR, NC, CharT>& sh, const TextLayout& layout, const ColorScheme& colors,
+                        int r, int c)
+  {
+    for (const auto& piece : layout.pieces)
+      sh.write_buffer(piece.part, r + piece.r, c + piece.c,
+                      get_fg_color(piece.fg, colors), get_bg_color(piece.bg, colors));
+  }
+  
+  // Laid out texts per (font, text, custom kerning). Title and score banners are typically
+  //   drawn with the same text every frame, so only the first draw does any layout work.
+  // Returned layouts stay valid until the cache is cleared, which happens automatically
+  //   when max_entries is reached (e.g. for an ever increasing score).
+  class TextLayoutCache
+  {
+    std::map<std::tuple<Font, std::string, std::vector<int>>, TextLayout, std::less<>> m_layouts;
+    size_t m_max_entries = 256;
+    
+  public:
+    TextLayoutCache(size_t max_entries = 256)
+      : m_max_entries(std::max<size_t>(1, max_entries))
+    {}
+    
+    // nullptr if font isn't part of compiled_fonts.
+    const TextLayout* get(const CompiledFontColl& compiled_fonts, Font font, const std::string& text,
+                          const std::vector<int>& custom_kerning = {})
+    {
+      auto it = m_layouts.find(std::forward_as_tuple(font, text, custom_kerning));
+      if (it != m_layouts.end())
+        return &it->second;
+      
+      auto it_font = compiled_fonts.find(font);
+      if (it_font == compiled_fonts.end())
+        return nullptr;
+      
+      if (m_layouts.size() >= m_max_entries)
+        m_layouts.clear();
+      auto& layout = m_layouts[{ font, text, custom_kerning }];
+      it_font->second.layout_text(text, custom_kerning, layout);
+      return &layout;
+    }
+    
+    size_t size() const { return m_layouts.size(); }
+    void clear() { m_layouts.clear(); }
+  };
+  
+  // (r, c) : top left corner of text.
+  template<int NR, int NC, typename CharT>
+  void draw_text(ScreenHandler<NR, NC, CharT>& sh, TextLayoutCache& layout_cache,
+                 const CompiledFontColl& compiled_fonts, const ColorScheme& colors,
+                 const std::string& text,
+                 int r, int c, Font font, const std::vector<int>& custom_kerning = {})
+  {
+    const auto* layout = layout_cache.get(compiled_fonts, font, text, custom_kerning);
+    if (layout != nullptr)
+      draw_text_layout(sh, *layout, colors, r, c);
+  }
+  
+  inline int calc_text_width(TextLayoutCache& layout_cache, const CompiledFontColl& compiled_fonts,
+                      const std::string& text, Font font, const std::vector<int>& custom_kerning = {})
+  {
+    const auto* layout = layout_cache.get(compiled_fonts, font, text, custom_kerning);
+    return layout != nullptr ? layout->width : -1;
+  }
 
 }